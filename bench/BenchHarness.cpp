@@ -0,0 +1,219 @@
+#include "BenchHarness.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace ui::bench {
+
+namespace {
+
+double Median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t mid = values.size() / 2;
+    return (values.size() % 2 == 1) ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+// Extract a numeric field from one JSON object line written by WriteJson
+bool ReadNumber(const std::string& line, const char* key, double& out) {
+    const std::string pattern = std::string("\"") + key + "\":";
+    const std::size_t pos = line.find(pattern);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    out = std::strtod(line.c_str() + pos + pattern.size(), nullptr);
+    return true;
+}
+
+bool ReadString(const std::string& line, const char* key, std::string& out) {
+    const std::string pattern = std::string("\"") + key + "\":\"";
+    const std::size_t pos = line.find(pattern);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    const std::size_t begin = pos + pattern.size();
+    const std::size_t end = line.find('"', begin);
+    if (end == std::string::npos) {
+        return false;
+    }
+    out = line.substr(begin, end - begin);
+    return true;
+}
+
+BenchResult RunCase(const BenchDefinition& def, const BenchParams& params, const RunOptions& options) {
+    BenchIteration iteration = def.factory(params);
+
+    // Warm-up: first touch of storage, caches, allocator pools
+    iteration();
+
+    std::vector<double> nsPerOp;
+    std::vector<double> msPerIteration;
+    std::uint64_t ops = 0;
+    std::chrono::nanoseconds total{0};
+
+    while (nsPerOp.size() < options.maxIterations &&
+           (nsPerOp.size() < options.minIterations || total < options.minTime)) {
+        const BenchSample sample = iteration();
+        ops = sample.ops;
+        total += sample.elapsed;
+        const double ns = static_cast<double>(sample.elapsed.count());
+        nsPerOp.push_back(sample.ops > 0 ? ns / static_cast<double>(sample.ops) : ns);
+        msPerIteration.push_back(ns / 1.0e6);
+    }
+
+    BenchResult result;
+    result.name = def.name;
+    result.params = params;
+    result.iterations = nsPerOp.size();
+    result.opsPerIteration = ops;
+    result.nsPerOpMedian = Median(nsPerOp);
+    result.nsPerOpMin = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+    result.nsPerOpMax = *std::max_element(nsPerOp.begin(), nsPerOp.end());
+    result.msPerIterationMedian = Median(msPerIteration);
+    return result;
+}
+
+} // namespace
+
+std::string BenchResult::Key() const {
+    std::ostringstream key;
+    key << name << "/nodes=" << params.nodes << "/dirty=" << std::fixed << std::setprecision(3)
+        << params.dirtyRatio;
+    return key.str();
+}
+
+void BenchRegistry::Register(std::string name, BenchFactory factory, bool usesDirtyRatio) {
+    m_definitions.push_back(BenchDefinition{std::move(name), std::move(factory), usesDirtyRatio});
+}
+
+std::vector<std::size_t> PickIndices(std::size_t count, double ratio) {
+    const std::size_t picked = std::min(count, static_cast<std::size_t>(static_cast<double>(count) * ratio + 0.5));
+    std::vector<std::size_t> indices;
+    indices.reserve(picked);
+    for (std::size_t i = 0; i < picked; ++i) {
+        indices.push_back(i * count / picked);
+    }
+    return indices;
+}
+
+std::vector<BenchResult> RunAll(const BenchRegistry& registry, const RunOptions& options) {
+    std::vector<BenchResult> results;
+
+    for (const BenchDefinition& def : registry.All()) {
+        if (!options.filter.empty() && def.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+
+        for (std::size_t nodes : options.sizes) {
+            const std::vector<double> ratios =
+                def.usesDirtyRatio ? options.dirtyRatios : std::vector<double>{1.0};
+            for (double ratio : ratios) {
+                const BenchResult result = RunCase(def, BenchParams{nodes, ratio}, options);
+                std::cout << std::left << std::setw(48) << result.Key() << std::right
+                          << std::fixed << std::setprecision(2)
+                          << std::setw(12) << result.nsPerOpMedian << " ns/op"
+                          << std::setw(12) << result.msPerIterationMedian << " ms/iter"
+                          << "  (" << result.iterations << " iters)" << std::endl;
+                results.push_back(result);
+            }
+        }
+    }
+
+    return results;
+}
+
+bool WriteJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    // One object per line keeps ReadJson trivial
+    out << "{ \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "{\"name\":\"" << r.name << "\","
+            << "\"nodes\":" << r.params.nodes << ","
+            << "\"dirty_ratio\":" << r.params.dirtyRatio << ","
+            << "\"iterations\":" << r.iterations << ","
+            << "\"ops_per_iteration\":" << r.opsPerIteration << ","
+            << "\"ns_per_op_median\":" << r.nsPerOpMedian << ","
+            << "\"ns_per_op_min\":" << r.nsPerOpMin << ","
+            << "\"ns_per_op_max\":" << r.nsPerOpMax << ","
+            << "\"ms_per_iteration_median\":" << r.msPerIterationMedian << "}";
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "] }\n";
+    return true;
+}
+
+bool ReadJson(const std::string& path, std::vector<BenchResult>& results) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        BenchResult r;
+        double nodes = 0.0;
+        double iterations = 0.0;
+        double ops = 0.0;
+        if (!ReadString(line, "name", r.name) || !ReadNumber(line, "nodes", nodes) ||
+            !ReadNumber(line, "dirty_ratio", r.params.dirtyRatio) ||
+            !ReadNumber(line, "ns_per_op_median", r.nsPerOpMedian)) {
+            continue;
+        }
+        r.params.nodes = static_cast<std::size_t>(nodes);
+        ReadNumber(line, "iterations", iterations);
+        ReadNumber(line, "ops_per_iteration", ops);
+        ReadNumber(line, "ns_per_op_min", r.nsPerOpMin);
+        ReadNumber(line, "ns_per_op_max", r.nsPerOpMax);
+        ReadNumber(line, "ms_per_iteration_median", r.msPerIterationMedian);
+        r.iterations = static_cast<std::size_t>(iterations);
+        r.opsPerIteration = static_cast<std::uint64_t>(ops);
+        results.push_back(r);
+    }
+    return true;
+}
+
+std::size_t Compare(const std::vector<BenchResult>& baseline,
+                    const std::vector<BenchResult>& current,
+                    double threshold) {
+    std::unordered_map<std::string, const BenchResult*> byKey;
+    for (const BenchResult& r : baseline) {
+        byKey[r.Key()] = &r;
+    }
+
+    std::size_t regressions = 0;
+    for (const BenchResult& r : current) {
+        auto it = byKey.find(r.Key());
+        if (it == byKey.end() || it->second->nsPerOpMedian <= 0.0) {
+            std::cout << std::left << std::setw(48) << r.Key() << std::right << "  (no baseline)" << std::endl;
+            continue;
+        }
+
+        const double base = it->second->nsPerOpMedian;
+        const double delta = (r.nsPerOpMedian - base) / base;
+        const bool regressed = delta > threshold;
+        regressions += regressed ? 1 : 0;
+
+        std::cout << std::left << std::setw(48) << r.Key() << std::right
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(12) << base << " ->"
+                  << std::setw(12) << r.nsPerOpMedian << " ns/op"
+                  << std::setw(9) << std::showpos << delta * 100.0 << std::noshowpos << "%"
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+
+    return regressions;
+}
+
+} // namespace ui::bench
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ui::bench {
+
+// Parameters of one benchmark case
+struct BenchParams {
+    std::size_t nodes = 0;     // scene / container size
+    double dirtyRatio = 1.0;   // fraction of nodes touched per iteration
+};
+
+// One measured iteration: time spent in the measured region and the
+// number of operations it covered (for ns/op)
+struct BenchSample {
+    std::chrono::nanoseconds elapsed{0};
+    std::uint64_t ops = 0;
+};
+
+// A factory prepares state for the given params (not measured) and returns
+// the callable that runs one iteration. Untimed per-iteration setup and
+// teardown live inside the iteration; only the region passed to Measure()
+// is reported.
+using BenchIteration = std::function<BenchSample()>;
+using BenchFactory = std::function<BenchIteration(const BenchParams&)>;
+
+struct BenchDefinition {
+    std::string name;
+    BenchFactory factory;
+    bool usesDirtyRatio = true;  // false: run once per size at ratio 1.0
+};
+
+struct BenchResult {
+    std::string name;
+    BenchParams params;
+    std::size_t iterations = 0;
+    std::uint64_t opsPerIteration = 0;
+    double nsPerOpMedian = 0.0;
+    double nsPerOpMin = 0.0;
+    double nsPerOpMax = 0.0;
+    double msPerIterationMedian = 0.0;
+
+    // Stable key used to match results across runs
+    std::string Key() const;
+};
+
+struct RunOptions {
+    std::vector<std::size_t> sizes{1000, 10000, 100000, 1000000};
+    std::vector<double> dirtyRatios{0.01, 0.1, 1.0};
+    std::string filter;  // substring match on benchmark name
+    std::chrono::milliseconds minTime{200};
+    std::size_t minIterations = 3;
+    std::size_t maxIterations = 200;
+};
+
+class BenchRegistry {
+public:
+    void Register(std::string name, BenchFactory factory, bool usesDirtyRatio = true);
+    const std::vector<BenchDefinition>& All() const { return m_definitions; }
+
+private:
+    std::vector<BenchDefinition> m_definitions;
+};
+
+// Time a region with steady_clock
+template <class F>
+std::chrono::nanoseconds Measure(F&& fn) {
+    const auto begin = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+}
+
+// Keeps the optimizer from discarding a computed value
+template <class T>
+void DoNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Evenly spaced subset of `count * ratio` indices in [0, count)
+std::vector<std::size_t> PickIndices(std::size_t count, double ratio);
+
+std::vector<BenchResult> RunAll(const BenchRegistry& registry, const RunOptions& options);
+
+bool WriteJson(const std::string& path, const std::vector<BenchResult>& results);
+bool ReadJson(const std::string& path, std::vector<BenchResult>& results);
+
+// Print a comparison table; returns the number of cases slower than
+// baseline by more than `threshold` (0.10 = 10%)
+std::size_t Compare(const std::vector<BenchResult>& baseline,
+                    const std::vector<BenchResult>& current,
+                    double threshold);
+
+// Benchmark groups
+void RegisterCoreBenchmarks(BenchRegistry& registry);
+
+} // namespace ui::bench
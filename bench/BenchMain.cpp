@@ -0,0 +1,121 @@
+#include "BenchHarness.h"
+#include "ContentionBench.h"
+#include "JobSystem.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+void PrintUsage() {
+    std::cout
+        << "Usage:\n"
+        << "  ui_bench [--out results.json] [--filter name] [--sizes 1000,10000]\n"
+        << "           [--dirty 0.01,0.1,1] [--min-time-ms 200] [--quick]\n"
+        << "           [--workers N]\n"
+        << "  ui_bench --compare baseline.json current.json [--threshold 0.10]\n"
+        << "  ui_bench --scenario contention [--out file.json] [--duration-ms 1000] [--sizes 10000]\n";
+}
+
+template <class T>
+std::vector<T> ParseList(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(static_cast<T>(std::strtod(item.c_str(), nullptr)));
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ui::bench::RunOptions options;
+    std::string outPath;
+    std::string scenario;
+    std::chrono::milliseconds scenarioDuration{1000};
+    std::string comparePaths[2];
+    bool compare = false;
+    double threshold = 0.10;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--sizes" && hasValue) {
+            options.sizes = ParseList<std::size_t>(argv[++i]);
+        } else if (arg == "--dirty" && hasValue) {
+            options.dirtyRatios = ParseList<double>(argv[++i]);
+        } else if (arg == "--min-time-ms" && hasValue) {
+            options.minTime = std::chrono::milliseconds(std::atoi(argv[++i]));
+        } else if (arg == "--workers" && hasValue) {
+            ui::JobSystem::SetDefaultWorkerCount(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--quick") {
+            options.sizes = {1000, 10000};
+            options.minTime = std::chrono::milliseconds(50);
+        } else if (arg == "--compare" && i + 2 < argc) {
+            compare = true;
+            comparePaths[0] = argv[++i];
+            comparePaths[1] = argv[++i];
+        } else if (arg == "--scenario" && hasValue) {
+            scenario = argv[++i];
+        } else if (arg == "--duration-ms" && hasValue) {
+            scenarioDuration = std::chrono::milliseconds(std::atoi(argv[++i]));
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = std::strtod(argv[++i], nullptr);
+        } else {
+            PrintUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    if (compare) {
+        std::vector<ui::bench::BenchResult> baseline;
+        std::vector<ui::bench::BenchResult> current;
+        if (!ui::bench::ReadJson(comparePaths[0], baseline) || !ui::bench::ReadJson(comparePaths[1], current)) {
+            std::cerr << "Failed to read benchmark results" << std::endl;
+            return 2;
+        }
+        const std::size_t regressions = ui::bench::Compare(baseline, current, threshold);
+        std::cout << regressions << " regression(s) beyond " << threshold * 100.0 << "%" << std::endl;
+        return regressions == 0 ? 0 : 1;
+    }
+
+    if (scenario == "contention") {
+        ui::bench::ContentionOptions contention;
+        contention.duration = scenarioDuration;
+        if (options.sizes.size() == 1) {
+            contention.sceneNodes = options.sizes.front();
+        }
+        if (!outPath.empty()) {
+            contention.outPath = outPath;
+        }
+        return ui::bench::RunContentionScenario(contention);
+    } else if (!scenario.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    if (outPath.empty()) {
+        outPath = "bench_results.json";
+    }
+
+    ui::bench::BenchRegistry registry;
+    ui::bench::RegisterCoreBenchmarks(registry);
+
+    const auto results = ui::bench::RunAll(registry, options);
+    if (!ui::bench::WriteJson(outPath, results)) {
+        std::cerr << "Failed to write " << outPath << std::endl;
+        return 2;
+    }
+    std::cout << "Wrote " << results.size() << " results to " << outPath << std::endl;
+    return 0;
+}
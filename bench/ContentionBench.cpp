@@ -0,0 +1,154 @@
+#include "ContentionBench.h"
+
+#include "FrameScheduler.h"
+#include "RenderCommands.h"
+#include "RenderContext.h"
+#include "StressScene.h"
+#include "TraceProfiler.h"
+#include "WaitHistogram.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace ui::bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ContentionResult {
+    double syncCostMs = 0.0;
+    double traversalCostMs = 0.0;
+    double updateHz = 0.0;
+    double renderHz = 0.0;
+    std::size_t updateFrames = 0;
+    std::size_t renderFrames = 0;
+    std::size_t updateMissed = 0;
+    std::size_t renderMissed = 0;
+};
+
+Clock::duration ToDuration(double ms) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+}
+
+// Deadline-paced loop; overrunning frames skip to the next slot
+template <class Frame>
+void RunPaced(double hz, const std::atomic<bool>& stop, std::size_t& frames, std::size_t& missed, Frame&& frame) {
+    FrameSchedulerConfig config;
+    config.hz = hz;
+    config.policy = MissPolicy::Skip;
+    FrameScheduler scheduler(config);
+    while (!stop) {
+        frame();
+        ++frames;
+        scheduler.WaitForNextFrame();
+    }
+    missed = static_cast<std::size_t>(scheduler.MissedDeadlines());
+}
+
+void WriteHistogram(std::ofstream& out, const WaitHistogram& histogram) {
+    out << "[";
+    for (std::size_t i = 0; i < WaitHistogram::kBucketCount; ++i) {
+        out << (i ? "," : "") << histogram.BucketCount(i);
+    }
+    out << "]";
+}
+
+void WriteResult(std::ofstream& out, const ContentionResult& r, const WaitHistogram& updateWaits,
+                 const WaitHistogram& renderWaits) {
+    out << "{\"sync_ms\":" << r.syncCostMs
+        << ",\"traversal_ms\":" << r.traversalCostMs
+        << ",\"update_hz\":" << r.updateHz
+        << ",\"render_hz\":" << r.renderHz
+        << ",\"update_frames\":" << r.updateFrames
+        << ",\"render_frames\":" << r.renderFrames
+        << ",\"update_missed\":" << r.updateMissed
+        << ",\"render_missed\":" << r.renderMissed
+        << ",\"update_wait_max_us\":" << updateWaits.Max().count() / 1000
+        << ",\"update_wait_p99_us\":" << updateWaits.PercentileUpperBoundUs(99.0)
+        << ",\"render_wait_max_us\":" << renderWaits.Max().count() / 1000
+        << ",\"render_wait_p99_us\":" << renderWaits.PercentileUpperBoundUs(99.0)
+        << ",\"update_wait_hist\":";
+    WriteHistogram(out, updateWaits);
+    out << ",\"render_wait_hist\":";
+    WriteHistogram(out, renderWaits);
+    out << "}";
+}
+
+} // namespace
+
+int RunContentionScenario(const ContentionOptions& options) {
+    auto& ctx = RenderContext::Instance();
+
+    StressConfig sceneConfig;
+    sceneConfig.nodeCount = options.sceneNodes;
+    sceneConfig.mutationRate = 0.05;
+    StressScene scene(sceneConfig);
+    ctx.Sync();
+
+    std::ofstream out(options.outPath, std::ios::trunc);
+    out << "{ \"contention\": [\n";
+    bool first = true;
+
+    for (const auto& [updateHz, renderHz] : options.rates) {
+        for (double syncMs : options.syncCostsMs) {
+            for (double traversalMs : options.traversalCostsMs) {
+                ContentionResult result;
+                result.syncCostMs = syncMs;
+                result.traversalCostMs = traversalMs;
+                result.updateHz = updateHz;
+                result.renderHz = renderHz;
+
+                ctx.SetSimulatedSyncCost(std::chrono::duration_cast<std::chrono::microseconds>(ToDuration(syncMs)));
+                ctx.SyncLockWaits().Reset();
+                ctx.RenderLockWaits().Reset();
+
+                std::atomic<bool> stop{false};
+                std::thread updateThread([&]() {
+                    TraceProfiler::Instance().RegisterThread("contention_update");
+                    RunPaced(updateHz, stop, result.updateFrames, result.updateMissed, [&]() {
+                        scene.Mutate();
+                        ctx.Sync();
+                    });
+                });
+                std::thread renderThread([&]() {
+                    TraceProfiler::Instance().RegisterThread("contention_render");
+                    RenderCommandList commands;
+                    const Clock::duration traversalCost = ToDuration(traversalMs);
+                    RunPaced(renderHz, stop, result.renderFrames, result.renderMissed, [&]() {
+                        auto lock = ctx.LockForRender();
+                        CollectRenderCommands(ctx, scene.RootId(), commands);
+                        if (traversalCost > Clock::duration::zero()) {
+                            std::this_thread::sleep_for(traversalCost);
+                        }
+                    });
+                });
+
+                std::this_thread::sleep_for(options.duration);
+                stop = true;
+                updateThread.join();
+                renderThread.join();
+
+                std::cout << "update " << updateHz << " Hz / render " << renderHz << " Hz, sync "
+                          << syncMs << " ms, traversal +" << traversalMs << " ms: "
+                          << result.updateFrames << " updates (" << result.updateMissed << " missed), "
+                          << result.renderFrames << " renders (" << result.renderMissed << " missed)\n"
+                          << "  " << ctx.SyncLockWaits().Format("update wait (Sync)")
+                          << "  " << ctx.RenderLockWaits().Format("render wait (Render)") << std::endl;
+
+                out << (first ? "" : ",\n");
+                first = false;
+                WriteResult(out, result, ctx.SyncLockWaits(), ctx.RenderLockWaits());
+            }
+        }
+    }
+
+    out << "\n] }\n";
+    ctx.SetSimulatedSyncCost(std::chrono::microseconds(0));
+    std::cout << "Wrote " << options.outPath << std::endl;
+    return 0;
+}
+
+} // namespace ui::bench
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ui::bench {
+
+// Update/render handoff scenario: measures how long each side blocks on
+// the render mutex across a matrix of Sync cost, traversal cost and rates
+struct ContentionOptions {
+    std::vector<double> syncCostsMs{0.0, 2.0, 8.0};       // simulated Sync work under the mutex
+    std::vector<double> traversalCostsMs{0.0, 2.0, 8.0};  // extra render work under the mutex
+    std::vector<std::pair<double, double>> rates{{60.0, 60.0}, {30.0, 120.0}};  // (update Hz, render Hz)
+    std::size_t sceneNodes = 10000;
+    std::chrono::milliseconds duration{1000};  // per configuration
+    std::string outPath = "contention_results.json";
+};
+
+int RunContentionScenario(const ContentionOptions& options);
+
+} // namespace ui::bench
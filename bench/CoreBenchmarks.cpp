@@ -0,0 +1,595 @@
+#include "BenchHarness.h"
+
+#include "ChangeBuffer.h"
+#include "ChangeCapture.h"
+#include "FrontendNodes.h"
+#include "JobSystem.h"
+#include "NodeData.h"
+#include "NodeIdAllocator.h"
+#include "RenderCommands.h"
+#include "RenderContext.h"
+#include "StressScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace ui::bench {
+
+namespace {
+
+constexpr std::size_t kFanout = 16;
+constexpr std::size_t kGridFanout = 4096;  // wide "grid" rows for traversal benchmarks
+
+// Scrolling list: rows of kListRowLength 8x8 rects on a kListCell grid,
+// one container per row, viewed through an 800x600 window at the origin
+constexpr std::size_t kListRowLength = 64;
+constexpr float kListCell = 12.0f;
+
+enum class BenchLayout {
+    Scattered,  // positions wrap around an 800x600 area
+    Rows        // leaf i in row i / fanout, so containers are spatially compact
+};
+
+// Balanced container tree with `leafCount` leaves (every 4th leaf is text,
+// the rest are rects; Rows layout: rects only), built through the
+// RenderContext write API and synced.
+// Deletes all of its nodes on destruction so the next case starts clean.
+class BenchScene {
+public:
+    explicit BenchScene(std::size_t leafCount, std::size_t fanout = kFanout,
+                        BenchLayout layout = BenchLayout::Scattered) {
+        auto& ctx = RenderContext::Instance();
+
+        std::vector<NodeId> level;
+        level.reserve(leafCount);
+        for (std::size_t i = 0; i < leafCount; ++i) {
+            const NodeId id = ctx.AllocateNodeId();
+            if (layout == BenchLayout::Rows) {
+                auto& rect = ctx.AccessData<ShapeRectNodeData>(id);
+                rect.x = static_cast<float>(i % fanout) * kListCell;
+                rect.y = static_cast<float>(i / fanout) * kListCell;
+                rect.width = 8.0f;
+                rect.height = 8.0f;
+                rect.dirtyFields |= kFieldPosition | kFieldWidth | kFieldHeight;
+                m_rects.push_back(id);
+            } else if (i % 4 == 3) {
+                auto& text = ctx.AccessData<TextNodeData>(id);
+                text.x = static_cast<float>(i % 800);
+                text.y = static_cast<float>(i % 600);
+                text.text = "label";
+                text.dirtyFields |= kFieldPosition | kFieldText;
+                m_texts.push_back(id);
+            } else {
+                TouchRect(id, 0);
+                m_rects.push_back(id);
+            }
+            level.push_back(id);
+        }
+
+        // Group each level under containers until a single root remains
+        do {
+            std::vector<NodeId> parents;
+            for (std::size_t begin = 0; begin < level.size(); begin += fanout) {
+                const NodeId id = ctx.AllocateNodeId();
+                auto& container = ctx.AccessData<ContainerNodeData>(id);
+                const std::size_t end = std::min(level.size(), begin + fanout);
+                container.children.assign(level.begin() + begin, level.begin() + end);
+                container.dirtyFields |= kFieldChildren;
+                m_containers.push_back(id);
+                parents.push_back(id);
+            }
+            level.swap(parents);
+        } while (level.size() > 1);
+        m_root = level.front();
+
+        ctx.Sync();
+    }
+
+    ~BenchScene() {
+        auto& ctx = RenderContext::Instance();
+        for (NodeId id : m_rects) {
+            ctx.AccessData<ShapeRectNodeData>(id).deleted = true;
+        }
+        for (NodeId id : m_texts) {
+            ctx.AccessData<TextNodeData>(id).deleted = true;
+        }
+        for (NodeId id : m_containers) {
+            ctx.AccessData<ContainerNodeData>(id).deleted = true;
+        }
+        ctx.Sync();
+    }
+
+    BenchScene(const BenchScene&) = delete;
+    BenchScene& operator=(const BenchScene&) = delete;
+
+    static void TouchRect(NodeId id, std::size_t frame) {
+        auto& rect = RenderContext::Instance().AccessData<ShapeRectNodeData>(id);
+        rect.x = static_cast<float>((ExtractIndex(id) + frame) % 800);
+        rect.y = static_cast<float>(ExtractIndex(id) % 600);
+        rect.width = 8.0f;
+        rect.height = 8.0f;
+        rect.dirtyFields |= kFieldPosition | kFieldWidth | kFieldHeight;
+    }
+
+    NodeId Root() const { return m_root; }
+    const std::vector<NodeId>& Rects() const { return m_rects; }
+
+private:
+    NodeId m_root = 0;
+    std::vector<NodeId> m_rects;
+    std::vector<NodeId> m_texts;
+    std::vector<NodeId> m_containers;
+};
+
+std::vector<NodeId> PickDirty(const std::vector<NodeId>& ids, double ratio) {
+    std::vector<NodeId> dirty;
+    for (std::size_t i : PickIndices(ids.size(), ratio)) {
+        dirty.push_back(ids[i]);
+    }
+    return dirty;
+}
+
+// Update thread: write-side access for a dirty subset of rects
+BenchIteration AccessDataBench(const BenchParams& params) {
+    auto scene = std::make_shared<BenchScene>(params.nodes);
+    auto dirty = std::make_shared<std::vector<NodeId>>(PickDirty(scene->Rects(), params.dirtyRatio));
+    auto frame = std::make_shared<std::size_t>(0);
+
+    return [scene, dirty, frame]() {
+        BenchSample sample;
+        sample.ops = dirty->size();
+        const std::size_t f = ++*frame;
+        sample.elapsed = Measure([&]() {
+            for (NodeId id : *dirty) {
+                BenchScene::TouchRect(id, f);
+            }
+        });
+        RenderContext::Instance().Sync();  // drain, not measured
+        return sample;
+    };
+}
+
+// Several producer threads: each job writes its slice into its worker's
+// change shard and publishes it; the merge happens in the (unmeasured) Sync
+BenchIteration AccessDataProducersBench(const BenchParams& params) {
+    auto scene = std::make_shared<BenchScene>(params.nodes);
+    auto dirty = std::make_shared<std::vector<NodeId>>(PickDirty(scene->Rects(), params.dirtyRatio));
+    auto frame = std::make_shared<std::size_t>(0);
+
+    return [scene, dirty, frame]() {
+        BenchSample sample;
+        sample.ops = dirty->size();
+        const std::size_t f = ++*frame;
+        sample.elapsed = Measure([&]() {
+            JobSystem::Instance().ParallelFor(0, dirty->size(), 4096, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    BenchScene::TouchRect((*dirty)[i], f);
+                }
+                RenderContext::Instance().PublishChanges();
+            });
+        });
+        RenderContext::Instance().Sync();  // drain, not measured
+        return sample;
+    };
+}
+
+// Change application: Sync with a dirty subset pending
+BenchIteration SyncBench(const BenchParams& params) {
+    auto scene = std::make_shared<BenchScene>(params.nodes);
+    auto dirty = std::make_shared<std::vector<NodeId>>(PickDirty(scene->Rects(), params.dirtyRatio));
+    auto frame = std::make_shared<std::size_t>(0);
+
+    return [scene, dirty, frame]() {
+        const std::size_t f = ++*frame;
+        for (NodeId id : *dirty) {
+            BenchScene::TouchRect(id, f);
+        }
+        BenchSample sample;
+        sample.ops = dirty->size();
+        sample.elapsed = Measure([]() { RenderContext::Instance().Sync(); });
+        return sample;
+    };
+}
+
+// Budgeted Sync: the dirty subset is written in one frame (a "transition")
+// and drained at most kSyncBudgetChanges per Sync; the next transition
+// starts once the backlog is empty
+constexpr std::size_t kSyncBudgetChanges = 1024;
+
+BenchIteration SyncBudgetedBench(const BenchParams& params) {
+    auto scene = std::make_shared<BenchScene>(params.nodes);
+    auto dirty = std::make_shared<std::vector<NodeId>>(PickDirty(scene->Rects(), params.dirtyRatio));
+    auto frame = std::make_shared<std::size_t>(0);
+
+    return [scene, dirty, frame]() {
+        const std::size_t f = ++*frame;
+        if (RenderContext::Instance().DeferredChanges() == 0) {
+            for (NodeId id : *dirty) {
+                BenchScene::TouchRect(id, f);
+            }
+        }
+        SyncBudget budget;
+        budget.maxChanges = kSyncBudgetChanges;
+        SyncResult result;
+        BenchSample sample;
+        sample.elapsed = Measure([&]() { result = RenderContext::Instance().Sync(budget); });
+        sample.ops = result.applied;
+        return sample;
+    };
+}
+
+// Render thread: full traversal of the synced tree
+BenchIteration CollectBench(const BenchParams& params, std::size_t fanout, CollectMode mode,
+                            BenchLayout layout = BenchLayout::Scattered,
+                            const Bounds& viewport = Bounds::Infinite()) {
+    auto scene = std::make_shared<BenchScene>(params.nodes, fanout, layout);
+    auto commands = std::make_shared<RenderCommandList>();
+
+    return [scene, commands, mode, viewport]() {
+        auto& ctx = RenderContext::Instance();
+        BenchSample sample;
+        sample.elapsed = Measure([&]() {
+            std::lock_guard<std::mutex> lock(ctx.RenderMutex());
+            CollectRenderCommands(ctx, scene->Root(), *commands, mode, viewport);
+        });
+        sample.ops = commands->size();
+        return sample;
+    };
+}
+
+BenchIteration CollectRenderCommandsBench(const BenchParams& params) {
+    return CollectBench(params, kFanout, CollectMode::Serial);
+}
+
+BenchIteration CollectGridBench(const BenchParams& params) {
+    return CollectBench(params, kGridFanout, CollectMode::Serial);
+}
+
+BenchIteration CollectGridParallelBench(const BenchParams& params) {
+    return CollectBench(params, kGridFanout, CollectMode::Parallel);
+}
+
+// Only the first screenful of the list is on screen; the rest is culled by row
+BenchIteration CollectListCulledBench(const BenchParams& params) {
+    return CollectBench(params, kListRowLength, CollectMode::Serial, BenchLayout::Rows,
+                        Bounds::FromRect(0.0f, 0.0f, 800.0f, 600.0f));
+}
+
+// Update side: a params.nodes-item virtualized list of text rows scrolled
+// by a few px per frame, then synced; ops = rows the pool holds (the cost
+// should not grow with the item count)
+BenchIteration VirtualListScrollBench(const BenchParams& params) {
+    constexpr float kRowExtent = 20.0f;
+    constexpr float kScrollStep = 7.0f;
+    VirtualListSource source;
+    source.create = [](RenderContext& ctx, NodeId id) -> std::unique_ptr<FrontendNode> {
+        return FrontendText::Create(ctx, id);
+    };
+    source.bind = [](std::size_t index, FrontendNode& node) {
+        static_cast<FrontendText&>(node).SetText("row " + std::to_string(index));
+    };
+    // Terms its rows on destruction; the next Sync applies that
+    std::shared_ptr<FrontendVirtualList> list(
+        FrontendVirtualList::Create(RenderContext::Instance().AllocateNodeId(), std::move(source)).release(),
+        [](FrontendVirtualList* done) {
+            delete done;
+            RenderContext::Instance().Sync();
+        });
+    list->SetItemExtent(kRowExtent);
+    list->SetViewportExtent(600.0f);
+    list->SetItemCount(params.nodes);
+    RenderContext::Instance().Sync();
+
+    return [list]() {
+        const float max = list->MaxScrollOffset();
+        const float next = list->ScrollOffset() + kScrollStep;
+        BenchSample sample;
+        sample.elapsed = Measure([&]() {
+            list->SetScrollOffset(next > max ? 0.0f : next);
+            RenderContext::Instance().Sync();
+        });
+        sample.ops = list->PoolSize();
+        return sample;
+    };
+}
+
+// Render thread: sort a tree-order command list of the mixed scene
+// (every 4th leaf text, so unsorted it would need a draw call per few rects)
+BenchIteration SortRenderCommandsBench(const BenchParams& params) {
+    auto scene = std::make_shared<BenchScene>(params.nodes);
+    auto treeOrder = std::make_shared<RenderCommandList>();
+    {
+        auto& ctx = RenderContext::Instance();
+        std::lock_guard<std::mutex> lock(ctx.RenderMutex());
+        CollectRenderCommands(ctx, scene->Root(), *treeOrder);
+    }
+    std::sort(treeOrder->begin(), treeOrder->end(), [](const RenderCommand& a, const RenderCommand& b) {
+        return static_cast<std::uint32_t>(a.sortKey) < static_cast<std::uint32_t>(b.sortKey);
+    });
+    auto commands = std::make_shared<RenderCommandList>();
+
+    return [scene, treeOrder, commands]() {
+        *commands = *treeOrder;
+        BenchSample sample;
+        sample.ops = commands->size();
+        sample.elapsed = Measure([&]() { SortRenderCommands(*commands); });
+        return sample;
+    };
+}
+
+// Event thread: hit-tests at random spots of the Rows layout (about one
+// rect under each point), against the index Sync maintains
+constexpr std::size_t kHitTestQueries = 4096;
+
+BenchIteration HitTestBench(const BenchParams& params, float queryExtent) {
+    auto scene = std::make_shared<BenchScene>(params.nodes, kListRowLength, BenchLayout::Rows);
+    const float width = static_cast<float>(kListRowLength) * kListCell;
+    const float height = static_cast<float>((params.nodes + kListRowLength - 1) / kListRowLength) * kListCell;
+
+    auto areas = std::make_shared<std::vector<Bounds>>();
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> px(0.0f, width);
+    std::uniform_real_distribution<float> py(0.0f, height);
+    for (std::size_t i = 0; i < kHitTestQueries; ++i) {
+        areas->push_back(Bounds::FromRect(px(rng), py(rng), queryExtent, queryExtent));
+    }
+    auto hits = std::make_shared<std::vector<NodeId>>();
+
+    return [scene, areas, hits, queryExtent]() {
+        auto& ctx = RenderContext::Instance();
+        BenchSample sample;
+        sample.ops = areas->size();
+        sample.elapsed = Measure([&]() {
+            for (const Bounds& area : *areas) {
+                hits->clear();
+                if (queryExtent > 0.0f) {
+                    ctx.QueryRect(area, *hits);
+                } else {
+                    ctx.QueryPoint(area.minX, area.minY, *hits);
+                }
+            }
+        });
+        return sample;
+    };
+}
+
+BenchIteration HitTestPointBench(const BenchParams& params) {
+    return HitTestBench(params, 0.0f);
+}
+
+BenchIteration HitTestRectBench(const BenchParams& params) {
+    return HitTestBench(params, 64.0f);
+}
+
+// Render thread: every rect of the scene slides back and forth on X; one
+// iteration advances all lanes by a 60 Hz frame
+BenchIteration AdvanceAnimationsBench(const BenchParams& params) {
+    auto& ctx = RenderContext::Instance();
+    // Lanes of the deleted scene are dropped by the next Advance
+    std::shared_ptr<BenchScene> scene(new BenchScene(params.nodes), [](BenchScene* done) {
+        delete done;
+        auto& ctx = RenderContext::Instance();
+        std::lock_guard<std::mutex> lock(ctx.RenderMutex());
+        ctx.AdvanceAnimations();
+    });
+    for (NodeId id : scene->Rects()) {
+        auto& rect = ctx.AccessData<ShapeRectNodeData>(id);
+        AnimationSpec spec;
+        spec.property = AnimatedProperty::X;
+        spec.keys.push_back(Keyframe{0.0f, rect.x, Easing::Linear});
+        spec.keys.push_back(Keyframe{1.0f, rect.x + 40.0f, Easing::EaseInOut});
+        spec.keys.push_back(Keyframe{2.0f, rect.x, Easing::EaseInOut});
+        spec.repeat = kRepeatForever;
+        rect.animations.push_back(std::move(spec));
+        rect.dirtyFields |= kFieldAnimations;
+    }
+    ctx.Sync();
+    auto now = std::make_shared<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
+
+    return [scene, now]() {
+        auto& ctx = RenderContext::Instance();
+        std::lock_guard<std::mutex> lock(ctx.RenderMutex());
+        *now += std::chrono::microseconds(16667);
+        BenchSample sample;
+        sample.ops = ctx.RunningAnimations();
+        sample.elapsed = Measure([&]() { ctx.AdvanceAnimations(*now); });
+        return sample;
+    };
+}
+
+// Startup through the write API: records for every node, then one Sync
+// (teardown not measured); compare with load_snapshot
+BenchIteration BuildSceneBench(const BenchParams& params) {
+    return [nodes = params.nodes]() {
+        std::unique_ptr<BenchScene> scene;
+        BenchSample sample;
+        sample.ops = nodes;
+        sample.elapsed = Measure([&]() { scene = std::make_unique<BenchScene>(nodes); });
+        return sample;
+    };
+}
+
+// Startup from a scene snapshot of the same scene, into a fresh context
+BenchIteration LoadSnapshotBench(const BenchParams& params) {
+    const std::string path = (std::filesystem::temp_directory_path() / "ui_bench_snapshot.bin").string();
+    {
+        BenchScene scene(params.nodes);
+        RenderContext::Instance().SaveSnapshot(path, scene.Root());
+    }
+
+    return [path, nodes = params.nodes]() {
+        auto ctx = std::make_unique<RenderContext>();
+        NodeId root = 0;
+        BenchSample sample;
+        sample.ops = nodes;
+        sample.elapsed = Measure([&]() { ctx->LoadSnapshot(path, root); });
+        DoNotOptimize(root);
+        return sample;
+    };
+}
+
+// Captured stress run (build plus kReplayFrames mutation frames) fed back
+// into a fresh context: decode and Sync per record, collection excluded
+BenchIteration ReplayChangesBench(const BenchParams& params) {
+    constexpr std::size_t kReplayFrames = 20;
+    const std::string path = (std::filesystem::temp_directory_path() / "ui_bench_capture.bin").string();
+    {
+        RenderContext ctx;
+        StressConfig config;
+        config.nodeCount = params.nodes;
+        config.maxDepth = 8;
+        StressScene scene(config, ctx);
+        ctx.StartCapture(path, scene.RootId());
+        ctx.Sync();
+        for (std::size_t frame = 0; frame < kReplayFrames; ++frame) {
+            scene.Mutate();
+            ctx.Sync();
+        }
+        ctx.StopCapture();
+    }
+    auto replay = std::make_shared<ChangeReplay>();
+    replay->Open(path);
+
+    return [replay]() {
+        auto ctx = std::make_unique<RenderContext>();
+        replay->Prepare(*ctx);
+        BenchSample sample;
+        sample.ops = replay->RecordCount();
+        sample.elapsed = Measure([&]() {
+            for (std::size_t frame = 0; frame < replay->FrameCount(); ++frame) {
+                replay->Feed(*ctx, frame);
+                ctx->Sync();
+            }
+        });
+        return sample;
+    };
+}
+
+// Allocator churn: free and re-allocate a fraction of live ids
+BenchIteration NodeIdAllocatorBench(const BenchParams& params) {
+    auto allocator = std::make_shared<NodeIdAllocator>();
+    auto live = std::make_shared<std::vector<NodeId>>();
+    live->reserve(params.nodes);
+    for (std::size_t i = 0; i < params.nodes; ++i) {
+        live->push_back(allocator->Allocate());
+    }
+    auto churn = std::make_shared<std::vector<std::size_t>>(PickIndices(params.nodes, params.dirtyRatio));
+
+    return [allocator, live, churn]() {
+        BenchSample sample;
+        sample.ops = churn->size() * 2;
+        sample.elapsed = Measure([&]() {
+            for (std::size_t i : *churn) {
+                allocator->Free((*live)[i]);
+            }
+            for (std::size_t i : *churn) {
+                (*live)[i] = allocator->Allocate();
+            }
+        });
+        return sample;
+    };
+}
+
+// Allocator churn from all JobSystem workers at once; each job frees and
+// re-allocates its own slice of the live ids
+BenchIteration NodeIdAllocatorThreadedBench(const BenchParams& params) {
+    auto allocator = std::make_shared<NodeIdAllocator>();
+    auto live = std::make_shared<std::vector<NodeId>>();
+    live->reserve(params.nodes);
+    for (std::size_t i = 0; i < params.nodes; ++i) {
+        live->push_back(allocator->Allocate());
+    }
+    auto churn = std::make_shared<std::vector<std::size_t>>(PickIndices(params.nodes, params.dirtyRatio));
+
+    return [allocator, live, churn]() {
+        BenchSample sample;
+        sample.ops = churn->size() * 2;
+        sample.elapsed = Measure([&]() {
+            JobSystem::Instance().ParallelFor(0, churn->size(), 1024, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    allocator->Free((*live)[(*churn)[i]]);
+                }
+                for (std::size_t i = begin; i < end; ++i) {
+                    (*live)[(*churn)[i]] = allocator->Allocate();
+                }
+            });
+        });
+        return sample;
+    };
+}
+
+// Per-type snapshot of a dirty subset
+BenchIteration SnapshotAndClearBench(const BenchParams& params) {
+    auto buffer = std::make_shared<TypeBuffer<ShapeRectNodeData>>();
+    auto dirty = std::make_shared<std::vector<std::size_t>>(PickIndices(params.nodes, params.dirtyRatio));
+
+    // Grow the buffer to full size once so iterations measure steady state
+    buffer->AccessData(MakeNodeId(params.nodes - 1, 0));
+    buffer->SnapshotAndClear();
+
+    return [buffer, dirty]() {
+        for (std::size_t index : *dirty) {
+            auto& rect = buffer->AccessData(MakeNodeId(index, 0));
+            rect.x = 1.0f;
+            rect.dirtyFields |= kFieldPosition;
+        }
+        BenchSample sample;
+        sample.ops = dirty->size();
+        sample.elapsed = Measure([&]() {
+            auto snapshot = buffer->SnapshotAndClear();
+            DoNotOptimize(snapshot.data());
+        });
+        return sample;
+    };
+}
+
+// Scheduler overhead: fork-join a light per-element transform in 1024-element chunks
+BenchIteration ParallelForBench(const BenchParams& params) {
+    auto values = std::make_shared<std::vector<float>>(params.nodes, 1.0f);
+
+    return [values]() {
+        BenchSample sample;
+        sample.ops = values->size();
+        sample.elapsed = Measure([&]() {
+            JobSystem::Instance().ParallelFor(0, values->size(), 1024, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    (*values)[i] = (*values)[i] * 0.5f + 1.0f;
+                }
+            });
+        });
+        DoNotOptimize(values->data());
+        return sample;
+    };
+}
+
+} // namespace
+
+void RegisterCoreBenchmarks(BenchRegistry& registry) {
+    registry.Register("access_data", AccessDataBench);
+    registry.Register("access_data_producers", AccessDataProducersBench);
+    registry.Register("sync", SyncBench);
+    registry.Register("sync_budgeted", SyncBudgetedBench);
+    registry.Register("collect_render_commands", CollectRenderCommandsBench, false);
+    registry.Register("collect_render_commands_grid", CollectGridBench, false);
+    registry.Register("collect_render_commands_grid_parallel", CollectGridParallelBench, false);
+    registry.Register("collect_render_commands_list_culled", CollectListCulledBench, false);
+    registry.Register("sort_render_commands", SortRenderCommandsBench, false);
+    registry.Register("virtual_list_scroll", VirtualListScrollBench, false);
+    registry.Register("hit_test_point", HitTestPointBench, false);
+    registry.Register("hit_test_rect", HitTestRectBench, false);
+    registry.Register("advance_animations", AdvanceAnimationsBench, false);
+    registry.Register("build_scene", BuildSceneBench, false);
+    registry.Register("load_snapshot", LoadSnapshotBench, false);
+    registry.Register("replay_changes", ReplayChangesBench, false);
+    registry.Register("node_id_allocator", NodeIdAllocatorBench);
+    registry.Register("node_id_allocator_threaded", NodeIdAllocatorThreadedBench);
+    registry.Register("snapshot_and_clear", SnapshotAndClearBench);
+    registry.Register("parallel_for", ParallelForBench, false);
+}
+
+} // namespace ui::bench
@@ -0,0 +1,284 @@
+#include "Animation.h"
+
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace ui {
+
+namespace {
+
+// Segments shorter than this end on the next frame
+constexpr float kMinSegmentSeconds = 1e-6f;
+
+// Times are floats relative to the epoch; move it before they lose precision
+constexpr float kRebaseSeconds = 600.0f;
+
+// eased(t) = ((a t + b) t + c) t
+struct Curve {
+    float a;
+    float b;
+    float c;
+};
+
+Curve CurveOf(Easing easing) {
+    switch (easing) {
+        case Easing::EaseIn:
+            return Curve{1.0f, 0.0f, 0.0f};    // t^3
+        case Easing::EaseOut:
+            return Curve{1.0f, -3.0f, 3.0f};   // 1 - (1 - t)^3
+        case Easing::EaseInOut:
+            return Curve{-2.0f, 3.0f, 0.0f};   // 3t^2 - 2t^3
+        case Easing::Linear:
+            break;
+    }
+    return Curve{0.0f, 0.0f, 1.0f};
+}
+
+} // namespace
+
+AnimationSpec AnimationSpec::Tween(AnimatedProperty property, float from, float to, float duration, Easing easing) {
+    AnimationSpec spec;
+    spec.property = property;
+    spec.keys.push_back(Keyframe{0.0f, from, Easing::Linear});
+    spec.keys.push_back(Keyframe{duration, to, easing});
+    return spec;
+}
+
+float AnimationSystem::Seconds(Clock::time_point time) const {
+    return std::chrono::duration<float>(time - m_epoch).count();
+}
+
+void AnimationSystem::Start(RenderContext& ctx, NodeId id, const AnimationTarget& target, const AnimationSpec& spec,
+                            Clock::time_point now) {
+    if (spec.keys.empty()) {
+        return;
+    }
+    float* field = target.field(ctx, id, spec.property);
+    if (!field) {
+        return;
+    }
+    Stop(id, spec.property);
+
+    Lane lane;
+    lane.id = id;
+    lane.target = &target;
+    lane.property = spec.property;
+    lane.repeatsLeft = spec.repeat;
+    lane.runStart = Seconds(now) + std::max(spec.delay, 0.0f);
+    lane.keys.assign(spec.keys.begin(), spec.keys.end());
+    if (std::isnan(lane.keys.front().value)) {
+        lane.keys.front().value = *field;
+    }
+    if (lane.keys.size() == 1) {
+        *field = lane.keys.front().value;  // nothing to run
+        return;
+    }
+
+    lane.low = lane.keys.front().value;
+    lane.high = lane.keys.front().value;
+    for (const Keyframe& key : lane.keys) {
+        lane.low = std::min(lane.low, key.value);
+        lane.high = std::max(lane.high, key.value);
+    }
+    AddLane(std::move(lane));
+}
+
+void AnimationSystem::Stop(NodeId id, AnimatedProperty property) {
+    const std::uint32_t lane = FindLane(id, property);
+    if (lane != kNoLane) {
+        RemoveLane(lane - 1);
+    }
+}
+
+bool AnimationSystem::Range(NodeId id, AnimatedProperty property, float& low, float& high) const {
+    const std::uint32_t lane = FindLane(id, property);
+    if (lane == kNoLane) {
+        return false;
+    }
+    low = m_lanes[lane - 1].low;
+    high = m_lanes[lane - 1].high;
+    return true;
+}
+
+void AnimationSystem::SettleFinished(RenderContext& ctx) {
+    for (const Settled& settled : m_settled) {
+        settled.target->settle(ctx, settled.id);
+    }
+    m_settled.clear();
+}
+
+void AnimationSystem::Advance(RenderContext& ctx, Clock::time_point time) {
+    if (m_lanes.empty()) {
+        m_epoch = time;
+        return;
+    }
+    TRACE_SCOPE_DETAIL("AnimationSystem::Advance");
+
+    float now = Seconds(time);
+    if (now > kRebaseSeconds) {
+        for (float& start : m_start) {
+            start -= now;
+        }
+        for (Lane& lane : m_lanes) {
+            lane.runStart -= now;
+        }
+        m_epoch = time;
+        now = 0.0f;
+    }
+
+    const std::size_t count = m_lanes.size();
+    const float* start = m_start.data();
+    const float* inverseDuration = m_inverseDuration.data();
+    const float* from = m_from.data();
+    const float* delta = m_delta.data();
+    const float* curveA = m_curveA.data();
+    const float* curveB = m_curveB.data();
+    const float* curveC = m_curveC.data();
+    float* progress = m_progress.data();
+    float* value = m_value.data();
+    for (std::size_t i = 0; i < count; ++i) {
+        float t = (now - start[i]) * inverseDuration[i];
+        t = t < 0.0f ? 0.0f : t;
+        t = t > 1.0f ? 1.0f : t;
+        progress[i] = t;
+        value[i] = from[i] + delta[i] * (((curveA[i] * t + curveB[i]) * t + curveC[i]) * t);
+    }
+
+    // Segment ends are rare: move those lanes on one by one
+    m_finished.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (progress[i] < 1.0f) {
+            continue;
+        }
+        if (!Seek(i, now)) {
+            value[i] = m_lanes[i].keys.back().value;
+            m_finished.push_back(i);
+            continue;
+        }
+        float t = std::clamp((now - start[i]) * inverseDuration[i], 0.0f, 1.0f);
+        value[i] = from[i] + delta[i] * (((curveA[i] * t + curveB[i]) * t + curveC[i]) * t);
+    }
+
+    // Finished lanes write their last value, lanes of deleted nodes are dropped
+    std::size_t nextFinished = 0;
+    const std::size_t finishedCount = m_finished.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        const Lane& lane = m_lanes[i];
+        float* field = lane.target->field(ctx, lane.id, lane.property);
+        if (field) {
+            *field = value[i];
+        }
+        const bool finished = nextFinished < finishedCount && m_finished[nextFinished] == i;
+        if (finished) {
+            ++nextFinished;
+        } else if (!field) {
+            m_finished.push_back(i);
+        }
+    }
+
+    // Back to front: RemoveLane() refills a slot from the back
+    std::sort(m_finished.begin(), m_finished.end());
+    for (std::size_t i = m_finished.size(); i-- > 0;) {
+        RemoveLane(m_finished[i]);
+    }
+}
+
+bool AnimationSystem::Seek(std::size_t i, float now) {
+    Lane& lane = m_lanes[i];
+    const auto& keys = lane.keys;
+    for (;;) {
+        if (now < lane.runStart + keys[lane.segment + 1].time) {
+            LoadSegment(i);
+            return true;
+        }
+        if (lane.segment + 2 < keys.size()) {
+            ++lane.segment;
+            continue;
+        }
+
+        // Past the last key: start over as often as the repeats allow
+        const float length = keys.back().time - keys.front().time;
+        if (lane.repeatsLeft == 0 || !(length > 0.0f)) {
+            return false;
+        }
+        float runs = std::max(1.0f, std::floor((now - lane.runStart - keys.front().time) / length));
+        if (lane.repeatsLeft != kRepeatForever) {
+            runs = std::min(runs, static_cast<float>(lane.repeatsLeft));
+            lane.repeatsLeft -= static_cast<std::int32_t>(runs);
+        }
+        lane.runStart += runs * length;
+        lane.segment = 0;
+    }
+}
+
+void AnimationSystem::LoadSegment(std::size_t i) {
+    const Lane& lane = m_lanes[i];
+    const Keyframe& begin = lane.keys[lane.segment];
+    const Keyframe& end = lane.keys[lane.segment + 1];
+    const Curve curve = CurveOf(end.easing);
+    m_start[i] = lane.runStart + begin.time;
+    m_inverseDuration[i] = 1.0f / std::max(end.time - begin.time, kMinSegmentSeconds);
+    m_from[i] = begin.value;
+    m_delta[i] = end.value - begin.value;
+    m_curveA[i] = curve.a;
+    m_curveB[i] = curve.b;
+    m_curveC[i] = curve.c;
+}
+
+std::uint32_t& AnimationSystem::LaneSlot(NodeId id, AnimatedProperty property) {
+    const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+    if (index >= m_laneOf.size()) {
+        m_laneOf.resize(index + 1, std::array<std::uint32_t, kAnimatedPropertyCount>{});
+    }
+    return m_laneOf[index][static_cast<std::size_t>(property)];
+}
+
+std::uint32_t AnimationSystem::FindLane(NodeId id, AnimatedProperty property) const {
+    const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+    if (index >= m_laneOf.size()) {
+        return kNoLane;
+    }
+    const std::uint32_t lane = m_laneOf[index][static_cast<std::size_t>(property)];
+    return (lane != kNoLane && m_lanes[lane - 1].id == id) ? lane : kNoLane;
+}
+
+void AnimationSystem::AddLane(Lane&& lane) {
+    const std::size_t i = m_lanes.size();
+    LaneSlot(lane.id, lane.property) = static_cast<std::uint32_t>(i + 1);
+    m_lanes.push_back(std::move(lane));
+    for (auto* column : {&m_start, &m_inverseDuration, &m_from, &m_delta, &m_curveA, &m_curveB, &m_curveC,
+                         &m_progress, &m_value}) {
+        column->push_back(0.0f);
+    }
+    LoadSegment(i);
+}
+
+void AnimationSystem::RemoveLane(std::size_t i) {
+    Lane& lane = m_lanes[i];
+    m_settled.push_back(Settled{lane.id, lane.target});
+    // The slot may already belong to a newer node at the same index
+    std::uint32_t& slot = LaneSlot(lane.id, lane.property);
+    if (slot == i + 1) {
+        slot = kNoLane;
+    }
+
+    const std::size_t last = m_lanes.size() - 1;
+    if (i != last) {
+        std::uint32_t& movedSlot = LaneSlot(m_lanes[last].id, m_lanes[last].property);
+        if (movedSlot == last + 1) {
+            movedSlot = static_cast<std::uint32_t>(i + 1);
+        }
+        m_lanes[i] = std::move(m_lanes[last]);
+    }
+    m_lanes.pop_back();
+    for (auto* column : {&m_start, &m_inverseDuration, &m_from, &m_delta, &m_curveA, &m_curveB, &m_curveC,
+                         &m_progress, &m_value}) {
+        (*column)[i] = column->back();
+        column->pop_back();
+    }
+}
+
+} // namespace ui
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "MemoryStats.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ui {
+
+class RenderContext;
+
+// Render node fields an animation can drive
+enum class AnimatedProperty : std::uint8_t {
+    X,
+    Y,
+    Width,   // rects only
+    Height,  // rects only
+};
+
+inline constexpr std::size_t kAnimatedPropertyCount = 4;
+
+// Size properties grow a node's area from its position; the rest move it
+inline bool IsExtent(AnimatedProperty property) {
+    return property == AnimatedProperty::Width || property == AnimatedProperty::Height;
+}
+
+// Shape of one keyframe segment. All are monotonic on [0, 1], so a segment
+// never leaves the range of its two keys.
+enum class Easing : std::uint8_t {
+    Linear,
+    EaseIn,     // cubic
+    EaseOut,    // cubic
+    EaseInOut,  // smoothstep
+};
+
+// `value` at `time` seconds into the animation; `easing` shapes the
+// segment that ends at this key
+struct Keyframe {
+    float time = 0.0f;
+    float value = 0.0f;
+    Easing easing = Easing::Linear;
+};
+
+// First key value: start from whatever the property is when the animation starts
+inline constexpr float kFromCurrent = std::numeric_limits<float>::quiet_NaN();
+inline constexpr std::int32_t kRepeatForever = -1;
+
+// Update side: one property animation, submitted once through the Frontend
+// API and run by the render thread (see RenderContext::AdvanceAnimations)
+struct AnimationSpec {
+    AnimatedProperty property = AnimatedProperty::X;
+    TrackedVector<Keyframe, MemoryTag::ChangeBuffer> keys;  // ascending time
+    float delay = 0.0f;       // seconds after the Sync that applies it
+    std::int32_t repeat = 0;  // extra runs from the first key, or kRepeatForever
+
+    // `from` may be kFromCurrent
+    static AnimationSpec Tween(AnimatedProperty property, float from, float to, float duration,
+                               Easing easing = Easing::Linear);
+};
+
+// How the render side reaches animated nodes of one type
+struct AnimationTarget {
+    // Field driven by `property`; null once the node is gone
+    float* (*field)(RenderContext& ctx, NodeId id, AnimatedProperty property);
+    // The node's animations ended: recompute what they widened (its bounds)
+    void (*settle)(RenderContext& ctx, NodeId id);
+};
+
+// ---------------------------------
+// AnimationSystem: running animations of one RenderContext, one lane per
+// (node, property). Each render frame evaluates every lane's current
+// segment in one branch-free loop over SoA arrays (easings are cubic
+// polynomials, so it vectorizes); lanes whose segment ended are then moved
+// to the next one, and the values are written to the render nodes.
+// Sync starts and stops lanes; everything runs under the render mutex.
+// ---------------------------------
+
+class AnimationSystem {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Sync: run `spec` on node `id`, replacing its running animation of the
+    // same property. Ignored if the node has no such field or no keys.
+    void Start(RenderContext& ctx, NodeId id, const AnimationTarget& target, const AnimationSpec& spec,
+               Clock::time_point now);
+
+    // Sync: the property was written directly; its animation stops where it is
+    void Stop(NodeId id, AnimatedProperty property);
+
+    // Values the property's animation runs through; false if it is not animated
+    bool Range(NodeId id, AnimatedProperty property, float& low, float& high) const;
+
+    // Sync: settle nodes whose animations ended since the last call
+    void SettleFinished(RenderContext& ctx);
+
+    // Render thread: evaluate every animation at `now` and write the values
+    void Advance(RenderContext& ctx, Clock::time_point now);
+
+    std::size_t Size() const { return m_lanes.size(); }
+    bool Empty() const { return m_lanes.empty(); }
+
+private:
+    static constexpr std::uint32_t kNoLane = 0;  // m_laneOf entries are lane + 1
+
+    // What only segment changes need
+    struct Lane {
+        NodeId id = 0;
+        const AnimationTarget* target = nullptr;
+        AnimatedProperty property = AnimatedProperty::X;
+        std::uint32_t segment = 0;  // keys[segment] -> keys[segment + 1]
+        std::int32_t repeatsLeft = 0;
+        float runStart = 0.0f;      // time of the current run's keys[0].time origin
+        float low = 0.0f;           // range of all keys
+        float high = 0.0f;
+        TrackedVector<Keyframe, MemoryTag::RenderStorage> keys;
+    };
+
+    struct Settled {
+        NodeId id;
+        const AnimationTarget* target;
+    };
+
+    // Seconds since m_epoch
+    float Seconds(Clock::time_point time) const;
+
+    // Point lane `i` at the segment running at `now`, moving on through
+    // later segments and repeats; false once the animation is over
+    bool Seek(std::size_t i, float now);
+    void LoadSegment(std::size_t i);
+
+    std::uint32_t& LaneSlot(NodeId id, AnimatedProperty property);
+    std::uint32_t FindLane(NodeId id, AnimatedProperty property) const;
+    void AddLane(Lane&& lane);
+    // Swap-remove; queues the node for SettleFinished()
+    void RemoveLane(std::size_t i);
+
+    // Hot per-lane data of the current segment, read by the evaluation loop
+    TrackedVector<float, MemoryTag::RenderStorage> m_start;
+    TrackedVector<float, MemoryTag::RenderStorage> m_inverseDuration;
+    TrackedVector<float, MemoryTag::RenderStorage> m_from;
+    TrackedVector<float, MemoryTag::RenderStorage> m_delta;
+    TrackedVector<float, MemoryTag::RenderStorage> m_curveA;  // eased = ((a t + b) t + c) t
+    TrackedVector<float, MemoryTag::RenderStorage> m_curveB;
+    TrackedVector<float, MemoryTag::RenderStorage> m_curveC;
+    // Loop output: clamped segment progress and value
+    TrackedVector<float, MemoryTag::RenderStorage> m_progress;
+    TrackedVector<float, MemoryTag::RenderStorage> m_value;
+
+    TrackedVector<Lane, MemoryTag::RenderStorage> m_lanes;
+    // By handle index: lane + 1 per property, kNoLane = none
+    TrackedVector<std::array<std::uint32_t, kAnimatedPropertyCount>, MemoryTag::RenderStorage> m_laneOf;
+    std::vector<Settled> m_settled;
+    std::vector<std::size_t> m_finished;  // Advance scratch
+    Clock::time_point m_epoch = Clock::now();
+};
+
+} // namespace ui
@@ -12,32 +12,41 @@ namespace ui {
 
 class BackendContainerNode : public TreeNode {
 public:
-    explicit BackendContainerNode(NodeId id)
-        : TreeNode(id) {}
+    BackendContainerNode(RenderContext& ctx, NodeId id)
+        : TreeNode(ctx, id) {}
 
     void SetPosition(float x, float y) override {
-        auto& data = RenderContext::Instance().AccessData<ContainerNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ContainerNodeData>(m_id);
         data.x = x;
         data.y = y;
+        data.dirtyFields |= kFieldPosition;
     }
 
     void SetVisible(bool v) override {
-        auto& data = RenderContext::Instance().AccessData<ContainerNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ContainerNodeData>(m_id);
         data.visible = v;
+        data.dirtyFields |= kFieldVisible;
+    }
+
+    void SetLayer(std::int16_t layer) override {
+        auto& data = m_ctx.AccessData<ContainerNodeData>(m_id);
+        data.layer = layer;
+        data.dirtyFields |= kFieldLayer;
     }
 
     void AddChild(TreeNode* child) {
         if (!child) {
             return;
         }
-        auto& data = RenderContext::Instance().AccessData<ContainerNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ContainerNodeData>(m_id);
         data.children.push_back(child->Id());
+        data.dirtyFields |= kFieldChildren;
     }
 
     void Term() override {
         // Mark node as deleted in ChangeBuffer
         // On Sync, the render node will be removed
-        auto& data = RenderContext::Instance().AccessData<ContainerNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ContainerNodeData>(m_id);
         data.deleted = true;
     }
 };
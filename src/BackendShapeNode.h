@@ -10,24 +10,32 @@ namespace ui {
 
 class BackendShapeNode : public TreeNode {
 public:
-    explicit BackendShapeNode(NodeId id)
-        : TreeNode(id) {}
+    BackendShapeNode(RenderContext& ctx, NodeId id)
+        : TreeNode(ctx, id) {}
 
     void SetPosition(float x, float y) override {
-        auto& data = RenderContext::Instance().AccessData<ShapeNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeNodeData>(m_id);
         data.x = x;
         data.y = y;
+        data.dirtyFields |= kFieldPosition;
     }
 
     void SetVisible(bool v) override {
-        auto& data = RenderContext::Instance().AccessData<ShapeNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeNodeData>(m_id);
         data.visible = v;
+        data.dirtyFields |= kFieldVisible;
+    }
+
+    void SetLayer(std::int16_t layer) override {
+        auto& data = m_ctx.AccessData<ShapeNodeData>(m_id);
+        data.layer = layer;
+        data.dirtyFields |= kFieldLayer;
     }
 
     void Term() override {
         // Mark node as deleted in ChangeBuffer
         // On Sync, the render node will be removed
-        auto& data = RenderContext::Instance().AccessData<ShapeNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeNodeData>(m_id);
         data.deleted = true;
     }
 };
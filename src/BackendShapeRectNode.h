@@ -5,39 +5,69 @@
 #include "NodeData.h"
 
 #include <memory>
+#include <utility>
 
 namespace ui {
 
 class BackendShapeRectNode : public BackendShapeNode {
 public:
-    explicit BackendShapeRectNode(NodeId id)
-        : BackendShapeNode(id) {}
+    BackendShapeRectNode(RenderContext& ctx, NodeId id)
+        : BackendShapeNode(ctx, id) {}
 
     void SetPosition(float x, float y) override {
-        auto& data = RenderContext::Instance().AccessData<ShapeRectNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
         data.x = x;
         data.y = y;
+        data.dirtyFields |= kFieldPosition;
+        DropAnimations(data.animations, kFieldPosition);
     }
 
     void SetVisible(bool v) override {
-        auto& data = RenderContext::Instance().AccessData<ShapeRectNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
         data.visible = v;
+        data.dirtyFields |= kFieldVisible;
+    }
+
+    void SetLayer(std::int16_t layer) override {
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
+        data.layer = layer;
+        data.dirtyFields |= kFieldLayer;
     }
 
     void SetWidth(float width) {
-        auto& data = RenderContext::Instance().AccessData<ShapeRectNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
         data.width = width;
+        data.dirtyFields |= kFieldWidth;
+        DropAnimations(data.animations, kFieldWidth);
     }
 
     void SetHeight(float height) {
-        auto& data = RenderContext::Instance().AccessData<ShapeRectNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
         data.height = height;
+        data.dirtyFields |= kFieldHeight;
+        DropAnimations(data.animations, kFieldHeight);
+    }
+
+    // Render thread moves the node to each new position over one Sync
+    // interval instead of jumping; its first position is never interpolated
+    void SetInterpolated(bool interpolated) {
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
+        data.interpolated = interpolated;
+        data.dirtyFields |= kFieldInterpolation;
+    }
+
+    // Runs on the render thread from the Sync that applies it; a later
+    // direct write of the property stops it
+    void Animate(AnimationSpec spec) {
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
+        data.animations.push_back(std::move(spec));
+        data.dirtyFields |= kFieldAnimations;
     }
 
     void Term() override {
         // Mark node as deleted in ChangeBuffer
         // On Sync, the render node will be removed
-        auto& data = RenderContext::Instance().AccessData<ShapeRectNodeData>(m_id);
+        auto& data = m_ctx.AccessData<ShapeRectNodeData>(m_id);
         data.deleted = true;
     }
 };
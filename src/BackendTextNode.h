@@ -6,34 +6,61 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace ui {
 
 class BackendTextNode : public TreeNode {
 public:
-    explicit BackendTextNode(NodeId id)
-        : TreeNode(id) {}
+    BackendTextNode(RenderContext& ctx, NodeId id)
+        : TreeNode(ctx, id) {}
 
     void SetPosition(float x, float y) override {
-        auto& data = RenderContext::Instance().AccessData<TextNodeData>(m_id);
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
         data.x = x;
         data.y = y;
+        data.dirtyFields |= kFieldPosition;
+        DropAnimations(data.animations, kFieldPosition);
     }
 
     void SetVisible(bool v) override {
-        auto& data = RenderContext::Instance().AccessData<TextNodeData>(m_id);
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
         data.visible = v;
+        data.dirtyFields |= kFieldVisible;
+    }
+
+    void SetLayer(std::int16_t layer) override {
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
+        data.layer = layer;
+        data.dirtyFields |= kFieldLayer;
     }
 
     void SetText(const std::string& text) {
-        auto& data = RenderContext::Instance().AccessData<TextNodeData>(m_id);
-        data.text = text;
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
+        data.text.assign(text.data(), text.size());
+        data.dirtyFields |= kFieldText;
+    }
+
+    // Render thread moves the node to each new position over one Sync
+    // interval instead of jumping; its first position is never interpolated
+    void SetInterpolated(bool interpolated) {
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
+        data.interpolated = interpolated;
+        data.dirtyFields |= kFieldInterpolation;
+    }
+
+    // Runs on the render thread from the Sync that applies it; a later
+    // direct write of the property stops it
+    void Animate(AnimationSpec spec) {
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
+        data.animations.push_back(std::move(spec));
+        data.dirtyFields |= kFieldAnimations;
     }
 
     void Term() override {
         // Mark node as deleted in ChangeBuffer
         // On Sync, the render node will be removed
-        auto& data = RenderContext::Instance().AccessData<TextNodeData>(m_id);
+        auto& data = m_ctx.AccessData<TextNodeData>(m_id);
         data.deleted = true;
     }
 };
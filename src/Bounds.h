@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+namespace ui {
+
+// Placeholder text metrics shared by culling and the renderer
+constexpr float kTextGlyphWidth = 8.0f;
+constexpr float kTextLineHeight = 16.0f;
+
+// Axis-aligned screen-space box; default-constructed bounds are empty
+struct Bounds {
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+
+    static Bounds FromRect(float x, float y, float width, float height) {
+        return Bounds{x, y, x + width, y + height};
+    }
+
+    // Covers everything; a viewport that culls nothing
+    static Bounds Infinite() {
+        return Bounds{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                      std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    }
+
+    bool IsEmpty() const { return minX > maxX || minY > maxY; }
+
+    void Add(const Bounds& other) {
+        minX = std::min(minX, other.minX);
+        minY = std::min(minY, other.minY);
+        maxX = std::max(maxX, other.maxX);
+        maxY = std::max(maxY, other.maxY);
+    }
+
+    // Empty bounds intersect nothing
+    bool Intersects(const Bounds& other) const {
+        return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+    }
+
+    bool operator==(const Bounds& other) const {
+        return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+    }
+    bool operator!=(const Bounds& other) const { return !(*this == other); }
+};
+
+} // namespace ui
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ui {
+
+// ---------------------------------
+// Byte streams of the binary formats (change capture, display stream):
+// LEB128 varints, raw values in host byte order and byte runs
+// ---------------------------------
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<unsigned char>& out)
+        : m_out(out) {}
+
+    void Varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            m_out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        m_out.push_back(static_cast<unsigned char>(value));
+    }
+
+    template <typename V>
+    void Raw(const V& value) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        m_out.insert(m_out.end(), bytes, bytes + sizeof(V));
+    }
+
+    void Bytes(const char* data, std::size_t size) {
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+private:
+    std::vector<unsigned char>& m_out;
+};
+
+// Reads fail (return false) instead of running past the end
+class ByteReader {
+public:
+    ByteReader(const unsigned char* data, std::size_t size)
+        : m_pos(data)
+        , m_end(data + size) {}
+
+    bool Varint(std::uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && m_pos != m_end; shift += 7) {
+            const unsigned char byte = *m_pos++;
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename V>
+    bool Raw(V& value) {
+        if (static_cast<std::size_t>(m_end - m_pos) < sizeof(V)) {
+            return false;
+        }
+        std::memcpy(&value, m_pos, sizeof(V));
+        m_pos += sizeof(V);
+        return true;
+    }
+
+    // Null if fewer than `size` bytes are left
+    const char* Bytes(std::uint64_t size) {
+        if (static_cast<std::uint64_t>(m_end - m_pos) < size) {
+            return nullptr;
+        }
+        const char* data = reinterpret_cast<const char*>(m_pos);
+        m_pos += size;
+        return data;
+    }
+
+    bool AtEnd() const { return m_pos == m_end; }
+
+private:
+    const unsigned char* m_pos;
+    const unsigned char* m_end;
+};
+
+// Signed values as varints: small magnitudes on either side of zero stay short
+inline std::uint64_t ZigZag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t UnZigZag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+} // namespace ui
@@ -1,8 +1,14 @@
 #pragma once
 
 #include "ui_ids.h"
+#include "MemoryStats.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 #include <vector>
 
 namespace ui {
@@ -37,8 +43,8 @@ public:
         return m_items[index];
     }
 
-    std::vector<T> SnapshotAndClear() {
-        std::vector<T> out;
+    TrackedVector<T, MemoryTag::ChangeBuffer> SnapshotAndClear() {
+        TrackedVector<T, MemoryTag::ChangeBuffer> out;
         out.reserve(m_activeIndices.size());
 
         // Collect only nodes that were actually touched in this frame.
@@ -57,40 +63,266 @@ public:
     bool Empty() const { return m_activeIndices.empty(); }
 
 private:
-    std::vector<T> m_items;
+    TrackedVector<T, MemoryTag::ChangeBuffer> m_items;
     // Marks which indices were modified in the current frame.
-    std::vector<bool> m_dirty;
+    TrackedVector<bool, MemoryTag::ChangeBuffer> m_dirty;
     // Compact list of indices that were touched in the current frame.
-    std::vector<std::size_t> m_activeIndices;
+    TrackedVector<std::size_t, MemoryTag::ChangeBuffer> m_activeIndices;
 };
 
+// Dense id per NodeData type; indexes the per-type slots of a ChangeBatch
+inline std::size_t NextChangeTypeId() {
+    static std::atomic<std::size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+std::size_t ChangeTypeId() {
+    static const std::size_t id = NextChangeTypeId();
+    return id;
+}
+
+struct TypeBatchBase {
+    virtual ~TypeBatchBase() = default;
+};
+
+template <typename T>
+struct TypeBatch final : TypeBatchBase {
+    TrackedVector<T, MemoryTag::ChangeBuffer> changes;
+};
+
+// Changes one producer thread published in one go; immutable once queued
+struct ChangeBatch {
+    std::uint64_t sequence = 0;  // publish order, decides conflicts between producers
+    std::vector<std::unique_ptr<TypeBatchBase>> types;  // indexed by ChangeTypeId<T>()
+    ChangeBatch* next = nullptr;  // link in the publish queue
+};
+
+using ChangeBatchList = std::vector<std::unique_ptr<ChangeBatch>>;
+
 // ---------------------------------
 // ChangeBuffer: stores batched changes per type
+// Every producer thread writes into its own thread-local shard without
+// locks. Publish() moves the shard into a sequenced batch on a lock-free
+// queue; Sync takes all batches and merges them per node in sequence
+// order, so the last published write wins per field.
+// Shards are per ChangeBuffer instance (one per RenderContext).
 // ---------------------------------
 
 class ChangeBuffer {
 public:
-    // Template method to access data for any type
+    ChangeBuffer()
+        : m_id(NextBufferId()) {}
+    ~ChangeBuffer() { TakePublished(); }
+
+    ChangeBuffer(const ChangeBuffer&) = delete;
+    ChangeBuffer& operator=(const ChangeBuffer&) = delete;
+
+    // Producer thread: write access to this thread's shard
     template <typename T>
     T& AccessData(NodeId id)
 	{
-		return Buffer<T>().AccessData(id);
+		Shard& shard = LocalShard();
+		const std::size_t typeId = ChangeTypeId<T>();
+		if (shard.types.size() <= typeId) {
+			shard.types.resize(typeId + 1);
+		}
+		if (!shard.types[typeId]) {
+			shard.types[typeId] = std::make_unique<ShardType<T>>();
+		}
+		auto& typed = static_cast<ShardType<T>&>(*shard.types[typeId]);
+		if (!typed.listed) {
+			typed.listed = true;
+			shard.touched.push_back(typeId);
+		}
+		return typed.buffer.AccessData(id);
 	}
 
-    // Template method to snapshot and clear data for any type
+    // Producer thread: queue everything this thread wrote since its last Publish()
+    void Publish() {
+        Shard& shard = LocalShard();
+        if (shard.touched.empty()) {
+            return;
+        }
+
+        auto batch = std::make_unique<ChangeBatch>();
+        for (std::size_t typeId : shard.touched) {
+            shard.types[typeId]->SnapshotInto(*batch, typeId);
+        }
+        shard.touched.clear();
+
+        // Lock-free push; TakePublished() restores sequence order and waits
+        // out batches pushed ahead of an earlier sequence
+        batch->sequence = m_nextSequence.fetch_add(1, std::memory_order_relaxed);
+        ChangeBatch* raw = batch.release();
+        ChangeBatch* head = m_published.load(std::memory_order_relaxed);
+        do {
+            raw->next = head;
+        } while (!m_published.compare_exchange_weak(head, raw, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Sync: take the published batches, oldest first. A producer can be
+    // overtaken between taking its sequence and pushing its batch; batches
+    // past such a gap are held back until it fills, so a later Sync never
+    // applies an older batch over a newer one.
+    ChangeBatchList TakePublished() {
+        ChangeBatchList batches = std::move(m_heldBack);
+        m_heldBack.clear();
+        for (ChangeBatch* batch = m_published.exchange(nullptr, std::memory_order_acquire); batch;) {
+            ChangeBatch* next = batch->next;
+            batch->next = nullptr;
+            batches.emplace_back(batch);
+            batch = next;
+        }
+        std::sort(batches.begin(), batches.end(),
+                  [](const auto& a, const auto& b) { return a->sequence < b->sequence; });
+
+        std::size_t ready = 0;
+        while (ready < batches.size() && batches[ready]->sequence == m_nextTaken) {
+            ++ready;
+            ++m_nextTaken;
+        }
+        m_heldBack.assign(std::make_move_iterator(batches.begin() + ready), std::make_move_iterator(batches.end()));
+        batches.resize(ready);
+        return batches;
+    }
+
+    // Sync: changes of one type across `batches`, one record per node.
+    // Records of the same node are merged in batch order (T::MergeFrom).
+    // Moves the records out of the batches; types may be merged concurrently.
     template <typename T>
-    std::vector<T> Snapshot()
-	{
-		return Buffer<T>().SnapshotAndClear();
-	}
+    static TrackedVector<T, MemoryTag::ChangeBuffer> Merge(ChangeBatchList& batches) {
+        const std::size_t typeId = ChangeTypeId<T>();
+        TrackedVector<T, MemoryTag::ChangeBuffer> merged;
+
+        std::size_t sources = 0;
+        std::size_t total = 0;
+        for (auto& batch : batches) {
+            if (auto* typed = Find<T>(*batch, typeId)) {
+                ++sources;
+                total += typed->changes.size();
+            }
+        }
+
+        // Common case: a single producer, nothing to merge
+        if (sources == 1) {
+            for (auto& batch : batches) {
+                if (auto* typed = Find<T>(*batch, typeId)) {
+                    merged = std::move(typed->changes);
+                }
+            }
+            return merged;
+        }
+
+        // Position + 1 of each node's record, by handle index; left all zero
+        thread_local std::vector<std::uint32_t> positions;
+        merged.reserve(total);
+        for (auto& batch : batches) {
+            auto* typed = Find<T>(*batch, typeId);
+            if (!typed) {
+                continue;
+            }
+            for (T& change : typed->changes) {
+                const std::size_t index = static_cast<std::size_t>(ExtractIndex(change.id));
+                if (index >= positions.size()) {
+                    positions.resize(index + 1, 0);
+                }
+                const std::uint32_t position = positions[index];
+                if (position != 0 && merged[position - 1].id == change.id) {
+                    merged[position - 1].MergeFrom(std::move(change));
+                } else {
+                    positions[index] = static_cast<std::uint32_t>(merged.size() + 1);
+                    merged.push_back(std::move(change));
+                }
+            }
+        }
+        for (const T& change : merged) {
+            positions[static_cast<std::size_t>(ExtractIndex(change.id))] = 0;
+        }
+        return merged;
+    }
 
 private:
-    // Static method to get TypeBuffer for a specific type
+    struct ShardTypeBase {
+        virtual ~ShardTypeBase() = default;
+        virtual void SnapshotInto(ChangeBatch& batch, std::size_t typeId) = 0;
+        bool listed = false;  // in Shard::touched since the last Publish()
+    };
+
     template <typename T>
-    static TypeBuffer<T>& Buffer() {
-        static TypeBuffer<T> buffer;
-        return buffer;
+    struct ShardType final : ShardTypeBase {
+        TypeBuffer<T> buffer;
+
+        void SnapshotInto(ChangeBatch& batch, std::size_t typeId) override {
+            listed = false;
+            if (batch.types.size() <= typeId) {
+                batch.types.resize(typeId + 1);
+            }
+            auto typed = std::make_unique<TypeBatch<T>>();
+            typed->changes = buffer.SnapshotAndClear();
+            batch.types[typeId] = std::move(typed);
+        }
+    };
+
+    // One producer thread's unpublished writes into this buffer
+    struct Shard {
+        std::vector<std::unique_ptr<ShardTypeBase>> types;  // indexed by ChangeTypeId<T>()
+        std::vector<std::size_t> touched;  // type ids written since the last Publish()
+    };
+
+    static std::uint64_t NextBufferId() {
+        static std::atomic<std::uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // This thread's shard of this buffer. Looked up by buffer id (addresses
+    // may be reused); shards of destroyed buffers are dropped lazily.
+    Shard& LocalShard() {
+        struct Entry {
+            std::uint64_t bufferId = 0;
+            std::weak_ptr<void> owner;
+            std::unique_ptr<Shard> shard;
+        };
+        struct ThreadShards {
+            std::uint64_t lastId = 0;
+            Shard* last = nullptr;
+            std::vector<Entry> entries;
+        };
+        thread_local ThreadShards shards;
+
+        if (shards.lastId == m_id) {
+            return *shards.last;
+        }
+        auto it = std::find_if(shards.entries.begin(), shards.entries.end(),
+                               [this](const Entry& e) { return e.bufferId == m_id; });
+        if (it == shards.entries.end()) {
+            shards.entries.erase(std::remove_if(shards.entries.begin(), shards.entries.end(),
+                                                [](const Entry& e) { return e.owner.expired(); }),
+                                 shards.entries.end());
+            shards.entries.push_back(Entry{m_id, m_owner, std::make_unique<Shard>()});
+            it = shards.entries.end() - 1;
+        }
+        shards.lastId = m_id;
+        shards.last = it->shard.get();
+        return *shards.last;
     }
+
+    template <typename T>
+    static TypeBatch<T>* Find(ChangeBatch& batch, std::size_t typeId) {
+        if (typeId >= batch.types.size()) {
+            return nullptr;
+        }
+        return static_cast<TypeBatch<T>*>(batch.types[typeId].get());
+    }
+
+    const std::uint64_t m_id;
+    std::shared_ptr<void> m_owner = std::make_shared<char>(0);  // expires with the buffer
+    std::atomic<ChangeBatch*> m_published{nullptr};
+    std::atomic<std::uint64_t> m_nextSequence{0};
+    // Sync only: sequence of the next batch to hand out, and batches taken
+    // ahead of it
+    std::uint64_t m_nextTaken = 0;
+    ChangeBatchList m_heldBack;
 };
 
 
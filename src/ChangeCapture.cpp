@@ -0,0 +1,401 @@
+#include "ChangeCapture.h"
+
+#include "RenderContext.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ui {
+
+namespace {
+
+// ---------------------------------
+// Record encoding: id and flags, the common fields, then each type's own
+// fields (EncodeFields / DecodeFields overloads), all in dirty-bit order
+// ---------------------------------
+
+template <typename T>
+void EncodeCommon(ByteWriter& out, const T& record) {
+    out.Varint(record.id);
+    out.Varint(std::uint64_t{record.dirtyFields} << 1 | (record.deleted ? 1 : 0));
+    if (record.dirtyFields & kFieldPosition) {
+        out.Raw(record.x);
+        out.Raw(record.y);
+    }
+    if (record.dirtyFields & kFieldVisible) {
+        out.Raw(static_cast<std::uint8_t>(record.visible ? 1 : 0));
+    }
+    if (record.dirtyFields & kFieldLayer) {
+        out.Raw(record.layer);
+    }
+}
+
+// After the id and flags, which pick the record to decode into
+template <typename T>
+bool DecodeCommon(ByteReader& in, T& record) {
+    if (record.dirtyFields & kFieldPosition) {
+        if (!in.Raw(record.x) || !in.Raw(record.y)) {
+            return false;
+        }
+    }
+    if (record.dirtyFields & kFieldVisible) {
+        std::uint8_t visible = 0;
+        if (!in.Raw(visible)) {
+            return false;
+        }
+        record.visible = visible != 0;
+    }
+    if (record.dirtyFields & kFieldLayer) {
+        if (!in.Raw(record.layer)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DecodeFlag(ByteReader& in, bool& value) {
+    std::uint8_t byte = 0;
+    if (!in.Raw(byte)) {
+        return false;
+    }
+    value = byte != 0;
+    return true;
+}
+
+void EncodeFields(ByteWriter& out, const ContainerNodeData& record) {
+    if (record.dirtyFields & kFieldChildren) {
+        out.Varint(record.children.size());
+        for (NodeId child : record.children) {
+            out.Varint(child);
+        }
+    }
+}
+
+bool DecodeFields(ByteReader& in, ContainerNodeData& record, std::uint64_t indexLimit) {
+    if (record.dirtyFields & kFieldChildren) {
+        std::uint64_t count = 0;
+        if (!in.Varint(count)) {
+            return false;
+        }
+        for (std::uint64_t i = 0; i < count; ++i) {
+            NodeId child = 0;
+            if (!in.Varint(child) || ExtractIndex(child) >= indexLimit) {
+                return false;
+            }
+            record.children.push_back(child);
+        }
+    }
+    return true;
+}
+
+void EncodeFields(ByteWriter& out, const TextNodeData& record) {
+    if (record.dirtyFields & kFieldText) {
+        out.Varint(record.text.size());
+        out.Bytes(record.text.data(), record.text.size());
+    }
+    if (record.dirtyFields & kFieldAnimations) {
+        EncodeAnimations(out, record.animations);
+    }
+    if (record.dirtyFields & kFieldInterpolation) {
+        out.Raw(static_cast<std::uint8_t>(record.interpolated ? 1 : 0));
+    }
+}
+
+bool DecodeFields(ByteReader& in, TextNodeData& record, std::uint64_t) {
+    if (record.dirtyFields & kFieldText) {
+        std::uint64_t length = 0;
+        const char* text = in.Varint(length) ? in.Bytes(length) : nullptr;
+        if (!text) {
+            return false;
+        }
+        record.text.assign(text, static_cast<std::size_t>(length));
+    }
+    if ((record.dirtyFields & kFieldAnimations) && !DecodeAnimations(in, record.animations)) {
+        return false;
+    }
+    return !(record.dirtyFields & kFieldInterpolation) || DecodeFlag(in, record.interpolated);
+}
+
+void EncodeFields(ByteWriter&, const ShapeNodeData&) {}
+
+bool DecodeFields(ByteReader&, ShapeNodeData&, std::uint64_t) {
+    return true;
+}
+
+void EncodeFields(ByteWriter& out, const ShapeRectNodeData& record) {
+    if (record.dirtyFields & kFieldWidth) {
+        out.Raw(record.width);
+    }
+    if (record.dirtyFields & kFieldHeight) {
+        out.Raw(record.height);
+    }
+    if (record.dirtyFields & kFieldAnimations) {
+        EncodeAnimations(out, record.animations);
+    }
+    if (record.dirtyFields & kFieldInterpolation) {
+        out.Raw(static_cast<std::uint8_t>(record.interpolated ? 1 : 0));
+    }
+}
+
+bool DecodeFields(ByteReader& in, ShapeRectNodeData& record, std::uint64_t) {
+    if ((record.dirtyFields & kFieldWidth) && !in.Raw(record.width)) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldHeight) && !in.Raw(record.height)) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldAnimations) && !DecodeAnimations(in, record.animations)) {
+        return false;
+    }
+    return !(record.dirtyFields & kFieldInterpolation) || DecodeFlag(in, record.interpolated);
+}
+
+// Ids at or past `indexLimit` are rejected: storage is sized by index
+template <typename T>
+bool FeedRecords(RenderContext& ctx, ByteReader& in, std::uint64_t count, std::uint64_t indexLimit) {
+    for (std::uint64_t i = 0; i < count; ++i) {
+        NodeId id = 0;
+        std::uint64_t flags = 0;
+        if (!in.Varint(id) || ExtractIndex(id) >= indexLimit || !in.Varint(flags) || flags >> 33 != 0) {
+            return false;
+        }
+        T& record = ctx.AccessData<T>(id);
+        record.dirtyFields = static_cast<std::uint32_t>(flags >> 1);
+        record.deleted = (flags & 1) != 0;
+        if (!DecodeCommon(in, record) || !DecodeFields(in, record, indexLimit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------
+// Animation specs
+// ---------------------------------
+
+void EncodeAnimations(ByteWriter& out, const TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>& animations) {
+    out.Varint(animations.size());
+    for (const AnimationSpec& spec : animations) {
+        out.Raw(static_cast<std::uint8_t>(spec.property));
+        out.Raw(spec.delay);
+        out.Raw(spec.repeat);
+        out.Varint(spec.keys.size());
+        for (const Keyframe& key : spec.keys) {
+            out.Raw(key.time);
+            out.Raw(key.value);
+            out.Raw(static_cast<std::uint8_t>(key.easing));
+        }
+    }
+}
+
+bool DecodeAnimations(ByteReader& in, TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>& animations) {
+    std::uint64_t count = 0;
+    if (!in.Varint(count)) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        AnimationSpec spec;
+        std::uint8_t property = 0;
+        std::uint64_t keys = 0;
+        if (!in.Raw(property) || property >= kAnimatedPropertyCount || !in.Raw(spec.delay) || !in.Raw(spec.repeat) ||
+            !in.Varint(keys)) {
+            return false;
+        }
+        spec.property = static_cast<AnimatedProperty>(property);
+        for (std::uint64_t k = 0; k < keys; ++k) {
+            Keyframe key;
+            std::uint8_t easing = 0;
+            if (!in.Raw(key.time) || !in.Raw(key.value) || !in.Raw(easing) ||
+                easing > static_cast<std::uint8_t>(Easing::EaseInOut)) {
+                return false;
+            }
+            key.easing = static_cast<Easing>(easing);
+            spec.keys.push_back(key);
+        }
+        animations.push_back(std::move(spec));
+    }
+    return true;
+}
+
+// ---------------------------------
+// ChangeCapture
+// ---------------------------------
+
+bool ChangeCapture::Open(const std::string& path, NodeId root) {
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        return false;
+    }
+    std::memcpy(m_header.magic, kCaptureMagic, sizeof(kCaptureMagic));
+    m_header.version = kCaptureVersion;
+    m_header.byteOrder = kCaptureByteOrder;
+    m_header.root = root;
+    // Rewritten with the final counts by Close()
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_begin = std::chrono::steady_clock::now();
+    return static_cast<bool>(m_file);
+}
+
+void ChangeCapture::BeginFrame(std::uint64_t indexLimit) {
+    m_header.indexLimit = std::max(m_header.indexLimit, indexLimit);
+    m_frame.clear();
+    m_frameRecords = 0;
+}
+
+template <typename T>
+void ChangeCapture::WriteRecords(CaptureRecordType type, const TrackedVector<T, MemoryTag::ChangeBuffer>& records) {
+    if (records.empty()) {
+        return;
+    }
+    ByteWriter out(m_frame);
+    out.Raw(type);
+    out.Varint(records.size());
+    for (const T& record : records) {
+        EncodeCommon(out, record);
+        EncodeFields(out, record);
+    }
+    m_frameRecords += records.size();
+}
+
+void ChangeCapture::Write(const TrackedVector<ContainerNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureContainers, records);
+}
+
+void ChangeCapture::Write(const TrackedVector<TextNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureTexts, records);
+}
+
+void ChangeCapture::Write(const TrackedVector<ShapeNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureShapes, records);
+}
+
+void ChangeCapture::Write(const TrackedVector<ShapeRectNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureRects, records);
+}
+
+void ChangeCapture::EndFrame() {
+    CaptureFrameHeader frame{};
+    frame.bytes = m_frame.size();
+    frame.records = m_frameRecords;
+    frame.timeNs = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_begin).count());
+    m_file.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    m_file.write(reinterpret_cast<const char*>(m_frame.data()), static_cast<std::streamsize>(m_frame.size()));
+    ++m_header.frameCount;
+}
+
+bool ChangeCapture::Close() {
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_file.close();
+    return !m_file.fail();
+}
+
+// ---------------------------------
+// ChangeReplay
+// ---------------------------------
+
+bool ChangeReplay::Open(const std::string& path) {
+    m_frames.clear();
+    m_records = 0;
+    m_lastTimeNs = 0;
+    if (!m_file.Open(path) || m_file.Size() < sizeof(CaptureHeader)) {
+        return false;
+    }
+    std::memcpy(&m_header, m_file.Data(), sizeof(m_header));
+    if (std::memcmp(m_header.magic, kCaptureMagic, sizeof(kCaptureMagic)) != 0 || m_header.version != kCaptureVersion ||
+        m_header.byteOrder != kCaptureByteOrder || m_header.indexLimit > NodeIdAllocator::kMaxIndex) {
+        return false;
+    }
+
+    // Frames must tile the rest of the file exactly
+    std::size_t offset = sizeof(CaptureHeader);
+    while (offset < m_file.Size()) {
+        CaptureFrameHeader frame;
+        if (m_file.Size() - offset < sizeof(frame)) {
+            return false;
+        }
+        std::memcpy(&frame, m_file.Data() + offset, sizeof(frame));
+        if (frame.bytes > m_file.Size() - offset - sizeof(frame)) {
+            return false;
+        }
+        m_frames.push_back(offset);
+        m_records += frame.records;
+        m_lastTimeNs = frame.timeNs;
+        offset += sizeof(frame) + static_cast<std::size_t>(frame.bytes);
+    }
+    return m_frames.size() == m_header.frameCount;
+}
+
+void ChangeReplay::Prepare(RenderContext& ctx) const {
+    ctx.ReserveIds(m_header.indexLimit);
+}
+
+bool ChangeReplay::Feed(RenderContext& ctx, std::size_t frame) const {
+    TRACE_SCOPE_DETAIL("ChangeReplay::Feed");
+    if (frame >= m_frames.size()) {
+        return false;
+    }
+    CaptureFrameHeader header;
+    std::memcpy(&header, m_file.Data() + m_frames[frame], sizeof(header));
+    ByteReader in(m_file.Data() + m_frames[frame] + sizeof(header), static_cast<std::size_t>(header.bytes));
+    while (!in.AtEnd()) {
+        std::uint8_t type = 0;
+        std::uint64_t count = 0;
+        if (!in.Raw(type) || !in.Varint(count)) {
+            return false;
+        }
+        bool ok = false;
+        switch (type) {
+            case kCaptureContainers:
+                ok = FeedRecords<ContainerNodeData>(ctx, in, count, m_header.indexLimit);
+                break;
+            case kCaptureTexts:
+                ok = FeedRecords<TextNodeData>(ctx, in, count, m_header.indexLimit);
+                break;
+            case kCaptureShapes:
+                ok = FeedRecords<ShapeNodeData>(ctx, in, count, m_header.indexLimit);
+                break;
+            case kCaptureRects:
+                ok = FeedRecords<ShapeRectNodeData>(ctx, in, count, m_header.indexLimit);
+                break;
+            default:
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------
+// RenderContext capture control
+// ---------------------------------
+
+bool RenderContext::StartCapture(const std::string& path, NodeId root) {
+    auto capture = std::make_unique<ChangeCapture>();
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (m_capture || !capture->Open(path, root)) {
+        return false;
+    }
+    m_capture = std::move(capture);
+    return true;
+}
+
+bool RenderContext::StopCapture() {
+    std::unique_ptr<ChangeCapture> capture;
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        capture = std::move(m_capture);
+    }
+    return capture && capture->Close();
+}
+
+} // namespace ui
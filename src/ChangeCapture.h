@@ -0,0 +1,133 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "ByteStream.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
+#include "NodeData.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ui {
+
+class RenderContext;
+
+// ---------------------------------
+// Change capture: the records each Sync applied (what ProcessChanges<T>
+// consumed, after merging and budget planning), one frame per Sync.
+// Replaying the frames into a context in the state the capture started
+// from applies the same records in the same Syncs, without the producers.
+//
+// File: a CaptureHeader, then per frame a CaptureFrameHeader and its
+// payload: per type with records, a CaptureRecordType byte and a varint
+// record count, then the records. A record is its varint id, a varint of
+// dirtyFields << 1 | deleted, and only the fields marked dirty. Host byte
+// order; version 1.
+// ---------------------------------
+
+enum CaptureRecordType : std::uint8_t {
+    kCaptureContainers,
+    kCaptureTexts,
+    kCaptureShapes,
+    kCaptureRects,
+    kCaptureRecordTypeCount
+};
+
+struct CaptureHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;    // kCaptureByteOrder as the writer saw it
+    std::uint64_t frameCount;
+    std::uint64_t indexLimit;   // every captured id's index is below this
+    NodeId root;                // as given to RenderContext::StartCapture
+};
+
+struct CaptureFrameHeader {
+    std::uint64_t bytes;    // payload that follows
+    std::uint64_t records;
+    std::uint64_t timeNs;   // since the capture started
+};
+
+inline constexpr char kCaptureMagic[8] = {'U', 'I', 'C', 'A', 'P', 'T', '\0', '\0'};
+inline constexpr std::uint32_t kCaptureVersion = 1;
+inline constexpr std::uint32_t kCaptureByteOrder = 0x01020304u;
+
+static_assert(std::is_trivially_copyable_v<CaptureHeader> && std::is_trivially_copyable_v<CaptureFrameHeader>);
+
+// Writing side, owned by a RenderContext between StartCapture and StopCapture.
+// Sync calls it under the render mutex.
+class ChangeCapture {
+public:
+    // False if `path` cannot be created
+    bool Open(const std::string& path, NodeId root);
+
+    // Frame of one Sync; `indexLimit` is the id allocator's (see NodeIdAllocator::IndexLimit)
+    void BeginFrame(std::uint64_t indexLimit);
+    // Records of one type, in the order they are applied
+    void Write(const TrackedVector<ContainerNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<TextNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<ShapeNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<ShapeRectNodeData, MemoryTag::ChangeBuffer>& records);
+    void EndFrame();
+
+    // Finish the header; false if any write failed
+    bool Close();
+
+private:
+    template <typename T>
+    void WriteRecords(CaptureRecordType type, const TrackedVector<T, MemoryTag::ChangeBuffer>& records);
+
+    std::ofstream m_file;
+    CaptureHeader m_header{};
+    std::vector<unsigned char> m_frame;  // payload of the open frame
+    std::uint64_t m_frameRecords = 0;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+// Reading side: validates a capture file's framing and feeds its frames
+// into a context one Sync at a time
+class ChangeReplay {
+public:
+    // False if the file cannot be mapped or is not a complete capture
+    bool Open(const std::string& path);
+
+    std::size_t FrameCount() const { return m_frames.size(); }
+    std::uint64_t RecordCount() const { return m_records; }
+    NodeId Root() const { return m_header.root; }
+    // Capture time of the last frame
+    std::chrono::nanoseconds Duration() const { return std::chrono::nanoseconds(m_lastTimeNs); }
+
+    // Once, before the first Feed: `ctx` is fresh, or loaded from a
+    // snapshot saved right before the capture started. Ids replayed into
+    // it come from the capture, so do not allocate ids on it afterwards.
+    void Prepare(RenderContext& ctx) const;
+
+    // Write frame `frame`'s records into ctx's change buffer (this
+    // thread's shard); an unbudgeted Sync on this thread then applies them
+    // as the captured Sync did. False if the frame is malformed (records
+    // before the bad one are written). Only the encoding and id ranges are
+    // checked: records are trusted like producer writes, so a capture of
+    // a misbehaving producer replays its misbehaviour.
+    bool Feed(RenderContext& ctx, std::size_t frame) const;
+
+private:
+    MappedFile m_file;
+    CaptureHeader m_header{};
+    std::vector<std::size_t> m_frames;  // offsets of frame headers in m_file
+    std::uint64_t m_lastTimeNs = 0;
+    std::uint64_t m_records = 0;
+};
+
+// Animation specs as a capture stores them (the display stream sends them
+// the same way, see DisplayStream.h)
+void EncodeAnimations(ByteWriter& out, const TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>& animations);
+// Appends to `animations`; false if the specs are malformed
+bool DecodeAnimations(ByteReader& in, TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>& animations);
+
+} // namespace ui
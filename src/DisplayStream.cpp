@@ -0,0 +1,933 @@
+#include "DisplayStream.h"
+
+#include "RenderContext.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace ui {
+
+namespace {
+
+// Largest message a viewer accepts; keyframes of the biggest trees stay well below
+constexpr std::uint32_t kMaxMessageBytes = 1u << 30;
+// The sender thread checks for a new viewer (and for shutdown) this often
+constexpr std::chrono::milliseconds kSenderPollInterval{20};
+// On shutdown, how long queued messages may take to reach the viewer
+constexpr std::size_t kShutdownFlushPolls = 50;
+constexpr std::size_t kReceiveChunk = std::size_t{64} << 10;
+
+// ---------------------------------
+// Field encoding
+// ---------------------------------
+
+void WriteQuantized(ByteWriter& out, float value) {
+    const float scaled = value * kStreamPositionScale;
+    const long quantized = std::isfinite(scaled) ? std::lround(std::clamp(scaled, -2.0e9f, 2.0e9f)) : 0;
+    out.Varint(ZigZag(quantized));
+}
+
+bool ReadQuantized(ByteReader& in, float& value) {
+    std::uint64_t zigzag = 0;
+    if (!in.Varint(zigzag)) {
+        return false;
+    }
+    const std::int64_t quantized = UnZigZag(zigzag);
+    if (quantized < std::numeric_limits<std::int32_t>::min() || quantized > std::numeric_limits<std::int32_t>::max()) {
+        return false;
+    }
+    value = static_cast<float>(quantized) / kStreamPositionScale;
+    return true;
+}
+
+void WriteFlag(ByteWriter& out, bool value) {
+    out.Raw(static_cast<std::uint8_t>(value ? 1 : 0));
+}
+
+bool ReadFlag(ByteReader& in, bool& value) {
+    std::uint8_t byte = 0;
+    if (!in.Raw(byte)) {
+        return false;
+    }
+    value = byte != 0;
+    return true;
+}
+
+// Ids of one list as index deltas from the previous one: nodes created
+// together sit at neighbouring indices, so runs cost about two bytes an id
+class IdWriter {
+public:
+    void Write(ByteWriter& out, NodeId id) {
+        const std::uint64_t index = ExtractIndex(id);
+        out.Varint(ZigZag(static_cast<std::int64_t>(index) - static_cast<std::int64_t>(m_previous)));
+        out.Varint(ExtractGeneration(id));
+        m_previous = index;
+    }
+
+private:
+    std::uint64_t m_previous = 0;
+};
+
+// Indices at or past `indexLimit` are rejected: storage is sized by index
+class IdReader {
+public:
+    explicit IdReader(std::uint64_t indexLimit)
+        : m_indexLimit(indexLimit) {}
+
+    bool Read(ByteReader& in, NodeId& id) {
+        std::uint64_t delta = 0;
+        std::uint64_t generation = 0;
+        if (!in.Varint(delta) || !in.Varint(generation) || generation > 0xFFFF) {
+            return false;
+        }
+        const std::int64_t index = static_cast<std::int64_t>(m_previous) + UnZigZag(delta);
+        if (index < 0 || static_cast<std::uint64_t>(index) >= m_indexLimit) {
+            return false;
+        }
+        m_previous = static_cast<std::uint64_t>(index);
+        id = MakeNodeId(m_previous, static_cast<std::uint16_t>(generation));
+        return true;
+    }
+
+private:
+    std::uint64_t m_indexLimit;
+    std::uint64_t m_previous = 0;
+};
+
+// Id, flags and the fields every type has. `node` is a record or, for a
+// keyframe, a render node: both name them alike.
+template <typename Node>
+void EncodeCommon(ByteWriter& out, IdWriter& ids, NodeId id, std::uint32_t fields, bool deleted, const Node& node) {
+    ids.Write(out, id);
+    out.Varint(std::uint64_t{fields} << 1 | (deleted ? 1 : 0));
+    if (fields & kFieldPosition) {
+        WriteQuantized(out, node.x);
+        WriteQuantized(out, node.y);
+    }
+    if (fields & kFieldVisible) {
+        WriteFlag(out, node.visible);
+    }
+    if (fields & kFieldLayer) {
+        out.Varint(ZigZag(node.layer));
+    }
+}
+
+template <typename T>
+bool DecodeCommon(ByteReader& in, T& record) {
+    if ((record.dirtyFields & kFieldPosition) && (!ReadQuantized(in, record.x) || !ReadQuantized(in, record.y))) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldVisible) && !ReadFlag(in, record.visible)) {
+        return false;
+    }
+    if (record.dirtyFields & kFieldLayer) {
+        std::uint64_t layer = 0;
+        if (!in.Varint(layer)) {
+            return false;
+        }
+        const std::int64_t value = UnZigZag(layer);
+        if (value < std::numeric_limits<std::int16_t>::min() || value > std::numeric_limits<std::int16_t>::max()) {
+            return false;
+        }
+        record.layer = static_cast<std::int16_t>(value);
+    }
+    return true;
+}
+
+template <typename Children>
+void EncodeChildren(ByteWriter& out, const Children& children) {
+    out.Varint(children.size());
+    IdWriter ids;
+    for (NodeId child : children) {
+        ids.Write(out, child);
+    }
+}
+
+// Each type's own fields, in the order of their dirty bits. Render nodes
+// (keyframes) carry no animations.
+using Animations = TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>;
+
+template <typename Children>
+void EncodeContainerFields(ByteWriter& out, std::uint32_t fields, const Children& children) {
+    if (fields & kFieldChildren) {
+        EncodeChildren(out, children);
+    }
+}
+
+template <typename WriteText>
+void EncodeTextFields(ByteWriter& out, std::uint32_t fields, std::string_view text, const Animations* animations,
+                      bool interpolated, WriteText&& writeText) {
+    if (fields & kFieldText) {
+        writeText(out, text);
+    }
+    if ((fields & kFieldAnimations) && animations) {
+        EncodeAnimations(out, *animations);
+    }
+    if (fields & kFieldInterpolation) {
+        WriteFlag(out, interpolated);
+    }
+}
+
+void EncodeRectFields(ByteWriter& out, std::uint32_t fields, float width, float height, const Animations* animations,
+                      bool interpolated) {
+    if (fields & kFieldWidth) {
+        WriteQuantized(out, width);
+    }
+    if (fields & kFieldHeight) {
+        WriteQuantized(out, height);
+    }
+    if ((fields & kFieldAnimations) && animations) {
+        EncodeAnimations(out, *animations);
+    }
+    if (fields & kFieldInterpolation) {
+        WriteFlag(out, interpolated);
+    }
+}
+
+template <typename WriteText>
+void EncodeRecord(ByteWriter& out, IdWriter& ids, const ContainerNodeData& record, WriteText&&) {
+    EncodeCommon(out, ids, record.id, record.dirtyFields, record.deleted, record);
+    EncodeContainerFields(out, record.dirtyFields, record.children);
+}
+
+template <typename WriteText>
+void EncodeRecord(ByteWriter& out, IdWriter& ids, const TextNodeData& record, WriteText&& writeText) {
+    EncodeCommon(out, ids, record.id, record.dirtyFields, record.deleted, record);
+    EncodeTextFields(out, record.dirtyFields, std::string_view(record.text.data(), record.text.size()),
+                     &record.animations, record.interpolated, writeText);
+}
+
+template <typename WriteText>
+void EncodeRecord(ByteWriter& out, IdWriter& ids, const ShapeNodeData& record, WriteText&&) {
+    EncodeCommon(out, ids, record.id, record.dirtyFields, record.deleted, record);
+}
+
+template <typename WriteText>
+void EncodeRecord(ByteWriter& out, IdWriter& ids, const ShapeRectNodeData& record, WriteText&&) {
+    EncodeCommon(out, ids, record.id, record.dirtyFields, record.deleted, record);
+    EncodeRectFields(out, record.dirtyFields, record.width, record.height, &record.animations, record.interpolated);
+}
+
+// Keyframe: a render node as a record that recreates it in an empty
+// context; fields still at their defaults are left out
+template <typename Node>
+std::uint32_t CommonFields(const Node& node) {
+    return kFieldPosition | (node.visible ? 0u : kFieldVisible) | (node.layer != 0 ? kFieldLayer : 0u);
+}
+
+template <typename WriteText>
+void EncodeNode(ByteWriter& out, IdWriter& ids, NodeId id, const RenderContainerNode& node, WriteText&&) {
+    const std::uint32_t fields = CommonFields(node) | (node.children.empty() ? 0u : kFieldChildren);
+    EncodeCommon(out, ids, id, fields, false, node);
+    EncodeContainerFields(out, fields, node.children);
+}
+
+template <typename WriteText>
+void EncodeNode(ByteWriter& out, IdWriter& ids, NodeId id, const RenderTextNode& node, WriteText&& writeText) {
+    const std::uint32_t fields = CommonFields(node) | kFieldText | (node.interpolated ? kFieldInterpolation : 0u);
+    EncodeCommon(out, ids, id, fields, false, node);
+    EncodeTextFields(out, fields, std::string_view(node.text.data(), node.text.size()), nullptr, node.interpolated,
+                     writeText);
+}
+
+template <typename WriteText>
+void EncodeNode(ByteWriter& out, IdWriter& ids, NodeId id, const RenderShapeNode& node, WriteText&&) {
+    EncodeCommon(out, ids, id, CommonFields(node), false, node);
+}
+
+template <typename WriteText>
+void EncodeNode(ByteWriter& out, IdWriter& ids, NodeId id, const RenderShapeRectNode& node, WriteText&&) {
+    const std::uint32_t fields =
+        CommonFields(node) | kFieldWidth | kFieldHeight | (node.interpolated ? kFieldInterpolation : 0u);
+    EncodeCommon(out, ids, id, fields, false, node);
+    EncodeRectFields(out, fields, node.width, node.height, nullptr, node.interpolated);
+}
+
+// Keyframe block of every render node of type T
+template <typename T, typename WriteText>
+void EncodeNodes(ByteWriter& out, RenderContext& ctx, CaptureRecordType type, WriteText&& writeText) {
+    using Node = typename RenderNodeTraits<T>::RenderNodeType;
+    std::size_t count = 0;
+    ctx.ForEachRenderNode<T>([&count](NodeId, const Node&) { ++count; });
+    if (count == 0) {
+        return;
+    }
+    out.Raw(type);
+    out.Varint(count);
+    IdWriter ids;
+    ctx.ForEachRenderNode<T>([&](NodeId id, const Node& node) { EncodeNode(out, ids, id, node, writeText); });
+}
+
+template <typename ReadText>
+bool DecodeFields(ByteReader& in, ContainerNodeData& record, std::uint64_t indexLimit, ReadText&&) {
+    if (!(record.dirtyFields & kFieldChildren)) {
+        return true;
+    }
+    std::uint64_t count = 0;
+    if (!in.Varint(count)) {
+        return false;
+    }
+    IdReader ids(indexLimit);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        NodeId child = 0;
+        if (!ids.Read(in, child)) {
+            return false;
+        }
+        record.children.push_back(child);
+    }
+    return true;
+}
+
+template <typename ReadText>
+bool DecodeFields(ByteReader& in, TextNodeData& record, std::uint64_t, ReadText&& readText) {
+    if ((record.dirtyFields & kFieldText) && !readText(in, record.text)) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldAnimations) && !DecodeAnimations(in, record.animations)) {
+        return false;
+    }
+    return !(record.dirtyFields & kFieldInterpolation) || ReadFlag(in, record.interpolated);
+}
+
+template <typename ReadText>
+bool DecodeFields(ByteReader&, ShapeNodeData&, std::uint64_t, ReadText&&) {
+    return true;
+}
+
+template <typename ReadText>
+bool DecodeFields(ByteReader& in, ShapeRectNodeData& record, std::uint64_t, ReadText&&) {
+    if ((record.dirtyFields & kFieldWidth) && !ReadQuantized(in, record.width)) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldHeight) && !ReadQuantized(in, record.height)) {
+        return false;
+    }
+    if ((record.dirtyFields & kFieldAnimations) && !DecodeAnimations(in, record.animations)) {
+        return false;
+    }
+    return !(record.dirtyFields & kFieldInterpolation) || ReadFlag(in, record.interpolated);
+}
+
+} // namespace
+
+// ---------------------------------
+// DisplayStreamServer
+// ---------------------------------
+
+void DisplayStreamServer::BeginFrame(RenderContext& ctx, const NodeIdAllocator& ids) {
+    const std::uint64_t indexLimit = ids.IndexLimit();
+    const std::uint64_t synced = m_sequence++;
+    m_streaming = false;
+    std::uint64_t connection = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_connected) {
+            return;
+        }
+        if (m_queued.size() + m_inFlight > kStreamMaxBacklog) {
+            ++m_stats.droppedFrames;
+            m_needKeyframe = true;
+            return;
+        }
+        connection = m_connection;
+    }
+    if (connection != m_frameConnection) {
+        m_frameConnection = connection;
+        m_needKeyframe = true;
+    }
+    m_frame.clear();
+    if (m_needKeyframe || (m_keyframeInterval > 0 && m_sinceKeyframe >= m_keyframeInterval)) {
+        // The tree before this Sync; this Sync's delta follows
+        BeginMessage(kStreamKeyframe, synced, indexLimit);
+        WriteKeyframe(ctx, ids);
+        EndMessage(kStreamKeyframe);
+        m_needKeyframe = false;
+        m_sinceKeyframe = 0;
+    }
+    ++m_sinceKeyframe;
+    BeginMessage(kStreamDelta, m_sequence, indexLimit);
+    m_streaming = true;
+}
+
+void DisplayStreamServer::BeginMessage(StreamMessageKind kind, std::uint64_t sequence, std::uint64_t indexLimit) {
+    m_messageStart = m_frame.size();
+    m_messageRecords = 0;
+    ByteWriter out(m_frame);
+    out.Raw(std::uint32_t{0});  // payload size, set by EndMessage
+    out.Raw(kind);
+    out.Varint(sequence);
+    out.Varint(indexLimit);
+    out.Varint(m_root);
+}
+
+void DisplayStreamServer::EndMessage(StreamMessageKind kind) {
+    const std::size_t bytes = m_frame.size() - m_messageStart;
+    if (kind == kStreamDelta && m_messageRecords == 0) {
+        m_frame.resize(m_messageStart);  // nothing changed: nothing to send
+        return;
+    }
+    const auto payload = static_cast<std::uint32_t>(bytes - sizeof(std::uint32_t));
+    std::memcpy(m_frame.data() + m_messageStart, &payload, sizeof(payload));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (kind == kStreamDelta) {
+        m_stats.records += m_messageRecords;
+        m_stats.deltaBytes += bytes;
+    } else {
+        ++m_stats.keyframes;
+        m_stats.keyframeBytes += bytes;
+    }
+    ++m_stats.messages;
+}
+
+void DisplayStreamServer::WriteText(ByteWriter& out, std::string_view text) {
+    const auto found = m_strings.find(std::string(text));
+    if (found != m_strings.end()) {
+        out.Varint(found->second + 1);
+        return;
+    }
+    // 0 = literal; the viewer interns it by the same rule
+    out.Varint(0);
+    out.Varint(text.size());
+    out.Bytes(text.data(), text.size());
+    if (text.size() <= kStreamMaxInternedLength && m_strings.size() < kStreamMaxStrings) {
+        m_strings.emplace(std::string(text), static_cast<std::uint32_t>(m_strings.size()));
+    }
+}
+
+template <typename T>
+void DisplayStreamServer::WriteRecords(CaptureRecordType type,
+                                       const TrackedVector<T, MemoryTag::ChangeBuffer>& records) {
+    if (!m_streaming || records.empty()) {
+        return;
+    }
+    ByteWriter out(m_frame);
+    out.Raw(type);
+    out.Varint(records.size());
+    IdWriter ids;
+    const auto writeText = [this](ByteWriter& to, std::string_view text) { WriteText(to, text); };
+    for (const T& record : records) {
+        EncodeRecord(out, ids, record, writeText);
+    }
+    m_messageRecords += records.size();
+}
+
+void DisplayStreamServer::WriteKeyframe(RenderContext& ctx, const NodeIdAllocator& ids) {
+    TRACE_SCOPE_DETAIL("DisplayStream::Keyframe");
+    m_strings.clear();
+    ByteWriter out(m_frame);
+
+    // Generations, so the viewer applies deletions of any id the way this context does
+    std::vector<std::pair<std::uint64_t, std::uint16_t>> runs;
+    const std::uint64_t indexLimit = ids.IndexLimit();
+    for (std::uint64_t index = 0; index < indexLimit; ++index) {
+        const std::uint16_t generation = ids.GetGeneration(index);
+        if (runs.empty() || runs.back().second != generation) {
+            runs.emplace_back(0, generation);
+        }
+        ++runs.back().first;
+    }
+    out.Varint(runs.size());
+    for (const auto& [length, generation] : runs) {
+        out.Varint(length);
+        out.Varint(generation);
+    }
+
+    const auto writeText = [this](ByteWriter& to, std::string_view text) { WriteText(to, text); };
+    EncodeNodes<ContainerNodeData>(out, ctx, kCaptureContainers, writeText);
+    EncodeNodes<TextNodeData>(out, ctx, kCaptureTexts, writeText);
+    EncodeNodes<ShapeNodeData>(out, ctx, kCaptureShapes, writeText);
+    EncodeNodes<ShapeRectNodeData>(out, ctx, kCaptureRects, writeText);
+}
+
+void DisplayStreamServer::Write(const TrackedVector<ContainerNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureContainers, records);
+}
+
+void DisplayStreamServer::Write(const TrackedVector<TextNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureTexts, records);
+}
+
+void DisplayStreamServer::Write(const TrackedVector<ShapeNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureShapes, records);
+}
+
+void DisplayStreamServer::Write(const TrackedVector<ShapeRectNodeData, MemoryTag::ChangeBuffer>& records) {
+    WriteRecords(kCaptureRects, records);
+}
+
+void DisplayStreamServer::EndFrame() {
+    if (!m_streaming) {
+        return;
+    }
+    EndMessage(kStreamDelta);
+    m_streaming = false;
+    if (m_frame.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Messages for a viewer that has since been replaced are dropped;
+        // the next Sync starts the new one with a keyframe
+        if (!m_connected || m_connection != m_frameConnection) {
+            return;
+        }
+        m_queued.insert(m_queued.end(), m_frame.begin(), m_frame.end());
+    }
+    m_wake.notify_one();
+}
+
+DisplayStreamStats DisplayStreamServer::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// ---------------------------------
+// DisplayViewer
+// ---------------------------------
+
+DisplayViewer::DisplayViewer() = default;
+
+DisplayViewer::~DisplayViewer() {
+    Disconnect();
+}
+
+bool DisplayViewer::ReadText(ByteReader& in, TrackedString<MemoryTag::ChangeBuffer>& text) {
+    std::uint64_t ref = 0;
+    if (!in.Varint(ref)) {
+        return false;
+    }
+    if (ref > 0) {
+        if (ref > m_strings.size()) {
+            return false;
+        }
+        const std::string& interned = m_strings[static_cast<std::size_t>(ref - 1)];
+        text.assign(interned.data(), interned.size());
+        return true;
+    }
+    std::uint64_t length = 0;
+    const char* literal = in.Varint(length) ? in.Bytes(length) : nullptr;
+    if (!literal) {
+        return false;
+    }
+    text.assign(literal, static_cast<std::size_t>(length));
+    if (length <= kStreamMaxInternedLength && m_strings.size() < kStreamMaxStrings) {
+        m_strings.emplace_back(literal, static_cast<std::size_t>(length));
+    }
+    return true;
+}
+
+bool DisplayViewer::ReadGenerations(ByteReader& in, std::uint64_t indexLimit) {
+    m_generations.clear();
+    std::uint64_t runs = 0;
+    if (!in.Varint(runs)) {
+        return false;
+    }
+    for (std::uint64_t run = 0; run < runs; ++run) {
+        std::uint64_t length = 0;
+        std::uint64_t generation = 0;
+        if (!in.Varint(length) || !in.Varint(generation) || generation > 0xFFFF ||
+            length > indexLimit - m_generations.size()) {
+            return false;
+        }
+        m_generations.insert(m_generations.end(), static_cast<std::size_t>(length),
+                             static_cast<std::uint16_t>(generation));
+    }
+    return m_generations.size() == indexLimit;
+}
+
+template <typename T>
+bool DisplayViewer::ApplyRecords(ByteReader& in, std::uint64_t count, std::uint64_t indexLimit) {
+    IdReader ids(indexLimit);
+    const auto readText = [this](ByteReader& from, TrackedString<MemoryTag::ChangeBuffer>& text) {
+        return ReadText(from, text);
+    };
+    for (std::uint64_t i = 0; i < count; ++i) {
+        NodeId id = 0;
+        std::uint64_t flags = 0;
+        if (!ids.Read(in, id) || !in.Varint(flags) || flags >> 33 != 0) {
+            return false;
+        }
+        T& record = m_ctx->AccessData<T>(id);
+        record.dirtyFields = static_cast<std::uint32_t>(flags >> 1);
+        record.deleted = (flags & 1) != 0;
+        if (!DecodeCommon(in, record) || !DecodeFields(in, record, indexLimit, readText)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DisplayViewer::Apply(const unsigned char* payload, std::size_t size) {
+    TRACE_SCOPE_DETAIL("DisplayViewer::Apply");
+    ByteReader in(payload, size);
+    std::uint8_t kind = 0;
+    std::uint64_t sequence = 0;
+    std::uint64_t indexLimit = 0;
+    NodeId root = 0;
+    if (!in.Raw(kind) || !in.Varint(sequence) || !in.Varint(indexLimit) || !in.Varint(root) ||
+        indexLimit > NodeIdAllocator::kMaxIndex) {
+        return false;
+    }
+    if (kind == kStreamKeyframe) {
+        m_ctx = std::make_unique<RenderContext>();
+        m_strings.clear();
+        ++m_keyframes;
+        if (!ReadGenerations(in, indexLimit) || !m_ctx->RestoreIds(m_generations)) {
+            return false;
+        }
+    } else if (kind != kStreamDelta || !m_ctx) {
+        return false;  // a server starts every connection with a keyframe
+    }
+    m_ctx->ReserveIds(indexLimit);
+
+    bool ok = true;
+    while (ok && !in.AtEnd()) {
+        std::uint8_t type = 0;
+        std::uint64_t count = 0;
+        if (!in.Raw(type) || !in.Varint(count)) {
+            ok = false;
+            break;
+        }
+        switch (type) {
+            case kCaptureContainers:
+                ok = ApplyRecords<ContainerNodeData>(in, count, indexLimit);
+                break;
+            case kCaptureTexts:
+                ok = ApplyRecords<TextNodeData>(in, count, indexLimit);
+                break;
+            case kCaptureShapes:
+                ok = ApplyRecords<ShapeNodeData>(in, count, indexLimit);
+                break;
+            case kCaptureRects:
+                ok = ApplyRecords<ShapeRectNodeData>(in, count, indexLimit);
+                break;
+            default:
+                ok = false;
+                break;
+        }
+    }
+    // Whatever was decoded is applied either way, so the context stays consistent
+    m_ctx->Sync();
+    m_root = root;
+    m_sequence = sequence;
+    ++m_messages;
+    return ok;
+}
+
+#ifdef _WIN32
+
+// Unix domain sockets only
+bool DisplayStreamServer::Listen(const std::string&, NodeId, std::size_t) {
+    return false;
+}
+
+DisplayStreamServer::~DisplayStreamServer() = default;
+
+void DisplayStreamServer::SendLoop() {}
+
+bool DisplayStreamServer::AcceptViewer() {
+    return false;
+}
+
+bool DisplayStreamServer::SendAll(const std::vector<unsigned char>&) {
+    return false;
+}
+
+void DisplayStreamServer::CloseViewer() {}
+
+bool DisplayViewer::Connect(const std::string&) {
+    return false;
+}
+
+bool DisplayViewer::Poll(std::chrono::milliseconds) {
+    return false;
+}
+
+void DisplayViewer::Disconnect() {}
+
+#else
+
+namespace {
+
+// A closed viewer must not kill the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool SocketAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+bool SetNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+bool DisplayStreamServer::Listen(const std::string& path, NodeId root, std::size_t keyframeInterval) {
+    sockaddr_un address;
+    if (m_listener >= 0 || !SocketAddress(path, address)) {
+        return false;
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 4) != 0 ||
+        !SetNonBlocking(fd)) {
+        ::close(fd);
+        return false;
+    }
+    m_listener = fd;
+    m_path = path;
+    m_root = root;
+    m_keyframeInterval = keyframeInterval;
+    m_sender = std::thread([this]() { SendLoop(); });
+    return true;
+}
+
+DisplayStreamServer::~DisplayStreamServer() {
+    if (m_sender.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_sender.join();
+    }
+    CloseViewer();
+    if (m_listener >= 0) {
+        ::close(m_listener);
+        ::unlink(m_path.c_str());
+    }
+}
+
+void DisplayStreamServer::SendLoop() {
+    TraceProfiler::Instance().RegisterThread("display_stream");
+    std::vector<unsigned char> sending;
+    for (;;) {
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_inFlight = 0;
+            stopping = m_stop;
+            if (m_queued.empty()) {
+                if (stopping) {
+                    return;
+                }
+                m_wake.wait_for(lock, kSenderPollInterval);
+            }
+            sending.swap(m_queued);
+            m_inFlight = sending.size();
+        }
+        if (!stopping && AcceptViewer()) {
+            sending.clear();  // queued for the previous viewer
+            continue;
+        }
+        if (!sending.empty()) {
+            TRACE_SCOPE_DETAIL("DisplayStream::Send");
+            if (!SendAll(sending)) {
+                CloseViewer();
+            }
+            sending.clear();
+        }
+    }
+}
+
+// A new viewer replaces the current one
+bool DisplayStreamServer::AcceptViewer() {
+    bool accepted = false;
+    for (;;) {
+        const int fd = ::accept(m_listener, nullptr, nullptr);
+        if (fd < 0) {
+            return accepted;
+        }
+        if (!SetNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        CloseViewer();
+        m_viewer = fd;
+        accepted = true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_connection;
+        ++m_stats.viewers;
+        m_connected = true;
+    }
+}
+
+// Blocks while the viewer's socket is full, but gives up for a new viewer
+// and, on shutdown, after kShutdownFlushPolls
+bool DisplayStreamServer::SendAll(const std::vector<unsigned char>& bytes) {
+    std::size_t sent = 0;
+    std::size_t stalledPolls = 0;
+    while (m_viewer >= 0 && sent < bytes.size()) {
+        const ssize_t result = ::send(m_viewer, bytes.data() + sent, bytes.size() - sent, kSendFlags);
+        if (result > 0) {
+            sent += static_cast<std::size_t>(result);
+            stalledPolls = 0;
+            continue;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return false;
+        }
+        pollfd ready[2] = {{m_viewer, POLLOUT, 0}, {m_listener, POLLIN, 0}};
+        if (::poll(ready, 2, static_cast<int>(kSenderPollInterval.count())) > 0) {
+            if (ready[1].revents & POLLIN) {
+                return false;
+            }
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop && ++stalledPolls >= kShutdownFlushPolls) {
+            return false;
+        }
+    }
+    return m_viewer >= 0;
+}
+
+void DisplayStreamServer::CloseViewer() {
+    if (m_viewer < 0) {
+        return;
+    }
+    ::close(m_viewer);
+    m_viewer = -1;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connected = false;
+    m_queued.clear();
+}
+
+bool DisplayViewer::Connect(const std::string& path) {
+    Disconnect();
+    sockaddr_un address;
+    if (!SocketAddress(path, address)) {
+        return false;
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || !SetNonBlocking(fd)) {
+        ::close(fd);
+        return false;
+    }
+    m_socket = fd;
+    return true;
+}
+
+bool DisplayViewer::Poll(std::chrono::milliseconds timeout) {
+    if (m_socket < 0) {
+        return false;
+    }
+    pollfd ready{m_socket, POLLIN, 0};
+    if (::poll(&ready, 1, static_cast<int>(timeout.count())) <= 0) {
+        return true;
+    }
+
+    bool closed = false;
+    for (;;) {
+        const std::size_t used = m_inbox.size();
+        m_inbox.resize(used + kReceiveChunk);
+        const ssize_t received = ::recv(m_socket, m_inbox.data() + used, kReceiveChunk, 0);
+        m_inbox.resize(used + static_cast<std::size_t>(std::max<ssize_t>(received, 0)));
+        if (received > 0) {
+            m_bytes += static_cast<std::uint64_t>(received);
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+
+    std::size_t offset = 0;
+    while (m_inbox.size() - offset >= sizeof(std::uint32_t)) {
+        std::uint32_t payload = 0;
+        std::memcpy(&payload, m_inbox.data() + offset, sizeof(payload));
+        if (payload > kMaxMessageBytes) {
+            Disconnect();
+            return false;
+        }
+        if (m_inbox.size() - offset - sizeof(payload) < payload) {
+            break;
+        }
+        if (!Apply(m_inbox.data() + offset + sizeof(payload), payload)) {
+            Disconnect();
+            return false;
+        }
+        offset += sizeof(payload) + payload;
+    }
+    m_inbox.erase(m_inbox.begin(), m_inbox.begin() + static_cast<std::ptrdiff_t>(offset));
+    if (closed) {
+        Disconnect();
+        return false;
+    }
+    return true;
+}
+
+void DisplayViewer::Disconnect() {
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+    m_socket = -1;
+    m_inbox.clear();
+}
+
+#endif
+
+// ---------------------------------
+// RenderContext display stream control
+// ---------------------------------
+
+bool RenderContext::StartDisplayStream(const std::string& path, NodeId root, std::size_t keyframeInterval) {
+    auto stream = std::make_unique<DisplayStreamServer>();
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (m_displayStream || !stream->Listen(path, root, keyframeInterval)) {
+        return false;
+    }
+    m_displayStream = std::move(stream);
+    return true;
+}
+
+DisplayStreamStats RenderContext::StopDisplayStream() {
+    std::unique_ptr<DisplayStreamServer> stream;
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        stream = std::move(m_displayStream);
+    }
+    return stream ? stream->Stats() : DisplayStreamStats{};
+}
+
+} // namespace ui
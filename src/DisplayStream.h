@@ -0,0 +1,191 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "ByteStream.h"
+#include "ChangeCapture.h"
+#include "MemoryStats.h"
+#include "NodeData.h"
+#include "NodeIdAllocator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ui {
+
+class RenderContext;
+
+// ---------------------------------
+// Display stream: a live copy of a context's render tree for a viewer in
+// another process, over a Unix domain socket. After each Sync the server
+// sends the records that Sync applied as one delta message; the viewer
+// applies them to a context of its own. Positions and sizes are quantized
+// to 1 / kStreamPositionScale px, texts are interned and ids are sent as
+// index deltas, so a message costs a few bytes per changed field.
+//
+// A keyframe resends the whole render tree (as it was before the Sync)
+// every keyframeInterval Syncs, when a viewer connects and after frames
+// were dropped for a viewer that fell behind; the viewer starts over from
+// an empty context on each. Animations a keyframe finds running are not
+// in it: the viewer shows those nodes where they were at the keyframe.
+//
+// Message: u32 payload bytes, then the payload: a StreamMessageKind byte,
+// varint sequence (Syncs streamed so far), varint index limit, varint root
+// id; a keyframe then has the generation of every index below the limit
+// as a varint run count and (varint length, varint generation) runs. Then
+// blocks as in a capture: CaptureRecordType byte, varint record count,
+// records. Record: varint zigzag index delta from the block's
+// previous record, varint generation, varint dirtyFields << 1 | deleted,
+// then the dirty fields. Host byte order: the socket is local.
+// ---------------------------------
+
+enum StreamMessageKind : std::uint8_t {
+    kStreamKeyframe = 1,  // reset, then the tree; restarts the string table
+    kStreamDelta = 2,
+};
+
+inline constexpr float kStreamPositionScale = 16.0f;
+// Texts up to this length are interned, until the table is full
+inline constexpr std::size_t kStreamMaxInternedLength = 256;
+inline constexpr std::size_t kStreamMaxStrings = std::size_t{1} << 16;
+// Queued bytes beyond which a viewer misses frames (and gets a keyframe once caught up)
+inline constexpr std::size_t kStreamMaxBacklog = std::size_t{8} << 20;
+
+struct DisplayStreamStats {
+    std::uint64_t viewers = 0;        // connections accepted
+    std::uint64_t messages = 0;
+    std::uint64_t keyframes = 0;
+    std::uint64_t records = 0;        // in deltas
+    std::uint64_t deltaBytes = 0;     // encoded, framing included
+    std::uint64_t keyframeBytes = 0;
+    std::uint64_t droppedFrames = 0;  // Syncs a connected viewer missed (backlog full)
+};
+
+// Sending side, owned by a RenderContext between StartDisplayStream and
+// StopDisplayStream. Sync calls it under the render mutex and only queues
+// what it encodes (nothing while no viewer is connected); a thread of its
+// own accepts the viewer and does the blocking sends.
+class DisplayStreamServer {
+public:
+    DisplayStreamServer() = default;
+    ~DisplayStreamServer();
+
+    DisplayStreamServer(const DisplayStreamServer&) = delete;
+    DisplayStreamServer& operator=(const DisplayStreamServer&) = delete;
+
+    // Listen on `path` (replacing a stale socket file); keyframeInterval 0 =
+    // keyframes only when needed. False where Unix sockets are unavailable.
+    bool Listen(const std::string& path, NodeId root, std::size_t keyframeInterval);
+
+    // One Sync; `ctx` and its id allocator `ids` are read for a keyframe
+    void BeginFrame(RenderContext& ctx, const NodeIdAllocator& ids);
+    // Records of one type, in the order they are applied
+    void Write(const TrackedVector<ContainerNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<TextNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<ShapeNodeData, MemoryTag::ChangeBuffer>& records);
+    void Write(const TrackedVector<ShapeRectNodeData, MemoryTag::ChangeBuffer>& records);
+    void EndFrame();
+
+    DisplayStreamStats Stats();
+
+private:
+    template <typename T>
+    void WriteRecords(CaptureRecordType type, const TrackedVector<T, MemoryTag::ChangeBuffer>& records);
+    void WriteKeyframe(RenderContext& ctx, const NodeIdAllocator& ids);
+    void BeginMessage(StreamMessageKind kind, std::uint64_t sequence, std::uint64_t indexLimit);
+    void EndMessage(StreamMessageKind kind);
+    void WriteText(ByteWriter& out, std::string_view text);
+
+    // Sender thread
+    void SendLoop();
+    bool AcceptViewer();
+    bool SendAll(const std::vector<unsigned char>& bytes);
+    void CloseViewer();
+
+    std::string m_path;
+    NodeId m_root = 0;
+    std::size_t m_keyframeInterval = 0;
+    int m_listener = -1;
+
+    // Sync side
+    bool m_needKeyframe = true;
+    bool m_streaming = false;          // this Sync's messages are being encoded
+    std::uint64_t m_frameConnection = 0;  // the viewer they are for
+    std::size_t m_sinceKeyframe = 0;   // Syncs
+    std::uint64_t m_sequence = 0;
+    std::vector<unsigned char> m_frame;  // this Sync's messages
+    std::size_t m_messageStart = 0;      // in m_frame, of the open message
+    std::uint64_t m_messageRecords = 0;
+    std::unordered_map<std::string, std::uint32_t> m_strings;
+
+    // Shared with the sender thread
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<unsigned char> m_queued;  // messages not yet taken by the sender
+    std::size_t m_inFlight = 0;           // bytes the sender is writing
+    std::uint64_t m_connection = 0;       // counts viewers; 0 = none yet
+    bool m_connected = false;
+    bool m_stop = false;
+    DisplayStreamStats m_stats;
+
+    int m_viewer = -1;  // sender thread only
+    std::thread m_sender;
+};
+
+// Receiving side: connects to a server and mirrors its render tree in a
+// context of its own, replaced on every keyframe
+class DisplayViewer {
+public:
+    DisplayViewer();
+    ~DisplayViewer();
+
+    DisplayViewer(const DisplayViewer&) = delete;
+    DisplayViewer& operator=(const DisplayViewer&) = delete;
+
+    // False if nothing listens on `path` (yet)
+    bool Connect(const std::string& path);
+
+    // Wait up to `timeout` for data, then apply every complete message
+    // received (each one Sync of Context()). False once the server closed
+    // the connection or sent a malformed message.
+    bool Poll(std::chrono::milliseconds timeout);
+
+    // Null until the first keyframe; changes identity on every keyframe.
+    // Render thread use as any context: under its render mutex.
+    RenderContext* Context() { return m_ctx.get(); }
+    NodeId Root() const { return m_root; }
+    std::uint64_t Sequence() const { return m_sequence; }
+
+    std::uint64_t Messages() const { return m_messages; }
+    std::uint64_t Keyframes() const { return m_keyframes; }
+    std::uint64_t BytesReceived() const { return m_bytes; }
+
+private:
+    bool Apply(const unsigned char* payload, std::size_t size);
+    template <typename T>
+    bool ApplyRecords(ByteReader& in, std::uint64_t count, std::uint64_t indexLimit);
+    bool ReadText(ByteReader& in, TrackedString<MemoryTag::ChangeBuffer>& text);
+    bool ReadGenerations(ByteReader& in, std::uint64_t indexLimit);
+    void Disconnect();
+
+    int m_socket = -1;
+    std::unique_ptr<RenderContext> m_ctx;
+    NodeId m_root = 0;
+    std::uint64_t m_sequence = 0;
+    std::vector<unsigned char> m_inbox;  // received, starting at a message
+    std::vector<std::string> m_strings;
+    std::vector<std::uint16_t> m_generations;  // of a keyframe being applied
+    std::uint64_t m_messages = 0;
+    std::uint64_t m_keyframes = 0;
+    std::uint64_t m_bytes = 0;
+};
+
+} // namespace ui
@@ -0,0 +1,109 @@
+#include "FramePipeline.h"
+
+#include "TraceProfiler.h"
+
+namespace ui {
+
+FramePipeline::FramePipeline(std::size_t depth)
+    : m_depth(depth > 0 ? depth : 1) {}
+
+FrameId FramePipeline::BeginUpdate() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const FrameId frame = m_nextFrame;
+
+    auto canStart = [this, frame]() { return m_stopped || frame - m_lastAcquired <= m_depth; };
+    if (!canStart()) {
+        TRACE_SCOPE_DETAIL("FramePipeline::WaitBackpressure");
+        const auto begin = std::chrono::steady_clock::now();
+        m_updateCv.wait(lock, canStart);
+        ++m_stats.backpressureWaits;
+        m_stats.backpressureTime += std::chrono::steady_clock::now() - begin;
+    }
+
+    if (m_stopped) {
+        return 0;
+    }
+    ++m_nextFrame;
+    TRACE_COUNTER("frame.update", frame);
+    return frame;
+}
+
+void FramePipeline::PublishFrame(FrameId id) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (id <= m_lastPublished) {
+            return;
+        }
+        m_lastPublished = id;
+        ++m_stats.publishedFrames;
+    }
+    m_renderCv.notify_one();
+}
+
+FrameId FramePipeline::AcquireRenderFrame() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto hasFrame = [this]() { return m_stopped || m_lastPublished > m_lastAcquired; };
+    if (!hasFrame()) {
+        TRACE_SCOPE_DETAIL("FramePipeline::WaitFrame");
+        const auto begin = std::chrono::steady_clock::now();
+        m_renderCv.wait(lock, hasFrame);
+        m_stats.renderIdleTime += std::chrono::steady_clock::now() - begin;
+    }
+
+    if (m_stopped) {
+        return 0;
+    }
+    return TakeNewestFrame(lock);
+}
+
+FrameId FramePipeline::TryAcquireRenderFrame() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopped || m_lastPublished <= m_lastAcquired) {
+        return 0;
+    }
+    return TakeNewestFrame(lock);
+}
+
+FrameId FramePipeline::TakeNewestFrame(std::unique_lock<std::mutex>& lock) {
+    // Take the newest frame; anything in between is superseded
+    const FrameId frame = m_lastPublished;
+    m_stats.coalescedFrames += frame - m_lastAcquired - 1;
+    m_lastAcquired = frame;
+    m_renderBusy = true;
+    lock.unlock();
+
+    // Acquiring a frame frees pipeline slots for the update side
+    m_updateCv.notify_one();
+    TRACE_COUNTER("frame.render", frame);
+    return frame;
+}
+
+void FramePipeline::ReleaseRenderFrame(FrameId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id == m_lastAcquired && m_renderBusy) {
+        m_renderBusy = false;
+        ++m_stats.renderedFrames;
+    }
+}
+
+void FramePipeline::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_updateCv.notify_all();
+    m_renderCv.notify_all();
+}
+
+bool FramePipeline::IsStopped() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stopped;
+}
+
+FramePipeline::Stats FramePipeline::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+} // namespace ui
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace ui {
+
+// Monotonic frame number; 0 means "no frame" (pipeline stopped)
+using FrameId = std::uint64_t;
+
+// ---------------------------------
+// FramePipeline: two-stage frame handoff
+// Update thread builds frame N+1 (Update + Sync) while the render thread
+// collects and submits frame N. The update side may run at most `depth`
+// frames ahead of the frame the renderer last picked up; beyond that it
+// blocks (backpressure). The render side always takes the newest published
+// frame, so frames published while it was busy are coalesced.
+// ---------------------------------
+
+class FramePipeline {
+public:
+    struct Stats {
+        std::uint64_t publishedFrames = 0;
+        std::uint64_t renderedFrames = 0;
+        std::uint64_t coalescedFrames = 0;   // published but never rendered
+        std::uint64_t backpressureWaits = 0; // times BeginUpdate blocked
+        std::chrono::nanoseconds backpressureTime{0};
+        std::chrono::nanoseconds renderIdleTime{0};  // render waiting for a new frame
+    };
+
+    explicit FramePipeline(std::size_t depth = 1);
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Update thread: id of the next frame to build; blocks under backpressure.
+    // Returns 0 once stopped.
+    FrameId BeginUpdate();
+
+    // Update thread: frame `id` is synced and may be rendered
+    void PublishFrame(FrameId id);
+
+    // Render thread: newest published frame not rendered yet; blocks until
+    // one exists. Returns 0 once stopped.
+    FrameId AcquireRenderFrame();
+
+    // Render thread: the same without blocking; 0 if no new frame was
+    // published (or once stopped), for a render loop paced on its own
+    FrameId TryAcquireRenderFrame();
+
+    // Render thread: submission of frame `id` finished
+    void ReleaseRenderFrame(FrameId id);
+
+    // Wake both sides and make every wait return 0
+    void Stop();
+    bool IsStopped() const;
+
+    std::size_t Depth() const { return m_depth; }
+    Stats GetStats() const;
+
+private:
+    // Take the newest published frame (one exists); unlocks `lock`
+    FrameId TakeNewestFrame(std::unique_lock<std::mutex>& lock);
+
+    const std::size_t m_depth;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_updateCv;
+    std::condition_variable m_renderCv;
+
+    FrameId m_nextFrame = 1;
+    FrameId m_lastPublished = 0;
+    FrameId m_lastAcquired = 0;  // frame currently or last rendered
+    bool m_renderBusy = false;
+    bool m_stopped = false;
+
+    Stats m_stats;
+};
+
+} // namespace ui
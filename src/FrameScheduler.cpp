@@ -0,0 +1,92 @@
+#include "FrameScheduler.h"
+
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace ui {
+
+namespace {
+
+constexpr auto kMinSpinWindow = std::chrono::microseconds(50);
+constexpr auto kMaxSpinWindow = std::chrono::milliseconds(4);
+constexpr auto kInitialSpinWindow = std::chrono::milliseconds(1);
+
+} // namespace
+
+FrameScheduler::FrameScheduler(const FrameSchedulerConfig& config)
+    : m_config(config)
+    , m_spinWindow(kInitialSpinWindow) {
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_FRAME
+    if (m_config.missedCounterName) {
+        m_missedCounterId =
+            TraceProfiler::Instance().RegisterScope(m_config.missedCounterName, __FILE__, __LINE__, "counter");
+    }
+#endif
+    SetRate(m_config.hz);
+}
+
+void FrameScheduler::SetRate(double hz) {
+    m_config.hz = hz;
+    m_period = hz > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz))
+                        : Clock::duration::zero();
+    Reset();
+}
+
+void FrameScheduler::Reset() {
+    m_next = Clock::now() + m_period;
+}
+
+void FrameScheduler::WaitForNextFrame() {
+    ++m_frames;
+    if (m_period == Clock::duration::zero()) {
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    if (now > m_next) {
+        ++m_missed;
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_FRAME
+        if (m_config.missedCounterName) {
+            TraceProfiler::Instance().RecordCounter(m_missedCounterId, static_cast<std::int64_t>(m_missed));
+        }
+#endif
+        const auto behind = static_cast<std::uint64_t>((now - m_next) / m_period);
+        if (m_config.policy == MissPolicy::CatchUp && behind < m_config.maxCatchUpFrames) {
+            // Start the late frame right away; the grid stays where it was
+            m_next += m_period;
+            return;
+        }
+
+        // Drop every slot that already passed and wait for the next one
+        m_skipped += behind + 1;
+        m_next += m_period * static_cast<Clock::rep>(behind + 1);
+    }
+
+    SleepUntil(m_next);
+    m_wakeLateness.Add(Clock::now() - m_next);
+    m_next += m_period;
+}
+
+void FrameScheduler::SleepUntil(Clock::time_point deadline) {
+    TRACE_SCOPE_DETAIL("FrameScheduler::Wait");
+
+    // Coarse sleep up to the spin window, then measure the OS oversleep
+    const Clock::time_point wakeTarget = deadline - m_spinWindow;
+    if (Clock::now() < wakeTarget) {
+        std::this_thread::sleep_until(wakeTarget);
+        const Clock::duration oversleep = Clock::now() - wakeTarget;
+
+        // Window follows ~2x the recent oversleep (EMA, 1/8 weight)
+        const Clock::duration target = std::clamp<Clock::duration>(
+            oversleep * 2, kMinSpinWindow, kMaxSpinWindow);
+        m_spinWindow += (target - m_spinWindow) / 8;
+    }
+
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace ui
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "WaitHistogram.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ui {
+
+// What to do when a frame's work runs past the next frame's deadline
+enum class MissPolicy {
+    Skip,     // drop the missed slots and wait for the next slot on the grid
+    CatchUp   // start the missed frames back to back (bounded by maxCatchUpFrames)
+};
+
+struct FrameSchedulerConfig {
+    double hz = 60.0;  // 0 = unthrottled (WaitForNextFrame returns at once)
+    MissPolicy policy = MissPolicy::Skip;
+    std::size_t maxCatchUpFrames = 4;  // CatchUp: beyond this lag, realign instead
+    // Profiler counter series for missed deadlines; string literal or null
+    const char* missedCounterName = nullptr;
+};
+
+// ---------------------------------
+// FrameScheduler: paces a loop on an absolute deadline grid
+// Frame k starts at start + k * period regardless of how long earlier
+// frames took, so the rate does not drift. Waiting sleeps until shortly
+// before the deadline and spins (yielding) for the rest; the spin window
+// adapts to the observed oversleep of the OS timer.
+// ---------------------------------
+
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameScheduler(const FrameSchedulerConfig& config);
+
+    // End of a frame: block until the next frame's deadline (or return at
+    // once when the deadline was missed and the policy says run now)
+    void WaitForNextFrame();
+
+    // Restart the grid at now (e.g. after a pause)
+    void Reset();
+
+    void SetRate(double hz);
+    double Rate() const { return m_config.hz; }
+
+    std::uint64_t Frames() const { return m_frames; }
+    std::uint64_t MissedDeadlines() const { return m_missed; }
+    std::uint64_t SkippedFrames() const { return m_skipped; }
+
+    // How late each wakeup was relative to its deadline
+    const WaitHistogram& WakeLateness() const { return m_wakeLateness; }
+
+private:
+    void SleepUntil(Clock::time_point deadline);
+
+    FrameSchedulerConfig m_config;
+    Clock::duration m_period{};
+    Clock::time_point m_next{};
+    Clock::duration m_spinWindow{};
+
+    std::uint64_t m_frames = 0;
+    std::uint64_t m_missed = 0;
+    std::uint64_t m_skipped = 0;
+    std::uint16_t m_missedCounterId = 0;
+    WaitHistogram m_wakeLateness;
+};
+
+} // namespace ui
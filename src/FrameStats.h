@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ui {
+
+// Collects per-frame durations and reports their distribution
+class FrameTimeStats {
+public:
+    void Add(std::chrono::nanoseconds sample) {
+        m_samples.push_back(sample.count());
+        m_sorted = false;
+    }
+
+    void Clear() {
+        m_samples.clear();
+        m_sorted = true;
+    }
+
+    std::size_t Count() const { return m_samples.size(); }
+
+    std::chrono::nanoseconds Total() const {
+        std::int64_t sum = 0;
+        for (std::int64_t s : m_samples) {
+            sum += s;
+        }
+        return std::chrono::nanoseconds(sum);
+    }
+
+    // p in [0, 100]; nearest-rank percentile
+    std::chrono::nanoseconds Percentile(double p) {
+        if (m_samples.empty()) {
+            return std::chrono::nanoseconds(0);
+        }
+        Sort();
+        const double rank = (p / 100.0) * static_cast<double>(m_samples.size() - 1);
+        const std::size_t index = std::min(m_samples.size() - 1, static_cast<std::size_t>(rank + 0.5));
+        return std::chrono::nanoseconds(m_samples[index]);
+    }
+
+    std::chrono::nanoseconds Mean() const {
+        if (m_samples.empty()) {
+            return std::chrono::nanoseconds(0);
+        }
+        return Total() / static_cast<std::int64_t>(m_samples.size());
+    }
+
+    // One line: name, count, mean, min, p50, p90, p99, max (milliseconds)
+    std::string Format(const std::string& name) {
+        std::ostringstream out;
+        out << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(3)
+            << " n=" << std::setw(7) << Count()
+            << " mean=" << std::setw(9) << ToMs(Mean())
+            << " min=" << std::setw(9) << ToMs(Percentile(0.0))
+            << " p50=" << std::setw(9) << ToMs(Percentile(50.0))
+            << " p90=" << std::setw(9) << ToMs(Percentile(90.0))
+            << " p99=" << std::setw(9) << ToMs(Percentile(99.0))
+            << " max=" << std::setw(9) << ToMs(Percentile(100.0)) << " ms";
+        return out.str();
+    }
+
+private:
+    static double ToMs(std::chrono::nanoseconds ns) { return static_cast<double>(ns.count()) / 1.0e6; }
+
+    void Sort() {
+        if (!m_sorted) {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+    }
+
+    std::vector<std::int64_t> m_samples;
+    bool m_sorted = true;
+};
+
+} // namespace ui
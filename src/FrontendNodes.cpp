@@ -4,13 +4,20 @@
 #include "BackendShapeNode.h"
 #include "BackendShapeRectNode.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace ui {
 
-std::unique_ptr<FrontendContainer> FrontendContainer::Create(NodeId id) {
-    auto backend = std::make_unique<BackendContainerNode>(id);
+std::unique_ptr<FrontendContainer> FrontendContainer::Create(RenderContext& ctx, NodeId id) {
+    auto backend = std::make_unique<BackendContainerNode>(ctx, id);
     return std::make_unique<FrontendContainer>(std::move(backend));
 }
 
+std::unique_ptr<FrontendContainer> FrontendContainer::Create(NodeId id) {
+    return Create(RenderContext::Instance(), id);
+}
+
 FrontendContainer::FrontendContainer(std::unique_ptr<BackendContainerNode> backend)
     : FrontendNode(std::move(backend))
     , m_containerBackend(static_cast<BackendContainerNode*>(FrontendNode::m_backend.get())) {}
@@ -21,11 +28,15 @@ void FrontendContainer::AddChild(FrontendNode* child) {
     }
 }
 
-std::unique_ptr<FrontendText> FrontendText::Create(NodeId id) {
-    auto backend = std::make_unique<BackendTextNode>(id);
+std::unique_ptr<FrontendText> FrontendText::Create(RenderContext& ctx, NodeId id) {
+    auto backend = std::make_unique<BackendTextNode>(ctx, id);
     return std::make_unique<FrontendText>(std::move(backend));
 }
 
+std::unique_ptr<FrontendText> FrontendText::Create(NodeId id) {
+    return Create(RenderContext::Instance(), id);
+}
+
 FrontendText::FrontendText(std::unique_ptr<BackendTextNode> backend)
     : FrontendNode(std::move(backend))
     , m_textBackend(static_cast<BackendTextNode*>(FrontendNode::m_backend.get())) {}
@@ -36,20 +47,40 @@ void FrontendText::SetText(const std::string& text) {
     }
 }
 
-std::unique_ptr<FrontendShape> FrontendShape::Create(NodeId id) {
-    auto backend = std::make_unique<BackendShapeNode>(id);
+void FrontendText::SetInterpolated(bool interpolated) {
+    if (m_textBackend) {
+        m_textBackend->SetInterpolated(interpolated);
+    }
+}
+
+void FrontendText::Animate(AnimationSpec spec) {
+    if (m_textBackend) {
+        m_textBackend->Animate(std::move(spec));
+    }
+}
+
+std::unique_ptr<FrontendShape> FrontendShape::Create(RenderContext& ctx, NodeId id) {
+    auto backend = std::make_unique<BackendShapeNode>(ctx, id);
     return std::make_unique<FrontendShape>(std::move(backend));
 }
 
+std::unique_ptr<FrontendShape> FrontendShape::Create(NodeId id) {
+    return Create(RenderContext::Instance(), id);
+}
+
 FrontendShape::FrontendShape(std::unique_ptr<BackendShapeNode> backend)
     : FrontendNode(std::move(backend))
     , m_shapeBackend(static_cast<BackendShapeNode*>(FrontendNode::m_backend.get())) {}
 
-std::unique_ptr<FrontendShapeRect> FrontendShapeRect::Create(NodeId id) {
-    auto backend = std::make_unique<BackendShapeRectNode>(id);
+std::unique_ptr<FrontendShapeRect> FrontendShapeRect::Create(RenderContext& ctx, NodeId id) {
+    auto backend = std::make_unique<BackendShapeRectNode>(ctx, id);
     return std::make_unique<FrontendShapeRect>(std::move(backend));
 }
 
+std::unique_ptr<FrontendShapeRect> FrontendShapeRect::Create(NodeId id) {
+    return Create(RenderContext::Instance(), id);
+}
+
 FrontendShapeRect::FrontendShapeRect(std::unique_ptr<BackendShapeRectNode> backend)
     : FrontendShape(std::unique_ptr<BackendShapeNode>(backend.release()))
     , m_shapeRectBackend(static_cast<BackendShapeRectNode*>(FrontendNode::m_backend.get())) {}
@@ -66,4 +97,187 @@ void FrontendShapeRect::SetHeight(float height) {
     }
 }
 
+void FrontendShapeRect::SetInterpolated(bool interpolated) {
+    if (m_shapeRectBackend) {
+        m_shapeRectBackend->SetInterpolated(interpolated);
+    }
+}
+
+void FrontendShapeRect::Animate(AnimationSpec spec) {
+    if (m_shapeRectBackend) {
+        m_shapeRectBackend->Animate(std::move(spec));
+    }
+}
+
+std::unique_ptr<FrontendVirtualList> FrontendVirtualList::Create(RenderContext& ctx, NodeId id,
+                                                              VirtualListSource source) {
+    auto backend = std::make_unique<BackendContainerNode>(ctx, id);
+    return std::make_unique<FrontendVirtualList>(std::move(backend), std::move(source));
+}
+
+std::unique_ptr<FrontendVirtualList> FrontendVirtualList::Create(NodeId id, VirtualListSource source) {
+    return Create(RenderContext::Instance(), id, std::move(source));
+}
+
+FrontendVirtualList::FrontendVirtualList(std::unique_ptr<BackendContainerNode> backend, VirtualListSource source)
+    : FrontendNode(std::move(backend))
+    , m_containerBackend(static_cast<BackendContainerNode*>(FrontendNode::m_backend.get()))
+    , m_source(std::move(source)) {}
+
+void FrontendVirtualList::SetPosition(float x, float y) {
+    FrontendNode::SetPosition(x, y);
+    m_x = x;
+    m_y = y;
+    for (Slot& slot : m_slots) {
+        slot.placed = false;
+    }
+    Layout();
+}
+
+void FrontendVirtualList::Term() {
+    for (Slot& slot : m_slots) {
+        slot.node->Term();
+    }
+    m_slots.clear();
+    m_containerBackend = nullptr;
+    FrontendNode::Term();
+}
+
+void FrontendVirtualList::SetItemCount(std::size_t count) {
+    m_itemCount = count;
+    m_scrollOffset = std::min(m_scrollOffset, MaxScrollOffset());
+    Layout();
+}
+
+void FrontendVirtualList::SetItemExtent(float extent) {
+    m_itemExtent = std::max(extent, 0.0f);
+    m_scrollOffset = std::min(m_scrollOffset, MaxScrollOffset());
+    for (Slot& slot : m_slots) {
+        slot.placed = false;
+    }
+    Layout();
+}
+
+void FrontendVirtualList::SetViewportExtent(float extent) {
+    m_viewportExtent = std::max(extent, 0.0f);
+    m_scrollOffset = std::min(m_scrollOffset, MaxScrollOffset());
+    Layout();
+}
+
+void FrontendVirtualList::SetScrollOffset(float offset) {
+    m_scrollOffset = std::clamp(offset, 0.0f, MaxScrollOffset());
+    Layout();
+}
+
+void FrontendVirtualList::SetOverscan(std::size_t rows) {
+    m_overscan = rows;
+    Layout();
+}
+
+void FrontendVirtualList::Refresh(std::size_t index) {
+    for (Slot& slot : m_slots) {
+        if (slot.index == index) {
+            Bind(slot, index);
+        }
+    }
+}
+
+void FrontendVirtualList::RefreshAll() {
+    for (Slot& slot : m_slots) {
+        if (slot.index != kNoItem) {
+            Bind(slot, slot.index);
+        }
+    }
+}
+
+float FrontendVirtualList::MaxScrollOffset() const {
+    const double length = static_cast<double>(m_itemCount) * static_cast<double>(m_itemExtent);
+    return static_cast<float>(std::max(length - static_cast<double>(m_viewportExtent), 0.0));
+}
+
+FrontendNode* FrontendVirtualList::ItemNode(std::size_t index) const {
+    for (const Slot& slot : m_slots) {
+        if (slot.index == index) {
+            return slot.node.get();
+        }
+    }
+    return nullptr;
+}
+
+void FrontendVirtualList::Bind(Slot& slot, std::size_t index) {
+    slot.index = index;
+    slot.placed = false;  // bind may have moved it
+    if (m_source.bind) {
+        m_source.bind(index, *slot.node);
+    }
+}
+
+std::size_t FrontendVirtualList::AddSlot() {
+    RenderContext& ctx = m_containerBackend->Context();
+    const NodeId id = ctx.AllocateNodeId();
+    Slot slot;
+    slot.node = m_source.create(ctx, id);
+    m_containerBackend->AddChild(slot.node->Backend());
+    m_slots.push_back(std::move(slot));
+    return m_slots.size() - 1;
+}
+
+void FrontendVirtualList::Layout() {
+    if (!m_containerBackend || !m_source.create) {
+        return;
+    }
+
+    // Visible rows [first, last), bound rows [bindFirst, bindLast)
+    std::size_t first = 0;
+    std::size_t last = 0;
+    if (m_itemExtent > 0.0f && m_viewportExtent > 0.0f) {
+        const auto row = [this](double rows) {
+            return rows >= static_cast<double>(m_itemCount) ? m_itemCount : static_cast<std::size_t>(rows);
+        };
+        first = row(std::floor(static_cast<double>(m_scrollOffset) / m_itemExtent));
+        last = row(std::ceil((static_cast<double>(m_scrollOffset) + m_viewportExtent) / m_itemExtent));
+    }
+    const std::size_t bindFirst = first - std::min(first, m_overscan);
+    const std::size_t bindLast = last > first ? last + std::min(m_overscan, m_itemCount - last) : bindFirst;
+
+    // Slots keep their item while it stays in the window; the rest are free
+    m_window.assign(bindLast - bindFirst, kNoItem);
+    m_free.clear();
+    for (std::size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[i];
+        if (slot.index != kNoItem && slot.index >= bindFirst && slot.index < bindLast) {
+            m_window[slot.index - bindFirst] = i;
+            continue;
+        }
+        slot.index = kNoItem;
+        if (slot.shown) {
+            slot.node->SetVisible(false);
+            slot.shown = false;
+        }
+        m_free.push_back(i);
+    }
+
+    std::size_t nextFree = 0;
+    for (std::size_t offset = 0; offset < m_window.size(); ++offset) {
+        std::size_t& slotIndex = m_window[offset];
+        if (slotIndex == kNoItem) {
+            slotIndex = nextFree < m_free.size() ? m_free[nextFree++] : AddSlot();
+            Bind(m_slots[slotIndex], bindFirst + offset);
+        }
+        Slot& slot = m_slots[slotIndex];
+        const std::size_t item = bindFirst + offset;
+        const float y = m_y + static_cast<float>(static_cast<double>(item) * m_itemExtent - m_scrollOffset);
+        if (!slot.placed || slot.y != y) {
+            slot.node->SetPosition(m_x, y);
+            slot.y = y;
+            slot.placed = true;
+        }
+        const bool shown = item >= first && item < last;
+        if (slot.shown != shown) {
+            slot.node->SetVisible(shown);
+            slot.shown = shown;
+        }
+    }
+}
+
 } // namespace ui
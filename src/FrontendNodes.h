@@ -1,13 +1,19 @@
 #pragma once
 
+#include "Animation.h"
 #include "TreeNode.h"
 #include "ui_ids.h"
 
+#include <cstddef>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Forward declarations
 namespace ui {
+    class RenderContext;
     class BackendContainerNode;
     class BackendTextNode;
     class BackendShapeNode;
@@ -28,7 +34,7 @@ public:
         Term();
     }
 
-    void SetPosition(float x, float y) {
+    virtual void SetPosition(float x, float y) {
         if (m_backend) {
             m_backend->SetPosition(x, y);
         }
@@ -40,7 +46,13 @@ public:
         }
     }
 
-    void Term() {
+    void SetLayer(std::int16_t layer) {
+        if (m_backend) {
+            m_backend->SetLayer(layer);
+        }
+    }
+
+    virtual void Term() {
         if (m_backend) {
             m_backend->Term();
             m_backend.reset();  // Delete backend node
@@ -56,6 +68,8 @@ protected:
 class FrontendContainer : public FrontendNode {
 public:
     // Factory method: creates backend and frontend, returns frontend
+    static std::unique_ptr<FrontendContainer> Create(RenderContext& ctx, NodeId id);
+    // Same, in the default RenderContext
     static std::unique_ptr<FrontendContainer> Create(NodeId id);
 
     explicit FrontendContainer(std::unique_ptr<BackendContainerNode> backend);
@@ -69,11 +83,15 @@ private:
 class FrontendText : public FrontendNode {
 public:
     // Factory method: creates backend and frontend, returns frontend
+    static std::unique_ptr<FrontendText> Create(RenderContext& ctx, NodeId id);
+    // Same, in the default RenderContext
     static std::unique_ptr<FrontendText> Create(NodeId id);
 
     explicit FrontendText(std::unique_ptr<BackendTextNode> backend);
 
     void SetText(const std::string& text);
+    void SetInterpolated(bool interpolated);
+    void Animate(AnimationSpec spec);
 
 private:
     BackendTextNode* m_textBackend;  // Cached pointer to BackendTextNode
@@ -82,6 +100,8 @@ private:
 class FrontendShape : public FrontendNode {
 public:
     // Factory method: creates backend and frontend, returns frontend
+    static std::unique_ptr<FrontendShape> Create(RenderContext& ctx, NodeId id);
+    // Same, in the default RenderContext
     static std::unique_ptr<FrontendShape> Create(NodeId id);
 
     explicit FrontendShape(std::unique_ptr<BackendShapeNode> backend);
@@ -93,15 +113,102 @@ private:
 class FrontendShapeRect : public FrontendShape {
 public:
     // Factory method: creates backend and frontend, returns frontend
+    static std::unique_ptr<FrontendShapeRect> Create(RenderContext& ctx, NodeId id);
+    // Same, in the default RenderContext
     static std::unique_ptr<FrontendShapeRect> Create(NodeId id);
 
     explicit FrontendShapeRect(std::unique_ptr<BackendShapeRectNode> backend);
 
     void SetWidth(float width);
     void SetHeight(float height);
+    void SetInterpolated(bool interpolated);
+    void Animate(AnimationSpec spec);
 
 private:
     BackendShapeRectNode* m_shapeRectBackend;  // Cached pointer to BackendShapeRectNode
 };
 
+// ---------------------------------
+// Virtualized list: a container of itemCount rows, itemExtent apart from
+// the list's position downwards, of which only the rows in the viewport
+// (viewportExtent from the scroll offset) plus `overscan` rows on each side
+// exist as nodes. Row nodes come from a pool that grows to the largest
+// window seen and never shrinks; scrolling moves and rebinds them, and
+// rows of the overscan are bound but hidden until they scroll in. Memory
+// and per-frame work depend on the window, not on itemCount.
+//
+// Nothing clips: a row partly in the viewport draws whole.
+// ---------------------------------
+
+struct VirtualListSource {
+    // Node for a new pool slot, created with `id` in `ctx`
+    std::function<std::unique_ptr<FrontendNode>(RenderContext& ctx, NodeId id)> create;
+    // Show item `index` in a slot's node; the list positions it afterwards
+    std::function<void(std::size_t index, FrontendNode& node)> bind;
+};
+
+class FrontendVirtualList : public FrontendNode {
+public:
+    // Factory method: creates backend and frontend, returns frontend
+    static std::unique_ptr<FrontendVirtualList> Create(RenderContext& ctx, NodeId id, VirtualListSource source);
+    // Same, in the default RenderContext
+    static std::unique_ptr<FrontendVirtualList> Create(NodeId id, VirtualListSource source);
+
+    FrontendVirtualList(std::unique_ptr<BackendContainerNode> backend, VirtualListSource source);
+
+    // Moves the rows along
+    void SetPosition(float x, float y) override;
+    // Terms the pool too
+    void Term() override;
+
+    void SetItemCount(std::size_t count);
+    void SetItemExtent(float extent);
+    void SetViewportExtent(float extent);
+    // Clamped to [0, MaxScrollOffset()]
+    void SetScrollOffset(float offset);
+    void SetOverscan(std::size_t rows);
+
+    // Bind item `index` again (if it has a node), or every bound item
+    void Refresh(std::size_t index);
+    void RefreshAll();
+
+    std::size_t ItemCount() const { return m_itemCount; }
+    float ScrollOffset() const { return m_scrollOffset; }
+    float MaxScrollOffset() const;
+    // Nodes in the pool, bound or not
+    std::size_t PoolSize() const { return m_slots.size(); }
+    // Node showing item `index`; null if the item is outside the window
+    FrontendNode* ItemNode(std::size_t index) const;
+
+private:
+    static constexpr std::size_t kNoItem = std::numeric_limits<std::size_t>::max();
+
+    struct Slot {
+        std::unique_ptr<FrontendNode> node;
+        std::size_t index = kNoItem;
+        float y = 0.0f;
+        bool placed = false;  // y is the node's position
+        bool shown = true;
+    };
+
+    // Rebind and reposition the pool for the current window
+    void Layout();
+    void Bind(Slot& slot, std::size_t index);
+    std::size_t AddSlot();
+
+    BackendContainerNode* m_containerBackend;  // Cached pointer to BackendContainerNode
+    VirtualListSource m_source;
+    float m_x = 0.0f;
+    float m_y = 0.0f;
+    std::size_t m_itemCount = 0;
+    float m_itemExtent = 0.0f;
+    float m_viewportExtent = 0.0f;
+    float m_scrollOffset = 0.0f;
+    std::size_t m_overscan = 2;
+    std::vector<Slot> m_slots;
+    // Layout scratch
+    std::vector<std::size_t> m_window;  // slot per item of the window
+    std::vector<std::size_t> m_free;    // unbound slots
+};
+
 } // namespace ui
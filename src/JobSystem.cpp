@@ -0,0 +1,206 @@
+#include "JobSystem.h"
+
+#include "TraceProfiler.h"
+
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+namespace ui {
+
+namespace {
+
+constexpr std::size_t kAutoWorkerCount = static_cast<std::size_t>(-1);
+std::atomic<std::size_t> g_defaultWorkerCount{kAutoWorkerCount};
+
+// Identity of the calling thread inside its owning JobSystem
+thread_local const JobSystem* t_owner = nullptr;
+thread_local std::size_t t_workerIndex = 0;
+
+// Spreads threads that are not workers over the injection queues
+std::atomic<std::size_t> g_nextInjectionTicket{0};
+thread_local const std::size_t t_injectionTicket = g_nextInjectionTicket.fetch_add(1, std::memory_order_relaxed);
+
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_DETAIL
+// Job names are string literals: one descriptor per name, cached per thread
+std::uint16_t JobScopeId(const char* name) {
+    thread_local std::unordered_map<const char*, std::uint16_t> cache;
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    static std::mutex mutex;
+    static std::unordered_map<const char*, std::uint16_t> ids;
+    std::uint16_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto shared = ids.find(name);
+        if (shared == ids.end()) {
+            shared = ids.emplace(name, TraceProfiler::Instance().RegisterScope(name, __FILE__, __LINE__, "jobs")).first;
+        }
+        id = shared->second;
+    }
+    cache.emplace(name, id);
+    return id;
+}
+#endif
+
+} // namespace
+
+JobSystem& JobSystem::Instance() {
+    static JobSystem instance([]() -> std::size_t {
+        const std::size_t configured = g_defaultWorkerCount.load();
+        if (configured != kAutoWorkerCount) {
+            return configured;
+        }
+        const unsigned hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 0;
+    }());
+    return instance;
+}
+
+void JobSystem::SetDefaultWorkerCount(std::size_t count) {
+    g_defaultWorkerCount.store(count);
+}
+
+JobSystem::JobSystem(std::size_t workerCount) {
+    m_queues.reserve(workerCount + kInjectionQueues);
+    for (std::size_t i = 0; i < workerCount + kInjectionQueues; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    m_workers.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop.store(true);
+    }
+    m_sleepCv.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::size_t JobSystem::CurrentQueue() const {
+    return t_owner == this ? t_workerIndex : m_workers.size() + t_injectionTicket % kInjectionQueues;
+}
+
+void JobSystem::Submit(Job job) {
+    // Count first: a thief may take the job as soon as it is in the queue
+    m_queuedJobs.fetch_add(1);
+    WorkerQueue& queue = *m_queues[CurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    // A worker counts itself asleep before checking m_queuedJobs, so either
+    // it sees this job or this sees it; the sleep mutex orders the notify
+    // after its check
+    if (m_sleepers.load() > 0) {
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_sleepCv.notify_one();
+    }
+}
+
+bool JobSystem::TryRunOne(const TaskGroup* group) {
+    Job job;
+    const std::size_t queue = CurrentQueue();
+    const bool found = (t_owner == this || group == nullptr) ? PopLocal(queue, job) || Steal(queue, job)
+                                                             : TakeGroupJob(queue, *group, job);
+    if (found) {
+        Execute(job);
+    }
+    return found;
+}
+
+bool JobSystem::PopLocal(std::size_t queue, Job& out) {
+    WorkerQueue& q = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.jobs.empty()) {
+        return false;
+    }
+    out = std::move(q.jobs.back());
+    q.jobs.pop_back();
+    m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::Steal(std::size_t thief, Job& out) {
+    const std::size_t count = m_queues.size();
+    for (std::size_t offset = 1; offset < count; ++offset) {
+        WorkerQueue& q = *m_queues[(thief + offset) % count];
+        std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || q.jobs.empty()) {
+            continue;
+        }
+        out = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::TakeGroupJob(std::size_t queue, const TaskGroup& group, Job& out) {
+    const std::size_t count = m_queues.size();
+    for (std::size_t offset = 0; offset < count; ++offset) {
+        WorkerQueue& q = *m_queues[(queue + offset) % count];
+        std::unique_lock<std::mutex> lock(q.mutex, std::defer_lock);
+        if (offset == 0) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            continue;
+        }
+        const auto found = std::find_if(q.jobs.rbegin(), q.jobs.rend(),
+                                        [&group](const Job& job) { return job.group == &group; });
+        if (found == q.jobs.rend()) {
+            continue;
+        }
+        out = std::move(*found);
+        q.jobs.erase(std::next(found).base());
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::Execute(Job& job) {
+    {
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_DETAIL
+        TraceScope scope(JobScopeId(job.name));
+#endif
+        job.fn();
+    }
+    if (job.group != nullptr) {
+        job.group->OnJobDone();
+    }
+}
+
+void JobSystem::WorkerLoop(std::size_t index) {
+    t_owner = this;
+    t_workerIndex = index;
+
+    const std::string name = "worker " + std::to_string(index);
+    TraceProfiler::Instance().RegisterThread(name.c_str());
+
+    while (!m_stop.load()) {
+        Job job;
+        if (PopLocal(index, job) || Steal(index, job)) {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepers.fetch_add(1);
+        m_sleepCv.wait(lock, [this]() { return m_stop.load() || m_queuedJobs.load() > 0; });
+        m_sleepers.fetch_sub(1);
+    }
+}
+
+} // namespace ui
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ui {
+
+class TaskGroup;
+
+// Unit of work; `name` must be a string literal (used as trace scope name)
+struct Job {
+    std::function<void()> fn;
+    TaskGroup* group = nullptr;
+    const char* name = "Job";
+};
+
+// ---------------------------------
+// JobSystem: work-stealing task scheduler
+// Each worker owns a deque: it pushes/pops at the back (LIFO, cache-warm),
+// idle workers steal from the front of other deques (FIFO, oldest = largest
+// work first). Threads that are not workers submit into one of
+// kInjectionQueues injection queues (picked per thread) and, while they wait
+// on a TaskGroup, help with that group's jobs only, so a waiter holding a
+// lock never runs another caller's work. With zero workers everything runs
+// on the waiting threads. Submit wakes a worker only if one is asleep.
+// ---------------------------------
+
+class JobSystem {
+public:
+    // Process-wide scheduler, created on first use
+    static JobSystem& Instance();
+
+    // Worker count used when Instance() is first called.
+    // Default: hardware_concurrency() - 1 (the caller is the extra thread).
+    static void SetDefaultWorkerCount(std::size_t count);
+
+    explicit JobSystem(std::size_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    std::size_t WorkerCount() const { return m_workers.size(); }
+
+    void Submit(Job job);
+
+    // Run one pending job on the calling thread; false if none was found.
+    // On a thread that is not a worker, `group` limits it to that group's jobs.
+    bool TryRunOne(const TaskGroup* group = nullptr);
+
+    // Split [begin, end) into chunks of `grain` and run body(chunkBegin, chunkEnd)
+    // across workers; the calling thread takes part and returns when all are done
+    template <class Body>
+    void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, Body&& body,
+                     const char* name = "JobSystem::ParallelFor");
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    static constexpr std::size_t kInjectionQueues = 8;
+
+    void WorkerLoop(std::size_t index);
+    bool PopLocal(std::size_t queue, Job& out);
+    bool Steal(std::size_t thief, Job& out);
+    // Newest job of `group`, from `queue` first, then the other queues
+    bool TakeGroupJob(std::size_t queue, const TaskGroup& group, Job& out);
+    void Execute(Job& job);
+
+    // Queue of the calling thread: its own deque for workers, else an injection queue
+    std::size_t CurrentQueue() const;
+
+    // m_queues[0 .. workers-1] belong to workers, the kInjectionQueues after them to other threads
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    // Counted before a job is pushed, so it never drops below the jobs queued
+    std::atomic<std::size_t> m_queuedJobs{0};
+    std::atomic<std::size_t> m_sleepers{0};  // workers waiting on m_sleepCv
+    std::atomic<bool> m_stop{false};
+};
+
+// ---------------------------------
+// TaskGroup: fork-join over the JobSystem
+// Wait() executes pending jobs instead of blocking
+// ---------------------------------
+
+class TaskGroup {
+public:
+    explicit TaskGroup(JobSystem& jobs = JobSystem::Instance())
+        : m_jobs(jobs) {}
+
+    ~TaskGroup() { Wait(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Run(const char* name, std::function<void()> fn) {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        m_jobs.Submit(Job{std::move(fn), this, name});
+    }
+
+    void Wait() {
+        while (m_pending.load(std::memory_order_acquire) > 0) {
+            if (!m_jobs.TryRunOne(this)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    friend class JobSystem;
+
+    void OnJobDone() { m_pending.fetch_sub(1, std::memory_order_release); }
+
+    JobSystem& m_jobs;
+    std::atomic<std::size_t> m_pending{0};
+};
+
+template <class Body>
+void JobSystem::ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, Body&& body, const char* name) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+    if (end - begin <= grain || WorkerCount() == 0) {
+        body(begin, end);
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (std::size_t chunk = begin + grain; chunk < end; chunk += grain) {
+        const std::size_t chunkEnd = std::min(end, chunk + grain);
+        group.Run(name, [&body, chunk, chunkEnd]() { body(chunk, chunkEnd); });
+    }
+
+    // The calling thread takes the first chunk, then helps with the rest
+    body(begin, std::min(end, begin + grain));
+    group.Wait();
+}
+
+} // namespace ui
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ui {
+
+// ---------------------------------
+// MappedFile: read-only memory mapping of a whole file
+// Pages are loaded on first touch, so opening is cheap regardless of size.
+// ---------------------------------
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map `path`, replacing any earlier mapping; false if it cannot be
+    // opened or is empty
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* Data() const { return m_data; }
+    std::size_t Size() const { return m_size; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+} // namespace ui
@@ -0,0 +1,129 @@
+#include "MemoryStats.h"
+
+#include "TraceProfiler.h"
+
+#include <sstream>
+
+namespace ui {
+
+namespace {
+
+constexpr std::size_t kTagCount = static_cast<std::size_t>(MemoryTag::Count);
+
+// Counter series names must outlive the profiler session: keep them static
+constexpr const char* kBytesCounterNames[kTagCount] = {
+    "mem.ChangeBuffer.bytes",
+    "mem.RenderStorage.bytes",
+    "mem.RenderCommands.bytes",
+    "mem.RendererBuffers.bytes",
+    "mem.NodeIdAllocator.bytes",
+};
+
+constexpr const char* kAllocCounterNames[kTagCount] = {
+    "mem.ChangeBuffer.frame_allocs",
+    "mem.RenderStorage.frame_allocs",
+    "mem.RenderCommands.frame_allocs",
+    "mem.RendererBuffers.frame_allocs",
+    "mem.NodeIdAllocator.frame_allocs",
+};
+
+} // namespace
+
+const char* MemoryTagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::ChangeBuffer: return "ChangeBuffer";
+        case MemoryTag::RenderStorage: return "RenderStorage";
+        case MemoryTag::RenderCommands: return "RenderCommands";
+        case MemoryTag::RendererBuffers: return "RendererBuffers";
+        case MemoryTag::NodeIdAllocator: return "NodeIdAllocator";
+        case MemoryTag::Count: break;
+    }
+    return "Unknown";
+}
+
+MemoryStats& MemoryStats::Instance() {
+    static MemoryStats instance;
+    return instance;
+}
+
+void MemoryStats::OnAllocate(MemoryTag tag, std::size_t bytes) {
+    Counters& c = At(tag);
+    const std::int64_t current =
+        c.currentBytes.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed)
+        + static_cast<std::int64_t>(bytes);
+    c.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    c.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Raise high-water mark
+    std::int64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak &&
+           !c.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryStats::OnFree(MemoryTag tag, std::size_t bytes) {
+    At(tag).currentBytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+}
+
+MemoryTagStats MemoryStats::Query(MemoryTag tag) const {
+    const Counters& c = At(tag);
+    MemoryTagStats stats;
+    stats.currentBytes = c.currentBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+    stats.totalAllocations = c.totalAllocations.load(std::memory_order_relaxed);
+    stats.frameAllocations = c.frameAllocations.load(std::memory_order_relaxed);
+    stats.lastFrameAllocations = c.lastFrameAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::array<MemoryTagStats, static_cast<std::size_t>(MemoryTag::Count)> MemoryStats::QueryAll() const {
+    std::array<MemoryTagStats, kTagCount> all;
+    for (std::size_t i = 0; i < kTagCount; ++i) {
+        all[i] = Query(static_cast<MemoryTag>(i));
+    }
+    return all;
+}
+
+void MemoryStats::EndFrame() {
+    auto& profiler = TraceProfiler::Instance();
+
+    // Counter descriptors are registered once, like scope descriptors
+    static const std::array<std::array<std::uint16_t, 2>, kTagCount> counterIds = [&profiler]() {
+        std::array<std::array<std::uint16_t, 2>, kTagCount> ids{};
+        for (std::size_t i = 0; i < kTagCount; ++i) {
+            ids[i][0] = profiler.RegisterScope(kBytesCounterNames[i], __FILE__, __LINE__, "memory");
+            ids[i][1] = profiler.RegisterScope(kAllocCounterNames[i], __FILE__, __LINE__, "memory");
+        }
+        return ids;
+    }();
+
+    for (std::size_t i = 0; i < kTagCount; ++i) {
+        Counters& c = m_counters[i];
+        const std::uint64_t frameAllocs = c.frameAllocations.exchange(0, std::memory_order_relaxed);
+        c.lastFrameAllocations.store(frameAllocs, std::memory_order_relaxed);
+
+        profiler.RecordCounter(counterIds[i][0], c.currentBytes.load(std::memory_order_relaxed));
+        profiler.RecordCounter(counterIds[i][1], static_cast<std::int64_t>(frameAllocs));
+    }
+}
+
+std::string MemoryStats::Report() const {
+    std::ostringstream out;
+    out << "tag               current(B)      peak(B)   allocs  last-frame\n";
+    for (std::size_t i = 0; i < kTagCount; ++i) {
+        const MemoryTagStats s = Query(static_cast<MemoryTag>(i));
+        out.width(16);
+        out << std::left << MemoryTagName(static_cast<MemoryTag>(i)) << std::right;
+        out.width(12);
+        out << s.currentBytes << " ";
+        out.width(12);
+        out << s.peakBytes << " ";
+        out.width(8);
+        out << s.totalAllocations << " ";
+        out.width(11);
+        out << s.lastFrameAllocations << "\n";
+    }
+    return out.str();
+}
+
+} // namespace ui
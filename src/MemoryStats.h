@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace ui {
+
+// Subsystems that report heap usage
+enum class MemoryTag : std::uint8_t {
+    ChangeBuffer,     // TypeBuffer slots, dirty bits, active lists, snapshots
+    RenderStorage,    // TypeStorage nodes, generations, child lists, render strings
+    RenderCommands,   // per-frame render command lists
+    RendererBuffers,  // GPU buffer uploads issued by OpenGLRenderer
+    NodeIdAllocator,  // generations and free list
+    Count
+};
+
+const char* MemoryTagName(MemoryTag tag);
+
+struct MemoryTagStats {
+    std::int64_t currentBytes = 0;
+    std::int64_t peakBytes = 0;            // high-water mark since start
+    std::uint64_t totalAllocations = 0;
+    std::uint64_t frameAllocations = 0;    // allocations in the current frame
+    std::uint64_t lastFrameAllocations = 0;  // allocations in the last closed frame
+};
+
+// ---------------------------------
+// MemoryStats: tagged allocation counters
+// Lock-free; safe to report from any thread
+// ---------------------------------
+
+class MemoryStats {
+public:
+    static MemoryStats& Instance();
+
+    MemoryStats(const MemoryStats&) = delete;
+    MemoryStats& operator=(const MemoryStats&) = delete;
+
+    void OnAllocate(MemoryTag tag, std::size_t bytes);
+    void OnFree(MemoryTag tag, std::size_t bytes);
+
+    // Runtime query
+    MemoryTagStats Query(MemoryTag tag) const;
+    std::array<MemoryTagStats, static_cast<std::size_t>(MemoryTag::Count)> QueryAll() const;
+
+    // Close the current frame: emit trace counters and reset per-frame counts.
+    // Called once per application frame by whatever drives the frame loop;
+    // the counters are process-wide, so not once per RenderContext::Sync.
+    void EndFrame();
+
+    // Human-readable table of all tags
+    std::string Report() const;
+
+private:
+    MemoryStats() = default;
+
+    struct alignas(64) Counters {
+        std::atomic<std::int64_t> currentBytes{0};
+        std::atomic<std::int64_t> peakBytes{0};
+        std::atomic<std::uint64_t> totalAllocations{0};
+        std::atomic<std::uint64_t> frameAllocations{0};
+        std::atomic<std::uint64_t> lastFrameAllocations{0};
+    };
+
+    Counters& At(MemoryTag tag) { return m_counters[static_cast<std::size_t>(tag)]; }
+    const Counters& At(MemoryTag tag) const { return m_counters[static_cast<std::size_t>(tag)]; }
+
+    std::array<Counters, static_cast<std::size_t>(MemoryTag::Count)> m_counters;
+};
+
+// Stateless std allocator that reports every allocation to MemoryStats
+template <class T, MemoryTag Tag>
+class TrackingAllocator {
+public:
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = TrackingAllocator<U, Tag>;
+    };
+
+    TrackingAllocator() noexcept = default;
+    template <class U>
+    TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        T* p = std::allocator<T>{}.allocate(n);
+        MemoryStats::Instance().OnAllocate(Tag, n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        MemoryStats::Instance().OnFree(Tag, n * sizeof(T));
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+template <class T, MemoryTag Tag>
+using TrackedVector = std::vector<T, TrackingAllocator<T, Tag>>;
+
+template <MemoryTag Tag>
+using TrackedString = std::basic_string<char, std::char_traits<char>, TrackingAllocator<char, Tag>>;
+
+} // namespace ui
@@ -4,9 +4,14 @@
 #include "BackendContainerNode.h"
 #include "BackendTextNode.h"
 #include "FrontendNodes.h"
+#include "MemoryStats.h"
 #include "TraceProfiler.h"
+#include "FramePipeline.h"
 #include "OpenGLRenderer.h"
+#include "RenderCommands.h"
+#include "ScriptRuntime.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iostream>
@@ -16,13 +21,27 @@
 
 namespace ui {
 
+// Artificial per-stage costs standing in for real workload.
+// Zero disables the corresponding sleep.
+struct MovieConfig {
+    std::chrono::microseconds scriptCost = std::chrono::milliseconds(250);  // per script pass
+    std::chrono::microseconds scriptBudget = std::chrono::milliseconds(50);  // script time per Update
+    std::chrono::microseconds scriptSlice = std::chrono::milliseconds(5);  // work between budget checks
+    std::chrono::microseconds syncCost = std::chrono::milliseconds(400);
+    std::chrono::microseconds collectCost = std::chrono::milliseconds(120);
+};
+
 // Simple scene / Movie
 class Movie {
 public:
-    Movie()
-        : m_running(true)
+    explicit Movie(const MovieConfig& config = MovieConfig{})
+        : m_config(config)
+        , m_running(true)
         , m_rootId(RenderContext::Instance().AllocateNodeId())  // Allocated by RenderContext
-        , m_rectId(RenderContext::Instance().AllocateNodeId()) {  // Allocated by RenderContext
+        , m_rectId(RenderContext::Instance().AllocateNodeId())  // Allocated by RenderContext
+        , m_labelId(RenderContext::Instance().AllocateNodeId()) {
+        RenderContext::Instance().SetSimulatedSyncCost(m_config.syncCost);
+
         // Initialize OpenGL renderer
         if (!m_renderer.Initialize(800, 600, "UI Sandbox")) {
             std::cerr << "Failed to initialize OpenGL renderer" << std::endl;
@@ -31,13 +50,35 @@ public:
         // Frontend nodes create and own backend nodes
         m_root = FrontendContainer::Create(m_rootId);
         m_rect = FrontendShapeRect::Create(m_rectId);
+        m_label = FrontendText::Create(m_labelId);
 
         m_root->AddChild(m_rect.get());
+        m_root->AddChild(m_label.get());
 
         m_root->SetPosition(0.0f, 0.0f);
         m_rect->SetPosition(10.0f, 20.0f);
         m_rect->SetWidth(100.0f);
         m_rect->SetHeight(50.0f);
+
+        // Slide the rect along X and back at render rate; the update
+        // thread never touches it again
+        AnimationSpec slide;
+        slide.property = AnimatedProperty::X;
+        slide.keys.push_back(Keyframe{0.0f, 10.0f, Easing::Linear});
+        slide.keys.push_back(Keyframe{4.0f, 690.0f, Easing::EaseInOut});
+        slide.keys.push_back(Keyframe{8.0f, 10.0f, Easing::EaseInOut});
+        slide.repeat = kRepeatForever;
+        m_rect->Animate(std::move(slide));
+
+        // Stepped by every Update; the render thread glides it between steps
+        m_label->SetText("update");
+        m_label->SetPosition(m_labelX, 300.0f);
+        m_label->SetInterpolated(true);
+
+        // Built on the main thread, synced by the update thread
+        RenderContext::Instance().PublishChanges();
+
+        m_scripts.Spawn(ScriptLanguageProcessing());
     }
 
     ~Movie() {
@@ -51,37 +92,28 @@ public:
     bool IsRunning() const { return m_running.load(); }
 
     // main_thread: update
+    // Scripts run within their budget; whatever is left continues next frame
     void Update() {
         TRACE_SCOPE("Movie::Update");
-        SimulateScriptLanguageProcessing();
-
-        if (!m_root)
-            return;
-
-        // Fake animation: move text along X axis
-        static float x = 10.0f;
-        static int frameCount = 0;
-        frameCount++;
-        x += 1.0f;
-
-        if (m_rect)
-        {
-            m_rect->SetPosition(x, 20.0f);
-        }
+        m_scripts.RunFrame(m_config.scriptBudget);
 
-        // // Example: delete text node after 3 frames
-        // if (frameCount == 15 && m_rect) {
-        //     m_rect->Term();
-        //     m_rect.reset();  // Clear frontend pointer
-        // }
+        m_labelX = m_labelX + kLabelStep > 700.0f ? 10.0f : m_labelX + kLabelStep;
+        m_label->SetPosition(m_labelX, 300.0f);
 
         // At the end of update: sync buffer -> render tree
         RenderContext::Instance().Sync();
+        m_scripts.OnSync();
+        MemoryStats::Instance().EndFrame();
     }
 
     // render_thread: render
-    void Render() {
+    // `frame` is the pipeline frame being presented (0 when not pipelined).
+    // Presenting the same frame again only recollects while animations run,
+    // and logs nothing.
+    void Render(FrameId frame = 0) {
         TRACE_SCOPE("Movie::Render");
+        const bool fresh = frame == 0 || frame != m_renderFrame;
+        m_renderFrame = frame;
 
         // Check if window should close (thread-safe check)
         if (m_renderer.ShouldClose()) {
@@ -90,12 +122,16 @@ public:
         }
 
         {
-            std::lock_guard<std::mutex> lock(RenderContext::Instance().RenderMutex());
-            CollectRenderCommands();
+            auto& ctx = RenderContext::Instance();
+            auto lock = ctx.LockForRender();
+            if (fresh || ctx.RunningAnimations() > 0) {
+                ctx.AdvanceAnimations();
+                CollectRenderCommands(fresh);
+            }
         }
 
         // Execute render commands
-        ExecuteRenderCommands();
+        ExecuteRenderCommands(fresh);
 
         // Note: PollEvents() should be called from main thread on macOS
         // See ProcessEvents() method
@@ -111,143 +147,73 @@ public:
         }
     }
 
-    void SimulateScriptLanguageProcessing() {
-        TRACE_SCOPE("Movie::SimulateScriptLanguageProcessing");
-        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    // Script work in slices; hands the update thread back whenever the
+    // frame's script budget is spent, one pass per synced frame
+    ScriptTask ScriptLanguageProcessing() {
+        for (;;) {
+            auto remaining = m_config.scriptCost;
+            while (remaining.count() > 0) {
+                const auto slice = std::min(remaining, m_config.scriptSlice);
+                {
+                    TRACE_SCOPE_DETAIL("Movie::SimulateScriptLanguageProcessing");
+                    std::this_thread::sleep_for(slice);
+                }
+                remaining -= slice;
+                co_await m_scripts.Yield();
+            }
+            co_await m_scripts.AfterSync();
+        }
     }
 
 private:
-    // Per-frame render command snapshot
-    struct RenderCommand {
-        enum class Type {
-            Text,
-            ShapeRect
-        };
-        Type type;
-        struct TextPayload {
-            float x = 0.0f;
-            float y = 0.0f;
-            std::string text;
-        };
-        struct ShapeRectPayload {
-            float x = 0.0f;
-            float y = 0.0f;
-            float width = 0.0f;
-            float height = 0.0f;
-        };
-
-        TextPayload textPayload;
-        ShapeRectPayload shapeRectPayload;
-    };
-
-    void CollectRenderCommands() {
-        TRACE_SCOPE("Movie::CollectRenderCommands");
-
+    void CollectRenderCommands(bool log) {
         static int callId = 0;
         callId++;
-        std::cout << "CallId: " << callId << std::endl;
-
-        auto& ctx = RenderContext::Instance();
-        auto* rootRender = ctx.TryGetRenderNode<ContainerNodeData>(m_rootId);
-        if (!rootRender) {
-            return;
+        if (log) {
+            std::cout << "CallId: " << callId << std::endl;
         }
 
-        // Rebuild command buffer from scratch under render mutex to avoid
-        // unsynchronized access later in ExecuteRenderCommands.
-        m_renderCommands.clear();
-
-        // DFS over containers, building commands from current render state
-        std::vector<const RenderContainerNode*> stack;
-        stack.push_back(rootRender);
-        while (!stack.empty()) {
-            const RenderContainerNode* node = stack.back();
-            stack.pop_back();
-
-            for (NodeId childId : node->children) {
-                // Try container first (most common case for tree traversal)
-                if (auto* container = ctx.TryGetRenderNode<ContainerNodeData>(childId)) {
-                    stack.push_back(container);
-                    continue;
-                }
-
-                // Try text node
-                if (auto* text = ctx.TryGetRenderNode<TextNodeData>(childId)) {
-                    if (text->visible) {
-                        RenderCommand cmd{};
-                        cmd.type = RenderCommand::Type::Text;
-                        cmd.textPayload.x = text->x;
-                        cmd.textPayload.y = text->y;
-                        cmd.textPayload.text = text->text;
-                        m_renderCommands.push_back(std::move(cmd));
-                    }
-                    continue;
-                }
-
-                // Try shape rect node
-                if (auto* shapeRect = ctx.TryGetRenderNode<ShapeRectNodeData>(childId)) {
-                    if (shapeRect->visible && shapeRect->width > 0.0f && shapeRect->height > 0.0f) {
-                        RenderCommand cmd{};
-                        cmd.type = RenderCommand::Type::ShapeRect;
-                        cmd.shapeRectPayload.x = shapeRect->x;
-                        cmd.shapeRectPayload.y = shapeRect->y;
-                        cmd.shapeRectPayload.width = shapeRect->width;
-                        cmd.shapeRectPayload.height = shapeRect->height;
-                        m_renderCommands.push_back(std::move(cmd));
-                    }
-                    continue;
-                }
+        ui::CollectRenderCommands(RenderContext::Instance(), m_rootId, m_renderCommands, CollectMode::Serial,
+                                  m_renderer.Viewport());
 
-                // If all are nullptr: node was deleted, skip it
-            }
+        if (m_config.collectCost.count() > 0) {
+            std::this_thread::sleep_for(m_config.collectCost);
         }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(120));
     }
 
-    void ExecuteRenderCommands() {
-        TRACE_SCOPE("Movie::ExecuteRenderCommands");
+    // Commands are kept: an unchanged frame is presented from them again
+    void ExecuteRenderCommands(bool log) {
+        TRACE_SCOPE_DETAIL("Movie::ExecuteRenderCommands");
 
-        m_renderer.BeginFrame();
-
-        std::cout << "Render commands: " << m_renderCommands.size() << std::endl;
-
-        for (const auto& cmd : m_renderCommands) {
-            switch (cmd.type) {
-                case RenderCommand::Type::Text: {
-                    m_renderer.RenderText(cmd.textPayload.x, cmd.textPayload.y, cmd.textPayload.text);
-                    break;
-                }
-                case RenderCommand::Type::ShapeRect: {
-                    if (cmd.shapeRectPayload.width > 0.0f && cmd.shapeRectPayload.height > 0.0f) {
-                        // Use bright cyan color for visibility
-                        m_renderer.RenderRect(
-                            cmd.shapeRectPayload.x,
-                            cmd.shapeRectPayload.y,
-                            cmd.shapeRectPayload.width,
-                            cmd.shapeRectPayload.height,
-                            0.0f, 1.0f, 1.0f, 1.0f);
-                    }
-                    break;
-                }
-            }
+        if (log) {
+            std::cout << "Render commands: " << m_renderCommands.size() << " (frame " << m_renderFrame << ")"
+                      << std::endl;
         }
 
-        m_renderer.EndFrame();
-        m_renderCommands.clear();
+        m_renderer.ExecuteCommands(m_renderCommands);
     }
 
 private:
+    static constexpr float kLabelStep = 115.0f;  // per Update
+
+    MovieConfig m_config;
     std::atomic<bool> m_running;
 
     NodeId m_rootId;
     NodeId m_rectId;
+    NodeId m_labelId;
 
     std::unique_ptr<FrontendContainer> m_root;
     std::unique_ptr<FrontendShapeRect> m_rect;
+    std::unique_ptr<FrontendText> m_label;
+    float m_labelX = 10.0f;
 
     OpenGLRenderer m_renderer;
-    std::vector<RenderCommand> m_renderCommands;
+    RenderCommandList m_renderCommands;
+    FrameId m_renderFrame = 0;
+
+    // Last: scripts reference the nodes above and are destroyed first
+    ScriptRuntime m_scripts;
 };
 
 } // namespace ui
@@ -1,48 +1,160 @@
 #include "NodeData.h"
 #include "RenderContext.h"
 
+#include <algorithm>
+
 namespace ui {
 
+namespace {
+
+// Fields every NodeData has; the later record wins per dirty field
+template <typename T>
+void MergeCommonFields(T& into, const T& later) {
+    if (later.dirtyFields & kFieldPosition) {
+        into.x = later.x;
+        into.y = later.y;
+    }
+    if (later.dirtyFields & kFieldVisible) {
+        into.visible = later.visible;
+    }
+    if (later.dirtyFields & kFieldLayer) {
+        into.layer = later.layer;
+    }
+    into.deleted = into.deleted || later.deleted;
+    into.dirtyFields |= later.dirtyFields;
+}
+
+} // namespace
+
 void ContainerNodeData::Flush(RenderContext& ctx) {
-    auto& renderContext = RenderContext::Instance();
-    RenderContainerNode* r = render ? render : renderContext.EnsureRenderNode<ContainerNodeData>(id);
+    RenderContainerNode* r = render ? render : ctx.EnsureRenderNode<ContainerNodeData>(id);
     render = r;
-    r->x = x;
-    r->y = y;
-    r->visible = visible;
+    if (dirtyFields & kFieldPosition) {
+        r->x = x;
+        r->y = y;
+    }
+    if (dirtyFields & kFieldVisible) {
+        r->visible = visible;
+    }
+    if (dirtyFields & kFieldLayer) {
+        r->layer = layer;
+    }
+
+    if (dirtyFields & kFieldChildren) {
+        // Drop ids of children deleted in earlier frames before appending
+        r->children.erase(
+            std::remove_if(r->children.begin(), r->children.end(),
+                           [&ctx](NodeId child) { return !ctx.IsAlive(child); }),
+            r->children.end());
+        r->children.insert(r->children.end(), children.begin(), children.end());
+    }
+}
 
-    // Copy children - both use NodeId now
-    r->children = children;
+void ContainerNodeData::MergeFrom(ContainerNodeData&& later) {
+    MergeCommonFields(*this, later);
+    // Appends from both producers, earlier first
+    children.insert(children.end(), later.children.begin(), later.children.end());
 }
 
 void TextNodeData::Flush(RenderContext& ctx) {
-    auto& renderContext = RenderContext::Instance();
-    RenderTextNode* r = render ? render : renderContext.EnsureRenderNode<TextNodeData>(id);
+    RenderTextNode* r = render ? render : ctx.EnsureRenderNode<TextNodeData>(id);
     render = r;
-    r->x = x;
-    r->y = y;
-    r->visible = visible;
-    r->text = text;
+    // Interpolated nodes keep showing where they are; Sync starts the glide
+    const bool glide = r->interpolated;
+    if (dirtyFields & kFieldInterpolation) {
+        r->interpolated = interpolated;
+    }
+    if ((dirtyFields & kFieldPosition) && !glide) {
+        r->x = x;
+        r->y = y;
+    }
+    if (dirtyFields & kFieldVisible) {
+        r->visible = visible;
+    }
+    if (dirtyFields & kFieldLayer) {
+        r->layer = layer;
+    }
+    if (dirtyFields & kFieldText) {
+        r->text.assign(text.data(), text.size());
+    }
+}
+
+void TextNodeData::MergeFrom(TextNodeData&& later) {
+    MergeCommonFields(*this, later);
+    if (later.dirtyFields & kFieldText) {
+        text = std::move(later.text);
+    }
+    if (later.dirtyFields & kFieldInterpolation) {
+        interpolated = later.interpolated;
+    }
+    // Started in order, so a later spec for the same property wins
+    DropAnimations(animations, later.dirtyFields);
+    for (AnimationSpec& spec : later.animations) {
+        animations.push_back(std::move(spec));
+    }
 }
 
 void ShapeNodeData::Flush(RenderContext& ctx) {
-    auto& renderContext = RenderContext::Instance();
-    RenderShapeNode* r = render ? render : renderContext.EnsureRenderNode<ShapeNodeData>(id);
+    RenderShapeNode* r = render ? render : ctx.EnsureRenderNode<ShapeNodeData>(id);
     render = r;
-    r->x = x;
-    r->y = y;
-    r->visible = visible;
+    if (dirtyFields & kFieldPosition) {
+        r->x = x;
+        r->y = y;
+    }
+    if (dirtyFields & kFieldVisible) {
+        r->visible = visible;
+    }
+    if (dirtyFields & kFieldLayer) {
+        r->layer = layer;
+    }
+}
+
+void ShapeNodeData::MergeFrom(ShapeNodeData&& later) {
+    MergeCommonFields(*this, later);
 }
 
 void ShapeRectNodeData::Flush(RenderContext& ctx) {
-    auto& renderContext = RenderContext::Instance();
-    RenderShapeRectNode* r = render ? render : renderContext.EnsureRenderNode<ShapeRectNodeData>(id);
+    RenderShapeRectNode* r = render ? render : ctx.EnsureRenderNode<ShapeRectNodeData>(id);
     render = r;
-    r->x = x;
-    r->y = y;
-    r->visible = visible;
-    r->width = width;
-    r->height = height;
+    // Interpolated nodes keep showing where they are; Sync starts the glide
+    const bool glide = r->interpolated;
+    if (dirtyFields & kFieldInterpolation) {
+        r->interpolated = interpolated;
+    }
+    if ((dirtyFields & kFieldPosition) && !glide) {
+        r->x = x;
+        r->y = y;
+    }
+    if (dirtyFields & kFieldVisible) {
+        r->visible = visible;
+    }
+    if (dirtyFields & kFieldLayer) {
+        r->layer = layer;
+    }
+    if (dirtyFields & kFieldWidth) {
+        r->width = width;
+    }
+    if (dirtyFields & kFieldHeight) {
+        r->height = height;
+    }
+}
+
+void ShapeRectNodeData::MergeFrom(ShapeRectNodeData&& later) {
+    MergeCommonFields(*this, later);
+    if (later.dirtyFields & kFieldWidth) {
+        width = later.width;
+    }
+    if (later.dirtyFields & kFieldHeight) {
+        height = later.height;
+    }
+    if (later.dirtyFields & kFieldInterpolation) {
+        interpolated = later.interpolated;
+    }
+    // Started in order, so a later spec for the same property wins
+    DropAnimations(animations, later.dirtyFields);
+    for (AnimationSpec& spec : later.animations) {
+        animations.push_back(std::move(spec));
+    }
 }
 
 } // namespace ui
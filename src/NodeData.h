@@ -1,7 +1,10 @@
 #pragma once
 
 #include "ui_ids.h"
+#include "Animation.h"
+#include "MemoryStats.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,41 @@ struct RenderTextNode;
 struct RenderShapeNode;
 struct RenderShapeRectNode;
 
+// Fields written during the current frame. A record starts each frame
+// with no fields set; Flush copies only the marked fields so a partial
+// update (e.g. SetPosition) keeps the rest of the render node intact.
+enum NodeDataField : std::uint32_t {
+    kFieldPosition = 1u << 0,
+    kFieldVisible = 1u << 1,
+    kFieldChildren = 1u << 2,  // children holds ids appended this frame
+    kFieldText = 1u << 3,
+    kFieldWidth = 1u << 4,
+    kFieldHeight = 1u << 5,
+    kFieldLayer = 1u << 6,
+    kFieldAnimations = 1u << 7,  // animations holds specs started this frame
+    kFieldInterpolation = 1u << 8,
+};
+
+// Field a direct write of the animated property marks; such a write stops its animation
+inline std::uint32_t DirtyFieldOf(AnimatedProperty property) {
+    switch (property) {
+        case AnimatedProperty::Width:
+            return kFieldWidth;
+        case AnimatedProperty::Height:
+            return kFieldHeight;
+        case AnimatedProperty::X:
+        case AnimatedProperty::Y:
+            break;
+    }
+    return kFieldPosition;
+}
+
+// Drop pending animations of properties in `fields`: a direct write after
+// Animate() in the same frame wins
+inline void DropAnimations(TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>& animations, std::uint32_t fields) {
+    std::erase_if(animations, [fields](const AnimationSpec& spec) { return (DirtyFieldOf(spec.property) & fields) != 0; });
+}
+
 // ----------------------------
 // Update-side (write) NodeData
 // No virtuals and no base class hierarchy
@@ -23,11 +61,15 @@ struct ContainerNodeData {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;  // z-order, relative to the parent's (see RenderCommand::sortKey)
     bool deleted = false;  // Mark for deletion
-    std::vector<NodeId> children;
+    std::uint32_t dirtyFields = 0;  // NodeDataField bits
+    TrackedVector<NodeId, MemoryTag::ChangeBuffer> children;
     RenderContainerNode* render = nullptr;
 
     void Flush(RenderContext& ctx);
+    // Fold a later record of the same node (another producer's) into this one
+    void MergeFrom(ContainerNodeData&& later);
 };
 
 struct TextNodeData {
@@ -35,11 +77,17 @@ struct TextNodeData {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;  // z-order, relative to the parent's (see RenderCommand::sortKey)
     bool deleted = false;  // Mark for deletion
-    std::string text;
+    std::uint32_t dirtyFields = 0;  // NodeDataField bits
+    TrackedString<MemoryTag::ChangeBuffer> text;
+    bool interpolated = false;  // position changes glide on the render side (see RenderTextNode)
+    TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer> animations;
     RenderTextNode* render = nullptr;
 
     void Flush(RenderContext& ctx);
+    // Fold a later record of the same node (another producer's) into this one
+    void MergeFrom(TextNodeData&& later);
 };
 
 struct ShapeNodeData {
@@ -47,10 +95,14 @@ struct ShapeNodeData {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;  // z-order, relative to the parent's (see RenderCommand::sortKey)
     bool deleted = false;  // Mark for deletion
+    std::uint32_t dirtyFields = 0;  // NodeDataField bits
     RenderShapeNode* render = nullptr;
 
     void Flush(RenderContext& ctx);
+    // Fold a later record of the same node (another producer's) into this one
+    void MergeFrom(ShapeNodeData&& later);
 };
 
 struct ShapeRectNodeData {
@@ -58,12 +110,42 @@ struct ShapeRectNodeData {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;  // z-order, relative to the parent's (see RenderCommand::sortKey)
     bool deleted = false;  // Mark for deletion
+    std::uint32_t dirtyFields = 0;  // NodeDataField bits
     float width = 0.0f;
     float height = 0.0f;
+    bool interpolated = false;  // position changes glide on the render side (see RenderTextNode)
+    TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer> animations;
     RenderShapeRectNode* render = nullptr;
 
     void Flush(RenderContext& ctx);
+    // Fold a later record of the same node (another producer's) into this one
+    void MergeFrom(ShapeRectNodeData&& later);
 };
 
+// Ids a record appends to its node's children; null for leaf types
+inline const TrackedVector<NodeId, MemoryTag::ChangeBuffer>* AppendedChildren(const ContainerNodeData& data) {
+    return (data.dirtyFields & kFieldChildren) ? &data.children : nullptr;
+}
+
+template <typename T>
+const TrackedVector<NodeId, MemoryTag::ChangeBuffer>* AppendedChildren(const T&) {
+    return nullptr;
+}
+
+// Animations a record starts; null for types that cannot be animated
+inline const TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>* SubmittedAnimations(const TextNodeData& data) {
+    return (data.dirtyFields & kFieldAnimations) ? &data.animations : nullptr;
+}
+
+inline const TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>* SubmittedAnimations(const ShapeRectNodeData& data) {
+    return (data.dirtyFields & kFieldAnimations) ? &data.animations : nullptr;
+}
+
+template <typename T>
+const TrackedVector<AnimationSpec, MemoryTag::ChangeBuffer>* SubmittedAnimations(const T&) {
+    return nullptr;
+}
+
 } // namespace ui
@@ -0,0 +1,230 @@
+#include "NodeIdAllocator.h"
+
+#include "MemoryStats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace ui {
+
+namespace {
+
+constexpr std::uint64_t kLinkBits = 40;
+constexpr std::uint64_t kLinkMask = (std::uint64_t{1} << kLinkBits) - 1;
+
+std::uint64_t PackHead(std::uint64_t tag, std::uint64_t link) {
+    return (tag << kLinkBits) | (link & kLinkMask);
+}
+
+// Indices this thread took from one allocator and has not handed out yet
+struct ThreadCache {
+    std::shared_ptr<NodeIdAllocator::State> state;
+    std::vector<std::uint64_t> indices;
+
+    ~ThreadCache() {
+        for (std::uint64_t index : indices) {
+            state->PushFree(index);
+        }
+    }
+};
+
+ThreadCache& LocalCache(const std::shared_ptr<NodeIdAllocator::State>& state) {
+    thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+    for (auto& cache : caches) {
+        if (cache->state == state) {
+            return *cache;
+        }
+    }
+
+    // Drop caches of allocators that no longer exist
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [](const auto& cache) { return cache->state->retired.load(std::memory_order_relaxed); }),
+                 caches.end());
+
+    caches.push_back(std::make_unique<ThreadCache>());
+    caches.back()->state = state;
+    caches.back()->indices.reserve(NodeIdAllocator::kCacheBatch);
+    return *caches.back();
+}
+
+} // namespace
+
+NodeIdAllocator::State::State()
+    : pages(new std::atomic<Page*>[kMaxPages]) {
+    for (std::size_t i = 0; i < kMaxPages; ++i) {
+        pages[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+NodeIdAllocator::State::~State() {
+    for (std::size_t i = 0; i < kMaxPages; ++i) {
+        if (Page* page = pages[i].load(std::memory_order_relaxed)) {
+            delete page;
+            MemoryStats::Instance().OnFree(MemoryTag::NodeIdAllocator, sizeof(Page));
+        }
+    }
+}
+
+NodeIdAllocator::Page* NodeIdAllocator::State::PageFor(std::uint64_t index) const {
+    if (index >= kMaxIndex) {
+        return nullptr;
+    }
+    return pages[index >> kPageBits].load(std::memory_order_acquire);
+}
+
+NodeIdAllocator::Page* NodeIdAllocator::State::EnsurePage(std::uint64_t index) {
+    if (index >= kMaxIndex) {
+        return nullptr;
+    }
+    std::atomic<Page*>& slot = pages[index >> kPageBits];
+    Page* page = slot.load(std::memory_order_acquire);
+    if (page) {
+        return page;
+    }
+
+    auto* fresh = new Page;
+    for (std::size_t i = 0; i < kPageSize; ++i) {
+        fresh->generations[i].store(0, std::memory_order_relaxed);
+        fresh->nextFree[i].store(0, std::memory_order_relaxed);
+    }
+    if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        MemoryStats::Instance().OnAllocate(MemoryTag::NodeIdAllocator, sizeof(Page));
+        return fresh;
+    }
+    // Another thread installed the page first
+    delete fresh;
+    return page;
+}
+
+void NodeIdAllocator::State::PushFree(std::uint64_t index) {
+    std::atomic<std::uint64_t>& link = PageFor(index)->nextFree[index & kPageMask];
+    std::uint64_t head = freeHead.load(std::memory_order_relaxed);
+    std::uint64_t next;
+    do {
+        link.store(head & kLinkMask, std::memory_order_relaxed);
+        next = PackHead((head >> kLinkBits) + 1, index + 1);
+    } while (!freeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::size_t NodeIdAllocator::State::PopFree(std::uint64_t* out, std::size_t max) {
+    std::uint64_t head = freeHead.load(std::memory_order_acquire);
+    while ((head & kLinkMask) != 0) {
+        // Walk up to `max` entries, then detach them with a single CAS.
+        // Links read here may be stale if another thread pops concurrently;
+        // the tag in the head makes the CAS fail in that case.
+        std::size_t count = 0;
+        std::uint64_t link = head & kLinkMask;
+        while (link != 0 && count < max) {
+            const std::uint64_t index = link - 1;
+            const Page* page = PageFor(index);
+            if (!page) {
+                break;
+            }
+            out[count++] = index;
+            link = page->nextFree[index & kPageMask].load(std::memory_order_relaxed);
+        }
+
+        const std::uint64_t next = PackHead((head >> kLinkBits) + 1, link);
+        if (freeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+            return count;
+        }
+    }
+    return 0;
+}
+
+NodeIdAllocator::NodeIdAllocator()
+    : m_state(std::make_shared<State>()) {}
+
+NodeIdAllocator::~NodeIdAllocator() {
+    m_state->retired.store(true, std::memory_order_relaxed);
+}
+
+NodeId NodeIdAllocator::Allocate() {
+    ThreadCache& cache = LocalCache(m_state);
+
+    if (cache.indices.empty()) {
+        // Refill: recycled indices first, then a fresh range
+        std::uint64_t batch[kCacheBatch];
+        std::size_t count = m_state->PopFree(batch, kCacheBatch);
+        if (count == 0) {
+            const std::uint64_t first = m_state->nextIndex.fetch_add(kCacheBatch, std::memory_order_relaxed);
+            if (first + kCacheBatch > kMaxIndex) {
+                // Every index is live or cached; nothing to hand out
+                std::cerr << "NodeIdAllocator: out of node indices (" << kMaxIndex << " in use)" << std::endl;
+                std::abort();
+            }
+            // Index 0 is never handed out, so NodeId 0 can mean "no node"
+            const std::size_t skip = first == 0 ? 1 : 0;
+            for (std::size_t i = skip; i < kCacheBatch; ++i) {
+                batch[i - skip] = first + i;
+            }
+            count = kCacheBatch - skip;
+            m_state->EnsurePage(first);
+        }
+        // Hand out in ascending order (taken from the back)
+        for (std::size_t i = count; i > 0; --i) {
+            cache.indices.push_back(batch[i - 1]);
+        }
+    }
+
+    const std::uint64_t index = cache.indices.back();
+    cache.indices.pop_back();
+    return MakeNodeId(index, GetGeneration(index));
+}
+
+bool NodeIdAllocator::Restore(const std::uint16_t* generations, const std::uint8_t* live, std::uint64_t count) {
+    // Fresh ranges are handed out in whole batches, so the limit stays batch aligned
+    const std::uint64_t limit = (count + kCacheBatch - 1) / kCacheBatch * kCacheBatch;
+    if (limit > kMaxIndex || m_state->nextIndex.load() != 0 || (m_state->freeHead.load() & kLinkMask) != 0) {
+        return false;
+    }
+    for (std::uint64_t index = 0; index < limit; index += kPageSize) {
+        m_state->EnsurePage(index);
+    }
+    for (std::uint64_t index = 0; index < count; ++index) {
+        m_state->PageFor(index)->generations[index & kPageMask].store(generations[index], std::memory_order_relaxed);
+    }
+    // Pushed from the top so the lowest free index is handed out first; 0 stays reserved
+    for (std::uint64_t index = limit; index-- > 1;) {
+        if (index >= count || !live[index]) {
+            m_state->PushFree(index);
+        }
+    }
+    m_state->nextIndex.store(limit, std::memory_order_release);
+    return true;
+}
+
+void NodeIdAllocator::Reserve(std::uint64_t limit) {
+    limit = std::min((limit + kCacheBatch - 1) / kCacheBatch * kCacheBatch, kMaxIndex);
+    // Pages first: Free() and GetGeneration() of these indices need them
+    for (std::uint64_t index = 0; index < limit; index += kPageSize) {
+        m_state->EnsurePage(index);
+    }
+    std::uint64_t next = m_state->nextIndex.load(std::memory_order_relaxed);
+    while (next < limit &&
+           !m_state->nextIndex.compare_exchange_weak(next, limit, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+void NodeIdAllocator::Free(NodeId id) {
+    const std::uint64_t idx = ExtractIndex(id);
+    Page* page = m_state->PageFor(idx);
+    if (!page) {
+        return;  // Invalid index
+    }
+
+    // Increment generation to invalidate all existing handles; fails if
+    // the handle is stale (already freed or never allocated)
+    std::uint16_t gen = ExtractGeneration(id);
+    const auto nextGen = static_cast<std::uint16_t>((gen + 1) & 0xFFFF);
+    if (!page->generations[idx & kPageMask].compare_exchange_strong(gen, nextGen, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    // Add to free list for reuse
+    m_state->PushFree(idx);
+}
+
+} // namespace ui
@@ -2,76 +2,96 @@
 
 #include "ui_ids.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <memory>
 
 namespace ui {
 
-// Allocates NodeId handles with generation tracking
-// Manages free list to reuse indices and prevent holes in vectors
+// Allocates NodeId handles with generation tracking.
+// Thread-safe and lock-free:
+// - generations live in lazily allocated pages of atomics (never moved)
+// - freed indices go onto a global Treiber stack (ABA-tagged head)
+// - each thread keeps a small cache of indices, refilled in batches from
+//   the free list or from the fresh-index counter
 class NodeIdAllocator {
 public:
-    NodeIdAllocator() = default;
-
-    // Allocate a new NodeId
-    // Returns handle with unique index and generation=0
-    NodeId Allocate() {
-        std::uint64_t index;
-        
-        if (!m_freeIndices.empty()) {
-            // Reuse freed index
-            index = m_freeIndices.back();
-            m_freeIndices.pop_back();
-        } else {
-            // Allocate new index
-            index = m_nextIndex++;
-        }
-        
-        // Ensure vectors are large enough
-        if (index >= m_generations.size()) {
-            m_generations.resize(index + 1, 0);
-        }
-        
-        // Return handle with current generation (should be 0 for new slots)
-        return MakeNodeId(index, m_generations[index]);
-    }
+    NodeIdAllocator();
+    ~NodeIdAllocator();
 
-    // Free a NodeId (called when node is deleted)
-    // Increments generation to invalidate all existing handles with this index
-    void Free(NodeId id) {
-        const std::uint64_t idx = ExtractIndex(id);
-        const std::uint16_t gen = ExtractGeneration(id);
-        
-        if (idx >= m_generations.size()) {
-            return;  // Invalid index
-        }
-        
-        // Check generation match (safety check)
-        if (m_generations[idx] != gen) {
-            return;  // Already freed or invalid
-        }
-        
-        // Increment generation to invalidate all existing handles
-        // Note: & 0xFFFF is redundant for uint16_t (overflow is well-defined wrap-around),
-        // but kept for explicitness and type safety if generation type changes
-        m_generations[idx] = (gen + 1) & 0xFFFF;
-        
-        // Add to free list for reuse
-        m_freeIndices.push_back(idx);
-    }
+    NodeIdAllocator(const NodeIdAllocator&) = delete;
+    NodeIdAllocator& operator=(const NodeIdAllocator&) = delete;
+
+    // Allocate a NodeId with the slot's current generation; any thread.
+    // Aborts once all kMaxIndex indices are in use.
+    NodeId Allocate();
+
+    // Free a NodeId (called when node is deleted); any thread.
+    // Increments generation to invalidate all existing handles with this index.
+    // Stale or repeated frees are ignored.
+    void Free(NodeId id);
+
+    // Every index handed out so far is below this; any thread
+    std::uint64_t IndexLimit() const { return m_state->nextIndex.load(std::memory_order_acquire); }
+
+    // Fresh allocator only (nothing allocated yet): take over the state of
+    // another one with `count` indices. `generations[i]` is index i's
+    // current generation; indices whose `live[i]` is 0 become free again.
+    // False if this allocator was already used or `count` is too large.
+    bool Restore(const std::uint16_t* generations, const std::uint8_t* live, std::uint64_t count);
 
-    // Get current generation for an index (for validation)
+    // Treat indices below `limit` as handed out without allocating them
+    // here (ids replayed from another allocator); their generations are
+    // left as they are. Never lowers the limit.
+    void Reserve(std::uint64_t limit);
+
+    // Get current generation for an index (for validation); any thread
     std::uint16_t GetGeneration(std::uint64_t index) const {
-        if (index >= m_generations.size()) {
+        if (index >= kMaxIndex) {
+            return 0;
+        }
+        const Page* page = m_state->pages[index >> kPageBits].load(std::memory_order_acquire);
+        if (page == nullptr) {
             return 0;
         }
-        return m_generations[index];
+        return page->generations[index & kPageMask].load(std::memory_order_acquire);
     }
 
+    static constexpr std::size_t kPageBits = 12;
+    static constexpr std::size_t kPageSize = std::size_t{1} << kPageBits;
+    static constexpr std::size_t kPageMask = kPageSize - 1;
+    static constexpr std::size_t kMaxPages = std::size_t{1} << 14;
+    static constexpr std::uint64_t kMaxIndex = std::uint64_t{kPageSize} * kMaxPages;
+
+    // Indices moved between the shared pools and a thread cache at once
+    static constexpr std::size_t kCacheBatch = 64;
+    static_assert(kPageSize % kCacheBatch == 0, "a fresh batch must not straddle pages");
+
+    struct Page {
+        std::atomic<std::uint16_t> generations[kPageSize];
+        std::atomic<std::uint64_t> nextFree[kPageSize];  // free list link: index + 1, 0 = end
+    };
+
+    // Shared with thread caches so they can return indices after the
+    // allocator is gone
+    struct State {
+        std::unique_ptr<std::atomic<Page*>[]> pages;
+        std::atomic<std::uint64_t> nextIndex{0};  // next never-used index
+        std::atomic<std::uint64_t> freeHead{0};   // tag << 40 | (index + 1)
+        std::atomic<bool> retired{false};
+
+        State();
+        ~State();
+
+        Page* EnsurePage(std::uint64_t index);
+        Page* PageFor(std::uint64_t index) const;
+        void PushFree(std::uint64_t index);
+        std::size_t PopFree(std::uint64_t* out, std::size_t max);
+    };
+
 private:
-    std::uint64_t m_nextIndex = 0;  // Next index to allocate
-    std::vector<std::uint16_t> m_generations;  // Generation per index
-    std::vector<std::uint64_t> m_freeIndices;  // Free list for reuse
+    std::shared_ptr<State> m_state;
 };
 
 } // namespace ui
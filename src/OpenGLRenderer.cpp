@@ -36,16 +36,67 @@
     #else
         // On Windows and other platforms without GLFW, use legacy GL headers.
         // On Windows this resolves to the Windows SDK GL headers.
+        #ifdef __linux__
+            // Mesa/libglvnd export the GL 3.x entry points directly; ask
+            // glext.h for their prototypes (VAO/VBO, shaders).
+            #define GL_GLEXT_PROTOTYPES
+        #endif
         #include <GL/gl.h>
+        #ifdef __linux__
+            #include <GL/glext.h>
+        #endif
         #include <GL/glu.h>
     #endif
 #endif
 
+#include "JobSystem.h"
+#include "MemoryStats.h"
+
 #include <iostream>
 #include <vector>
 
 namespace ui {
 
+namespace {
+
+// Batches are drawn as plain triangles: [x, y, r, g, b, a] per vertex
+constexpr std::size_t kFloatsPerVertex = 6;
+constexpr std::size_t kVerticesPerRect = 6;
+constexpr std::size_t kFloatsPerRect = kFloatsPerVertex * kVerticesPerRect;
+
+// Batches of at least this many rects build their vertices in parallel
+constexpr std::size_t kVertexGrain = 4096;
+
+void WriteRectVertices(float x, float y, float width, float height, const float (&color)[4], float* out) {
+    const float corners[kVerticesPerRect][2] = {
+        {x, y}, {x + width, y}, {x + width, y + height},
+        {x, y}, {x + width, y + height}, {x, y + height},
+    };
+    for (const auto& corner : corners) {
+        *out++ = corner[0];
+        *out++ = corner[1];
+        for (float channel : color) {
+            *out++ = channel;
+        }
+    }
+}
+
+// Text is a placeholder rect (see RenderText); shape rects use bright cyan for visibility
+void WriteCommandVertices(const RenderCommand& cmd, float* out) {
+    static constexpr float kTextColor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static constexpr float kRectColor[4] = {0.0f, 1.0f, 1.0f, 1.0f};
+    if (cmd.type == RenderCommand::Type::Text) {
+        const RenderCommand::TextPayload& text = cmd.textPayload;
+        WriteRectVertices(text.x, text.y, static_cast<float>(text.text.size()) * kTextGlyphWidth, kTextLineHeight,
+                          kTextColor, out);
+    } else {
+        const RenderCommand::ShapeRectPayload& rect = cmd.shapeRectPayload;
+        WriteRectVertices(rect.x, rect.y, rect.width, rect.height, kRectColor, out);
+    }
+}
+
+} // namespace
+
 // Simple vertex shader for rendering rectangles
 static const char* s_vertexShaderSource = R"(
 #version 330 core
@@ -218,6 +269,8 @@ void OpenGLRenderer::CleanupShaders() {
     if (m_VBO != 0) {
         glDeleteBuffers(1, &m_VBO);
         m_VBO = 0;
+        MemoryStats::Instance().OnFree(MemoryTag::RendererBuffers, m_vboBytes);
+        m_vboBytes = 0;
     }
     if (m_shaderProgram != 0) {
         glDeleteProgram(m_shaderProgram);
@@ -379,11 +432,18 @@ void OpenGLRenderer::RenderRect(float x, float y, float width, float height, flo
     glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
 
+    // glBufferData orphans the previous data store
+    auto& memoryStats = MemoryStats::Instance();
+    memoryStats.OnFree(MemoryTag::RendererBuffers, m_vboBytes);
+    memoryStats.OnAllocate(MemoryTag::RendererBuffers, sizeof(vertices));
+    m_vboBytes = sizeof(vertices);
+
     // Create and bind EBO for indices (must be bound while VAO is bound)
     std::uint32_t EBO;
     glGenBuffers(1, &EBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    memoryStats.OnAllocate(MemoryTag::RendererBuffers, sizeof(indices));
 
     // Draw
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -393,14 +453,80 @@ void OpenGLRenderer::RenderRect(float x, float y, float width, float height, flo
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glDeleteBuffers(1, &EBO);
+    memoryStats.OnFree(MemoryTag::RendererBuffers, sizeof(indices));
 #endif
 }
 
-void OpenGLRenderer::RenderText(float x, float y, const std::string& text) {
+void OpenGLRenderer::RenderText(float x, float y, std::string_view text) {
     // Placeholder for text rendering
     // In a real implementation, you would use a font atlas or text rendering library
     // For now, render a simple rectangle as placeholder
-    RenderRect(x, y, text.length() * 8.0f, 16.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+    RenderRect(x, y, static_cast<float>(text.length()) * kTextGlyphWidth, kTextLineHeight, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void OpenGLRenderer::ExecuteCommands(const RenderCommandList& commands) {
+    BeginFrame();
+
+#ifdef _WIN32
+    // Immediate mode: one draw per command
+    for (const auto& cmd : commands) {
+        switch (cmd.type) {
+            case RenderCommand::Type::Text: {
+                RenderText(cmd.textPayload.x, cmd.textPayload.y, cmd.textPayload.text);
+                break;
+            }
+            case RenderCommand::Type::ShapeRect: {
+                if (cmd.shapeRectPayload.width > 0.0f && cmd.shapeRectPayload.height > 0.0f) {
+                    // Use bright cyan color for visibility
+                    RenderRect(
+                        cmd.shapeRectPayload.x,
+                        cmd.shapeRectPayload.y,
+                        cmd.shapeRectPayload.width,
+                        cmd.shapeRectPayload.height,
+                        0.0f, 1.0f, 1.0f, 1.0f);
+                }
+                break;
+            }
+        }
+    }
+#else
+    BuildDrawBatches(commands, m_batches);
+    for (const DrawBatch& batch : m_batches) {
+        DrawBatchRects(commands, batch);
+    }
+#endif
+
+    EndFrame();
+}
+
+void OpenGLRenderer::DrawBatchRects(const RenderCommandList& commands, const DrawBatch& batch) {
+    if (!m_initialized || batch.count == 0) {
+        return;
+    }
+    TRACE_SCOPE_DETAIL("OpenGLRenderer::DrawBatch");
+
+    m_vertices.resize(static_cast<std::size_t>(batch.count) * kFloatsPerRect);
+    JobSystem::Instance().ParallelFor(0, batch.count, kVertexGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            WriteCommandVertices(commands[batch.first + i], &m_vertices[i * kFloatsPerRect]);
+        }
+    }, "OpenGLRenderer::BuildVertices");
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    const std::size_t bytes = m_vertices.size() * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), m_vertices.data(), GL_DYNAMIC_DRAW);
+
+    // glBufferData orphans the previous data store
+    auto& memoryStats = MemoryStats::Instance();
+    memoryStats.OnFree(MemoryTag::RendererBuffers, m_vboBytes);
+    memoryStats.OnAllocate(MemoryTag::RendererBuffers, bytes);
+    m_vboBytes = bytes;
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(static_cast<std::size_t>(batch.count) * kVerticesPerRect));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 bool OpenGLRenderer::ShouldClose() const {
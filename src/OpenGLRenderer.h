@@ -1,9 +1,12 @@
 #pragma once
 
 #include "RenderContext.h"
+#include "RenderCommands.h"
 
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #ifdef USE_GLFW
 #include <GLFW/glfw3.h>
@@ -29,7 +32,11 @@ public:
 
     // Render methods for different node types
     void RenderRect(float x, float y, float width, float height, float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f);
-    void RenderText(float x, float y, const std::string& text);
+    void RenderText(float x, float y, std::string_view text);
+
+    // Draw a collected command list as one frame (BeginFrame ... EndFrame),
+    // one draw call per DrawBatch
+    void ExecuteCommands(const RenderCommandList& commands);
     
     // Check if window should close
     bool ShouldClose() const;
@@ -37,6 +44,10 @@ public:
     // Get window dimensions
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
+    // Visible area in command coordinates, for culling
+    Bounds Viewport() const {
+        return Bounds::FromRect(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height));
+    }
 
     // Process window events (call in render loop)
     void PollEvents();
@@ -46,6 +57,9 @@ private:
     bool InitializeShaders();
     void CleanupShaders();
     
+    // Upload the vertices of one batch and draw them in a single call
+    void DrawBatchRects(const RenderCommandList& commands, const DrawBatch& batch);
+
     // Compile shader from source
     std::uint32_t CompileShader(const std::string& source, std::uint32_t type);
     
@@ -65,7 +79,12 @@ private:
     std::uint32_t m_shaderProgram = 0;
     std::uint32_t m_VAO = 0;
     std::uint32_t m_VBO = 0;
+    std::size_t m_vboBytes = 0;  // current VBO data store size, for MemoryStats
     bool m_initialized = false;
+
+    // Per-frame scratch, reused across frames
+    std::vector<DrawBatch> m_batches;
+    std::vector<float> m_vertices;
 };
 
 } // namespace ui
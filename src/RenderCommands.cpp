@@ -0,0 +1,379 @@
+#include "RenderCommands.h"
+#include "RenderContext.h"
+
+#include "JobSystem.h"
+#include "SharedRenderTree.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ui {
+
+namespace {
+
+// Containers with at least this many children are split into jobs in parallel mode
+constexpr std::size_t kParallelMinChildren = 512;
+constexpr std::size_t kChildrenPerJob = 256;
+
+constexpr std::uint64_t kSequenceMask = 0xFFFFFFFFull;
+constexpr unsigned kLayerShift = 48;
+constexpr std::uint64_t kMaterialMask = 0xFFull << 32;
+
+// How many places SortRenderCommands may move a command ahead within a layer
+constexpr std::size_t kReorderWindow = 32;
+
+// Screen area a command paints (placeholder text metrics, as the renderer)
+Bounds CommandBounds(const RenderCommand& cmd) {
+    if (cmd.type == RenderCommand::Type::Text) {
+        const auto& text = cmd.textPayload;
+        return Bounds::FromRect(text.x, text.y, static_cast<float>(text.text.size()) * kTextGlyphWidth,
+                                kTextLineHeight);
+    }
+    const auto& rect = cmd.shapeRectPayload;
+    return Bounds::FromRect(rect.x, rect.y, rect.width, rect.height);
+}
+
+// Render tree as a traversal reads it: a context's render storage here,
+// or one frame of a shared tree (SharedTreeView, same interface)
+struct ContextTree {
+    RenderContext& ctx;
+
+    const RenderContainerNode* Container(NodeId id) const { return ctx.TryGetRenderNode<ContainerNodeData>(id); }
+    const RenderTextNode* Text(NodeId id) const { return ctx.TryGetRenderNode<TextNodeData>(id); }
+    const RenderShapeRectNode* Rect(NodeId id) const { return ctx.TryGetRenderNode<ShapeRectNodeData>(id); }
+    bool TryGetSubtreeBounds(NodeId id, Bounds& out) const { return ctx.TryGetSubtreeBounds(id, out); }
+
+    std::span<const NodeId> Children(const RenderContainerNode& node) const {
+        return {node.children.data(), node.children.size()};
+    }
+    std::string_view TextOf(const RenderTextNode& node) const { return {node.text.data(), node.text.size()}; }
+};
+
+// What a traversal reads besides the node ids
+template <typename Tree>
+struct Visit {
+    const Tree& tree;
+    const Bounds* viewport;  // null = no culling
+};
+
+// Pending children of one container on the traversal stack
+struct ChildRange {
+    const NodeId* next;
+    const NodeId* end;
+    int layer;              // of the container: its own plus its parents'
+    std::size_t depth;      // of the children
+};
+
+template <typename Tree, typename Node>
+ChildRange ChildrenOf(const Tree& tree, const Node& node, int parentLayer, std::size_t parentDepth) {
+    const std::span<const NodeId> children = tree.Children(node);
+    return ChildRange{children.data(), children.data() + children.size(), parentLayer + node.layer, parentDepth + 1};
+}
+
+template <typename Tree, typename Node>
+ChildRange ChildrenOf(const Tree& tree, const Node& node, const ChildRange& parent) {
+    return ChildrenOf(tree, node, parent.layer, parent.depth);
+}
+
+// Emits the command for a leaf child; returns the child if it is a container.
+// Subtrees whose known bounds miss the viewport are skipped whole.
+template <typename Tree>
+auto VisitChild(const Visit<Tree>& visit, NodeId childId, const ChildRange& range, RenderCommandList& out)
+    -> decltype(visit.tree.Container(childId)) {
+    const Tree& tree = visit.tree;
+    Bounds bounds;
+    if (visit.viewport && tree.TryGetSubtreeBounds(childId, bounds) && !visit.viewport->Intersects(bounds)) {
+        return nullptr;
+    }
+
+    // Try container first (most common case for tree traversal)
+    if (auto* container = tree.Container(childId)) {
+        return container;
+    }
+
+    // Try text node
+    if (auto* text = tree.Text(childId)) {
+        if (text->visible) {
+            const std::string_view chars = tree.TextOf(*text);
+            RenderCommand cmd{};
+            cmd.type = RenderCommand::Type::Text;
+            cmd.sortKey = MakeSortKey(range.layer + text->layer, range.depth, RenderMaterial::Text, 0);
+            cmd.textPayload.x = text->x;
+            cmd.textPayload.y = text->y;
+            cmd.textPayload.text.assign(chars.data(), chars.size());
+            out.push_back(std::move(cmd));
+        }
+        return nullptr;
+    }
+
+    // Try shape rect node
+    if (auto* shapeRect = tree.Rect(childId)) {
+        if (shapeRect->visible && shapeRect->width > 0.0f && shapeRect->height > 0.0f) {
+            RenderCommand cmd{};
+            cmd.type = RenderCommand::Type::ShapeRect;
+            cmd.sortKey = MakeSortKey(range.layer + shapeRect->layer, range.depth, RenderMaterial::Rect, 0);
+            cmd.shapeRectPayload.x = shapeRect->x;
+            cmd.shapeRectPayload.y = shapeRect->y;
+            cmd.shapeRectPayload.width = shapeRect->width;
+            cmd.shapeRectPayload.height = shapeRect->height;
+            out.push_back(std::move(cmd));
+        }
+        return nullptr;
+    }
+
+    // If all are nullptr: node was deleted, skip it
+    return nullptr;
+}
+
+// ---------------------------------
+// Parallel mode output
+// A job writes one Segment. Where it hands a wide container off to other jobs,
+// the current piece records their segments and a new piece starts, so
+// flattening pieces in order reproduces the serial order.
+// ---------------------------------
+
+struct Segment;
+
+struct SegmentPiece {
+    RenderCommandList commands;
+    std::vector<std::unique_ptr<Segment>> nested;  // flattened after `commands`
+};
+
+struct Segment {
+    std::vector<SegmentPiece> pieces;
+};
+
+template <typename Tree>
+void CollectSerial(const Visit<Tree>& visit, ChildRange range, RenderCommandList& out) {
+    std::vector<ChildRange> stack;
+    stack.push_back(range);
+    while (!stack.empty()) {
+        ChildRange& top = stack.back();
+        if (top.next == top.end) {
+            stack.pop_back();
+            continue;
+        }
+        const NodeId childId = *top.next++;
+        if (const auto* container = VisitChild(visit, childId, top, out)) {
+            stack.push_back(ChildrenOf(visit.tree, *container, top));
+        }
+    }
+}
+
+template <typename Tree>
+void CollectParallel(const Visit<Tree>& visit, ChildRange range, Segment& segment, TaskGroup& group) {
+    segment.pieces.emplace_back();
+
+    std::vector<ChildRange> stack;
+    stack.push_back(range);
+    while (!stack.empty()) {
+        ChildRange& top = stack.back();
+        if (top.next == top.end) {
+            stack.pop_back();
+            continue;
+        }
+        const NodeId childId = *top.next++;
+        const auto* container = VisitChild(visit, childId, top, segment.pieces.back().commands);
+        if (!container) {
+            continue;
+        }
+        const ChildRange children = ChildrenOf(visit.tree, *container, top);
+        if (static_cast<std::size_t>(children.end - children.next) < kParallelMinChildren) {
+            stack.push_back(children);
+            continue;
+        }
+
+        // Wide container: one job per run of children
+        SegmentPiece& piece = segment.pieces.back();
+        for (const NodeId* begin = children.next; begin < children.end; begin += kChildrenPerJob) {
+            const NodeId* end = (children.end - begin > static_cast<std::ptrdiff_t>(kChildrenPerJob))
+                ? begin + kChildrenPerJob
+                : children.end;
+            piece.nested.push_back(std::make_unique<Segment>());
+            Segment* nested = piece.nested.back().get();
+            group.Run("CollectRenderCommands::Subtree", [&visit, &group, nested, begin, end, children]() {
+                CollectParallel(visit, ChildRange{begin, end, children.layer, children.depth}, *nested, group);
+            });
+        }
+        segment.pieces.emplace_back();
+    }
+}
+
+std::size_t CountCommands(const Segment& segment) {
+    std::size_t count = 0;
+    for (const SegmentPiece& piece : segment.pieces) {
+        count += piece.commands.size();
+        for (const auto& nested : piece.nested) {
+            count += CountCommands(*nested);
+        }
+    }
+    return count;
+}
+
+void Flatten(Segment& segment, RenderCommandList& out) {
+    for (SegmentPiece& piece : segment.pieces) {
+        for (RenderCommand& cmd : piece.commands) {
+            out.push_back(std::move(cmd));
+        }
+        for (auto& nested : piece.nested) {
+            Flatten(*nested, out);
+        }
+    }
+}
+
+template <typename Tree>
+void CollectFrom(const Tree& tree, NodeId rootId, RenderCommandList& out, CollectMode mode, const Bounds& viewport) {
+    TRACE_SCOPE_DETAIL("CollectRenderCommands");
+
+    // Rebuild command buffer from scratch under render mutex to avoid
+    // unsynchronized access later when commands are executed.
+    out.clear();
+
+    const auto* rootRender = tree.Container(rootId);
+    if (!rootRender) {
+        return;
+    }
+
+    // An infinite viewport culls nothing: skip the bounds lookups
+    const Visit<Tree> visit{tree, viewport == Bounds::Infinite() ? nullptr : &viewport};
+
+    // Depth-first over containers, building commands from current render state
+    if (mode == CollectMode::Serial || JobSystem::Instance().WorkerCount() == 0) {
+        CollectSerial(visit, ChildrenOf(tree, *rootRender, 0, 0), out);
+        SortRenderCommands(out);
+        return;
+    }
+
+    // Workers read the render tree while this thread holds the render mutex
+    Segment root;
+    {
+        TaskGroup group;
+        CollectParallel(visit, ChildrenOf(tree, *rootRender, 0, 0), root, group);
+        group.Wait();
+    }
+
+    TRACE_SCOPE_DETAIL("CollectRenderCommands::Concatenate");
+    out.reserve(CountCommands(root));
+    Flatten(root, out);
+    SortRenderCommands(out);
+}
+
+} // namespace
+
+std::uint64_t MakeSortKey(int layer, std::size_t depth, RenderMaterial material, std::uint32_t sequence) {
+    const int clampedLayer = std::clamp<int>(layer, std::numeric_limits<std::int16_t>::min(),
+                                             std::numeric_limits<std::int16_t>::max());
+    const std::uint64_t biasedLayer = static_cast<std::uint64_t>(clampedLayer + 0x8000);
+    const std::uint64_t clampedDepth = std::min<std::size_t>(depth, 0xFF);
+    return (biasedLayer << kLayerShift) | (clampedDepth << 40) | (static_cast<std::uint64_t>(material) << 32) | sequence;
+}
+
+void CollectRenderCommands(RenderContext& ctx, NodeId rootId, RenderCommandList& out, CollectMode mode,
+                           const Bounds& viewport) {
+    CollectFrom(ContextTree{ctx}, rootId, out, mode, viewport);
+}
+
+void CollectRenderCommands(const SharedTreeView& tree, NodeId rootId, RenderCommandList& out, CollectMode mode,
+                           const Bounds& viewport) {
+    CollectFrom(tree, rootId, out, mode, viewport);
+}
+
+void SortRenderCommands(RenderCommandList& commands) {
+    TRACE_SCOPE_DETAIL("SortRenderCommands");
+    const std::size_t count = commands.size();
+
+    // The sequence bits hold the current order, so a stable sort on the
+    // layer keeps tree order within each layer: LSD radix over the two
+    // layer bytes, skipping a byte every key shares
+    thread_local std::vector<std::uint64_t> keys;
+    thread_local std::vector<std::uint64_t> scratch;
+    keys.resize(count);
+    std::array<std::array<std::uint32_t, 256>, 2> histograms{};
+    bool sorted = true;
+    for (std::size_t i = 0; i < count; ++i) {
+        RenderCommand& cmd = commands[i];
+        const std::uint64_t key = (cmd.sortKey & ~kSequenceMask) | static_cast<std::uint32_t>(i);
+        cmd.sortKey = key;
+        keys[i] = key;
+        sorted = sorted && (i == 0 || keys[i - 1] < key);
+        for (std::size_t pass = 0; pass < 2; ++pass) {
+            ++histograms[pass][(key >> (kLayerShift + 8 * pass)) & 0xFF];
+        }
+    }
+    if (sorted) {
+        return;
+    }
+
+    scratch.resize(count);
+    for (std::size_t pass = 0; pass < 2; ++pass) {
+        const unsigned shift = static_cast<unsigned>(kLayerShift + 8 * pass);
+        auto& histogram = histograms[pass];
+        if (histogram[(keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        std::uint32_t offset = 0;
+        for (std::uint32_t& bucket : histogram) {
+            const std::uint32_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (std::uint64_t key : keys) {
+            scratch[histogram[(key >> shift) & 0xFF]++] = key;
+        }
+        keys.swap(scratch);
+    }
+
+    // Within a layer, depth and material order commands only where that
+    // cannot change the image: a command moves ahead of its neighbour only
+    // if the neighbour's key is greater and the two do not overlap, and at
+    // most kReorderWindow places. Swapping two disjoint draws is invisible.
+    thread_local std::vector<Bounds> areas;  // of keys[i], moved along with it
+    areas.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        areas[i] = CommandBounds(commands[static_cast<std::size_t>(keys[i] & kSequenceMask)]);
+    }
+    for (std::size_t i = 1; i < count; ++i) {
+        const std::uint64_t key = keys[i];
+        const Bounds area = areas[i];
+        const std::size_t stop = i > kReorderWindow ? i - kReorderWindow : 0;
+        std::size_t at = i;
+        // Lower layers hold smaller keys, so a command never leaves its layer;
+        // it stops next to its own material, where it already batches
+        while (at > stop && (keys[at - 1] >> 32) > (key >> 32) && ((keys[at - 1] ^ key) & kMaterialMask) != 0 &&
+               !areas[at - 1].Intersects(area)) {
+            keys[at] = keys[at - 1];
+            areas[at] = areas[at - 1];
+            --at;
+        }
+        keys[at] = key;
+        areas[at] = area;
+    }
+
+    // Moved-from commands stay in `reordered` until the next frame reuses it
+    thread_local RenderCommandList reordered;
+    reordered.clear();
+    reordered.reserve(count);
+    for (std::uint64_t key : keys) {
+        reordered.push_back(std::move(commands[static_cast<std::size_t>(key & kSequenceMask)]));
+    }
+    commands.swap(reordered);
+}
+
+void BuildDrawBatches(const RenderCommandList& commands, std::vector<DrawBatch>& out) {
+    out.clear();
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        const RenderMaterial material = MaterialOf(commands[i].type);
+        if (out.empty() || out.back().material != material) {
+            out.push_back(DrawBatch{material, static_cast<std::uint32_t>(i), 0});
+        }
+        ++out.back().count;
+    }
+}
+
+} // namespace ui
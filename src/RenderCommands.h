@@ -0,0 +1,101 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "Bounds.h"
+#include "MemoryStats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ui {
+
+class RenderContext;
+class SharedTreeView;
+
+// GPU state a command draws with. Consecutive commands of one material are
+// drawn in one batch; values give the order within a layer and depth.
+enum class RenderMaterial : std::uint8_t {
+    Rect,
+    Text
+};
+
+// Draw order key, compared as an integer (high to low bits):
+//   63..48  effective layer (own layer plus the parents', biased to unsigned)
+//   47..40  tree depth, clamped to 255
+//   39..32  RenderMaterial
+//   31..0   collection (tree pre-)order
+// Layers always order commands. Within a layer, depth and material only
+// order commands that do not overlap (see SortRenderCommands); overlapping
+// ones keep tree order.
+std::uint64_t MakeSortKey(int layer, std::size_t depth, RenderMaterial material, std::uint32_t sequence);
+
+// Per-frame render command snapshot
+struct RenderCommand {
+    enum class Type {
+        Text,
+        ShapeRect
+    };
+    Type type;
+    std::uint64_t sortKey = 0;  // sequence bits are set by SortRenderCommands
+    struct TextPayload {
+        float x = 0.0f;
+        float y = 0.0f;
+        TrackedString<MemoryTag::RenderCommands> text;
+    };
+    struct ShapeRectPayload {
+        float x = 0.0f;
+        float y = 0.0f;
+        float width = 0.0f;
+        float height = 0.0f;
+    };
+
+    TextPayload textPayload;
+    ShapeRectPayload shapeRectPayload;
+};
+
+using RenderCommandList = TrackedVector<RenderCommand, MemoryTag::RenderCommands>;
+
+inline RenderMaterial MaterialOf(RenderCommand::Type type) {
+    return type == RenderCommand::Type::Text ? RenderMaterial::Text : RenderMaterial::Rect;
+}
+
+// Run of consecutive commands drawn with one draw call
+struct DrawBatch {
+    RenderMaterial material = RenderMaterial::Rect;
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+};
+
+enum class CollectMode {
+    Serial,
+    Parallel  // wide containers are split into subtree jobs on the JobSystem
+};
+
+// Render thread: rebuild `out` from the current render tree rooted at rootId.
+// Commands come out in draw order (see SortRenderCommands), the same in both
+// modes. Subtrees whose bounds lie entirely outside `viewport` are skipped
+// (see RenderContext::TryGetSubtreeBounds).
+// Must be called under RenderContext::RenderMutex().
+void CollectRenderCommands(RenderContext& ctx, NodeId rootId, RenderCommandList& out,
+                           CollectMode mode = CollectMode::Serial,
+                           const Bounds& viewport = Bounds::Infinite());
+
+// Compositor process: the same from one frame of a shared render tree
+// (see SharedRenderTree.h), commands identical to the context the frame was
+// published from. The frame is held, not locked: nothing else writes it.
+void CollectRenderCommands(const SharedTreeView& tree, NodeId rootId, RenderCommandList& out,
+                           CollectMode mode = CollectMode::Serial,
+                           const Bounds& viewport = Bounds::Infinite());
+
+// Number each command by its current position (the key's sequence bits),
+// then stable radix sort by layer. Within a layer a command then moves ahead
+// of neighbours with a greater key that it does not overlap, up to a short
+// window, to join commands of its material; the image is unchanged. Lists
+// already in key order are left as is.
+void SortRenderCommands(RenderCommandList& commands);
+
+// Split sorted commands into batches: one per run of adjacent commands of a material
+void BuildDrawBatches(const RenderCommandList& commands, std::vector<DrawBatch>& out);
+
+} // namespace ui
@@ -3,21 +3,389 @@
 
 #include "TraceProfiler.h"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace ui {
 
-void RenderContext::Sync() {
-	std::lock_guard lock(m_renderMutex);
+namespace {
+
+// Longest glide of an interpolated node: after an update stall it catches
+// up within this rather than crawling over the whole gap
+constexpr float kMaxInterpolationSeconds = 1.0f;
+
+// Lock `mutex`, adding the time spent blocked to `waits`
+std::unique_lock<std::mutex> LockMeasured(std::mutex& mutex, WaitHistogram& waits) {
+    TRACE_SCOPE_DETAIL("RenderContext::WaitRenderMutex");
+    const auto begin = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    waits.Add(std::chrono::steady_clock::now() - begin);
+    return lock;
+}
+
+} // namespace
+
+RenderContext::RenderContext() = default;
+
+RenderContext::~RenderContext() {
+    for (auto& type : m_types) {
+        delete type.load(std::memory_order_relaxed);
+    }
+}
+
+std::unique_lock<std::mutex> RenderContext::LockForRender() {
+    return LockMeasured(m_renderMutex, m_renderLockWaits);
+}
+
+SyncResult RenderContext::ProcessAllRegisteredTypes(ChangeBatchList& batches, const SyncBudget& budget) {
+    std::lock_guard<std::mutex> handlersLock(m_handlersMutex);
+    SyncResult result;
+
+    const bool budgeted = !budget.Unlimited();
+    std::vector<std::size_t> merged(m_typeHandlers.size(), 0);
+    {
+        TaskGroup group;
+        for (std::size_t i = 1; i < m_typeHandlers.size(); ++i) {
+            group.Run("RenderContext::MergeType", [this, i, budgeted, &merged, &batches]() {
+                merged[i] = m_typeHandlers[i].merge(this, batches, budgeted);
+            });
+        }
+        if (!m_typeHandlers.empty()) {
+            merged.front() = m_typeHandlers.front().merge(this, batches, budgeted);
+        }
+        group.Wait();
+    }
+    for (std::size_t count : merged) {
+        result.applied += count;
+    }
+
+    if (budgeted) {
+        TRACE_SCOPE_DETAIL("RenderContext::PlanSync");
+        SyncPlan plan;
+        std::vector<std::size_t> firsts;
+        firsts.reserve(m_typeHandlers.size());
+        for (auto& handler : m_typeHandlers) {
+            firsts.push_back(plan.entries.size());
+            handler.describe(this, plan);
+        }
+        result.applied = SelectWithinBudget(plan, ChangeLimit(budget));
+        for (std::size_t i = 0; i < m_typeHandlers.size(); ++i) {
+            result.deferred += m_typeHandlers[i].takeSelected(this, plan, firsts[i]);
+        }
+    }
+    m_deferredChanges.store(result.deferred, std::memory_order_relaxed);
+
+    if (m_capture) {
+        TRACE_SCOPE_DETAIL("RenderContext::CaptureChanges");
+        m_capture->BeginFrame(m_nodeIdAllocator.IndexLimit());
+        for (auto& handler : m_typeHandlers) {
+            handler.capture(this, *m_capture);
+        }
+        m_capture->EndFrame();
+    }
+    if (m_displayStream) {
+        TRACE_SCOPE_DETAIL("RenderContext::StreamChanges");
+        m_displayStream->BeginFrame(*this, m_nodeIdAllocator);
+        for (auto& handler : m_typeHandlers) {
+            handler.stream(this, *m_displayStream);
+        }
+        m_displayStream->EndFrame();
+    }
+
+    const auto applyBegin = std::chrono::steady_clock::now();
+    {
+        TaskGroup group;
+        for (std::size_t i = 1; i < m_typeHandlers.size(); ++i) {
+            TypeHandler& handler = m_typeHandlers[i];
+            group.Run("RenderContext::ProcessType", [this, &handler, &group]() { handler.process(this, group); });
+        }
+        if (!m_typeHandlers.empty()) {
+            m_typeHandlers.front().process(this, group);
+        }
+        group.Wait();
+    }
+
+    {
+        TRACE_SCOPE_DETAIL("RenderContext::CollectBoundsChanges");
+        // Before this Sync's deletions are unlinked, so settling cannot revive them
+        m_animations.SettleFinished(*this);
+        const auto now = std::chrono::steady_clock::now();
+        m_syncInterval = std::min(std::chrono::duration<float>(now - m_syncTime).count(), kMaxInterpolationSeconds);
+        m_syncTime = now;
+        for (auto& handler : m_typeHandlers) {
+            handler.collectBounds(this);
+        }
+    }
+
+    // Allocator and storage slots of deleted nodes are shared state: apply serially
+    {
+        TRACE_SCOPE_DETAIL("RenderContext::ApplyDeletions");
+        for (auto& handler : m_typeHandlers) {
+            handler.applyDeletions(this);
+        }
+    }
+
+    UpdateBounds();
+
+    // Apply cost per change for time budgets; small Syncs are mostly overhead
+    if (result.applied >= 64) {
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - applyBegin).count();
+        m_syncNsPerChange += 0.25 * (ns / static_cast<double>(result.applied) - m_syncNsPerChange);
+    }
+    return result;
+}
+
+RenderContext::NodeBounds& RenderContext::BoundsSlot(NodeId id) {
+    const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+    if (index >= m_bounds.size()) {
+        m_bounds.resize(index + 1);
+    }
+    NodeBounds& slot = m_bounds[index];
+    if (slot.id != id) {
+        if (slot.id != 0 && slot.leaf && slot.known) {
+            MoveLeaf(slot.id, slot.bounds, Bounds{});
+        }
+        // A stale id left in the worklist just fails its liveness check
+        slot = NodeBounds{};
+        slot.id = id;
+    }
+    return slot;
+}
+
+void RenderContext::LinkChild(NodeId parent, NodeId child) {
+    BoundsSlot(child).parent = parent;
+}
+
+void RenderContext::SetLeafBounds(NodeId id, const Bounds& bounds) {
+    NodeBounds& slot = BoundsSlot(id);
+    if (slot.known && slot.bounds == bounds) {
+        return;
+    }
+    MoveLeaf(id, slot.known ? slot.bounds : Bounds{}, bounds);
+    slot.bounds = bounds;
+    slot.known = true;
+    slot.leaf = true;
+    if (slot.parent != 0) {
+        MarkBoundsDirty(slot.parent);
+    }
+}
+
+void RenderContext::UnlinkDeleted(NodeId id) {
+    const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+    if (index >= m_bounds.size() || m_bounds[index].id != id) {
+        return;
+    }
+    const NodeId parent = m_bounds[index].parent;
+    if (m_bounds[index].leaf && m_bounds[index].known) {
+        MoveLeaf(id, m_bounds[index].bounds, Bounds{});
+    }
+    m_bounds[index].id = 0;
+    m_bounds[index].known = false;
+    if (parent != 0) {
+        MarkBoundsDirty(parent);
+    }
+}
+
+void RenderContext::MarkBoundsDirty(NodeId container) {
+    if (!IsAlive(container)) {
+        return;
+    }
+    NodeBounds& slot = BoundsSlot(container);
+    if (!slot.queued) {
+        slot.queued = true;
+        m_boundsDirty.push_back(container);
+    }
+}
+
+void RenderContext::MoveLeaf(NodeId id, const Bounds& before, const Bounds& after) {
+    if (!before.IsEmpty() || !after.IsEmpty()) {
+        m_leafMoves.push_back(SpatialUpdate{id, before, after});
+    }
+}
+
+void RenderContext::UpdateBounds() {
+    TRACE_SCOPE_DETAIL("RenderContext::UpdateBounds");
+    std::vector<NodeId> round;
+    while (!m_boundsDirty.empty()) {
+        round.clear();
+        round.swap(m_boundsDirty);
+        for (NodeId id : round) {
+            m_bounds[static_cast<std::size_t>(ExtractIndex(id))].queued = false;
+        }
+
+        for (NodeId id : round) {
+            const RenderContainerNode* node = TryGetRenderNode<ContainerNodeData>(id);
+            if (!node || !IsAlive(id)) {
+                continue;
+            }
+
+            // Unknown child bounds make the container unknown too (never culled)
+            Bounds bounds;
+            bool known = true;
+            for (NodeId child : node->children) {
+                if (!IsAlive(child)) {
+                    continue;  // pruned from the list on its next children write
+                }
+                Bounds childBounds;
+                if (!TryGetSubtreeBounds(child, childBounds)) {
+                    known = false;
+                    break;
+                }
+                bounds.Add(childBounds);
+            }
+
+            NodeBounds& slot = BoundsSlot(id);
+            if (slot.known == known && (!known || slot.bounds == bounds)) {
+                continue;
+            }
+            slot.bounds = bounds;
+            slot.known = known;
+            if (slot.parent != 0) {
+                MarkBoundsDirty(slot.parent);
+            }
+        }
+    }
+
+    m_spatialIndex.Apply(m_leafMoves);
+    m_leafMoves.clear();
+}
+
+std::size_t RenderContext::ChangeLimit(const SyncBudget& budget) const {
+    std::size_t limit = budget.maxChanges > 0 ? budget.maxChanges : std::numeric_limits<std::size_t>::max();
+    if (budget.time.count() > 0) {
+        const double ns = std::chrono::duration<double, std::nano>(budget.time).count();
+        limit = std::min(limit, static_cast<std::size_t>(ns / m_syncNsPerChange));
+    }
+    // Always make progress
+    return std::max<std::size_t>(limit, 1);
+}
+
+std::size_t RenderContext::SelectWithinBudget(SyncPlan& plan, std::size_t limit) {
+    constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+    const std::size_t count = plan.entries.size();
+    plan.selected.assign(count, 0);
+
+    // 0 = unvisited, 1 = on the DFS stack, 2 = selected
+    std::vector<std::uint8_t> state(count, 0);
+    std::size_t selected = 0;
+
+    // Deletions are cheap and free ids other records may be waiting on
+    for (std::size_t i = 0; i < count; ++i) {
+        if (plan.entries[i].deleted) {
+            plan.selected[i] = 1;
+            state[i] = 2;
+            ++selected;
+        }
+    }
+
+    // Entry + 1 by handle index (ids are unique across types); left all zero
+    thread_local std::vector<std::uint32_t> positions;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t index = static_cast<std::size_t>(ExtractIndex(plan.entries[i].id));
+        if (index >= positions.size()) {
+            positions.resize(index + 1, 0);
+        }
+        positions[index] = static_cast<std::uint32_t>(i + 1);
+    }
+    auto find = [&plan](NodeId id) -> std::size_t {
+        const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+        if (index >= positions.size() || positions[index] == 0) {
+            return kNone;
+        }
+        const std::size_t entry = positions[index] - 1;
+        return plan.entries[entry].id == id ? entry : kNone;
+    };
+
+    // Entries by priority, record order within one priority
+    std::vector<std::size_t> order;
+    order.reserve(count);
+    for (std::uint8_t priority = kSyncPriorityLive; priority <= kSyncPriorityHidden; ++priority) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (plan.entries[i].priority == priority) {
+                order.push_back(i);
+            }
+        }
+    }
+
+    // Post-order walk over pending children: a record is selected only after
+    // every pending record it links, so an unfinished subtree stays unlinked
+    std::vector<std::pair<std::size_t, std::size_t>> stack;  // entry, next child
+    for (std::size_t root : order) {
+        if (selected >= limit) {
+            break;
+        }
+        if (state[root] != 0) {
+            continue;
+        }
+        state[root] = 1;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [entry, next] = stack.back();
+            const auto* children = plan.entries[entry].children;
+            if (children && next < children->size()) {
+                const std::size_t child = find((*children)[next++]);
+                // On-stack children (malformed cycles) do not block their parent
+                if (child != kNone && state[child] == 0) {
+                    state[child] = 1;
+                    stack.emplace_back(child, 0);
+                }
+                continue;
+            }
+            if (selected >= limit) {
+                break;
+            }
+            plan.selected[entry] = 1;
+            state[entry] = 2;
+            ++selected;
+            stack.pop_back();
+        }
+        stack.clear();
+    }
+
+#ifndef NDEBUG
+    // Subtrees stay atomic: a selected record links no pending record left for later
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!plan.selected[i] || !plan.entries[i].children) {
+            continue;
+        }
+        for (NodeId child : *plan.entries[i].children) {
+            const std::size_t entry = find(child);
+            // (a child still on the DFS stack closes a malformed cycle)
+            assert((entry == kNone || plan.selected[entry] || state[entry] == 1) &&
+                   "record selected before a pending child");
+        }
+    }
+#endif
+
+    for (const SyncPlanEntry& entry : plan.entries) {
+        positions[static_cast<std::size_t>(ExtractIndex(entry.id))] = 0;
+    }
+    return selected;
+}
+
+SyncResult RenderContext::Sync(const SyncBudget& budget) {
+	auto lock = LockMeasured(m_renderMutex, m_syncLockWaits);
 
     TRACE_SCOPE("RenderContext::Sync");
 
+    // This thread's writes join whatever other producers already published
+    m_changeBuffer.Publish();
+    ChangeBatchList batches = m_changeBuffer.TakePublished();
+    TRACE_COUNTER("sync.change_batches", batches.size());
+
 	// Process all types that were accessed via AccessData<T>
 	// Handlers are automatically registered on first AccessData<T> call
-	ProcessAllRegisteredTypes();
+	const SyncResult result = ProcessAllRegisteredTypes(batches, budget);
+    TRACE_COUNTER("sync.deferred_changes", result.deferred);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    if (m_simulatedSyncCost.count() > 0) {
+        std::this_thread::sleep_for(m_simulatedSyncCost);
+    }
+    return result;
 }
 
 } // namespace ui
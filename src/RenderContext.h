@@ -1,12 +1,27 @@
 #pragma once
 
 #include "ui_ids.h"
+#include "Animation.h"
+#include "Bounds.h"
 #include "ChangeBuffer.h"
+#include "ChangeCapture.h"
+#include "DisplayStream.h"
+#include "JobSystem.h"
+#include "MemoryStats.h"
 #include "NodeData.h"
 #include "NodeIdAllocator.h"
-
+#include "SpatialIndex.h"
+#include "TraceProfiler.h"
+#include "WaitHistogram.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -27,30 +42,88 @@ struct RenderContainerNode {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
-    std::vector<NodeId> children;  // Store only NodeId, resolve type dynamically
+    std::int16_t layer = 0;
+    TrackedVector<NodeId, MemoryTag::RenderStorage> children;  // Store only NodeId, resolve type dynamically
 };
 
 struct RenderTextNode {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
-    std::string text;
+    std::int16_t layer = 0;
+    // x, y show the node; new positions are reached over one Sync interval
+    // (see RenderContext::StartAnimations)
+    bool interpolated = false;
+    TrackedString<MemoryTag::RenderStorage> text;
 };
 
 struct RenderShapeNode {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;
 };
 
 struct RenderShapeRectNode {
     float x = 0.0f;
     float y = 0.0f;
     bool visible = true;
+    std::int16_t layer = 0;
+    bool interpolated = false;  // as in RenderTextNode
     float width = 0.0f;
     float height = 0.0f;
 };
 
+// Screen-space area a leaf draws (see CollectRenderCommands); empty if it draws nothing
+inline Bounds LeafBounds(const RenderTextNode& node) {
+    if (!node.visible || node.text.empty()) {
+        return Bounds{};
+    }
+    return Bounds::FromRect(node.x, node.y, static_cast<float>(node.text.size()) * kTextGlyphWidth, kTextLineHeight);
+}
+
+inline Bounds LeafBounds(const RenderShapeNode&) {
+    return Bounds{};  // not drawn
+}
+
+inline Bounds LeafBounds(const RenderShapeRectNode& node) {
+    if (!node.visible || node.width <= 0.0f || node.height <= 0.0f) {
+        return Bounds{};
+    }
+    return Bounds::FromRect(node.x, node.y, node.width, node.height);
+}
+
+// Field an animation of `property` drives; null if the node has none
+inline float* AnimatedField(RenderTextNode& node, AnimatedProperty property) {
+    switch (property) {
+        case AnimatedProperty::X:
+            return &node.x;
+        case AnimatedProperty::Y:
+            return &node.y;
+        default:
+            return nullptr;
+    }
+}
+
+inline float* AnimatedField(RenderShapeRectNode& node, AnimatedProperty property) {
+    switch (property) {
+        case AnimatedProperty::X:
+            return &node.x;
+        case AnimatedProperty::Y:
+            return &node.y;
+        case AnimatedProperty::Width:
+            return &node.width;
+        case AnimatedProperty::Height:
+            return &node.height;
+    }
+    return nullptr;
+}
+
+template <typename Node>
+float* AnimatedField(Node&, AnimatedProperty) {
+    return nullptr;
+}
+
 // Traits for mapping NodeData types to RenderNode types and storage
 template <typename T>
 struct RenderNodeTraits;
@@ -58,21 +131,25 @@ struct RenderNodeTraits;
 template <>
 struct RenderNodeTraits<ContainerNodeData> {
     using RenderNodeType = RenderContainerNode;
+    static constexpr bool kIsContainer = true;  // bounds aggregate its children
 };
 
 template <>
 struct RenderNodeTraits<TextNodeData> {
     using RenderNodeType = RenderTextNode;
+    static constexpr bool kIsContainer = false;
 };
 
 template <>
 struct RenderNodeTraits<ShapeNodeData> {
     using RenderNodeType = RenderShapeNode;
+    static constexpr bool kIsContainer = false;
 };
 
 template <>
 struct RenderNodeTraits<ShapeRectNodeData> {
     using RenderNodeType = RenderShapeRectNode;
+    static constexpr bool kIsContainer = false;
 };
 
 // ---------------------------------
@@ -88,26 +165,37 @@ public:
         const std::uint16_t gen = ExtractGeneration(id);
 
         // Expand vector if needed
-        if (idx >= m_nodes.size()) {
-            m_nodes.resize(idx + 1);
-            m_generations.resize(idx + 1, 0);
-        }
+        Reserve(idx + 1);
 
         // Check generation match
-        if (m_generations[idx] != gen) {
+        if (!m_occupied[idx] || m_generations[idx] != gen) {
             // Generation mismatch: reinitialize slot
             m_nodes[idx] = RenderNodeType{};
             m_generations[idx] = gen;
+            m_occupied[idx] = 1;
         }
 
         return &m_nodes[idx];
     }
 
+    // Grow to hold indices [0, size) so EnsureRenderNode never reallocates;
+    // lets disjoint indices be written from several threads
+    void Reserve(std::uint64_t size) {
+        if (size > m_nodes.size()) {
+            m_nodes.resize(size);
+            m_generations.resize(size, 0);
+            m_occupied.resize(size, 0);
+        }
+    }
+
+    // Null unless a node of this type was created for exactly this handle.
+    // Indices are shared by all types, so a slot that was only grown into
+    // must not match a handle of another type.
     RenderNodeType* TryGetRenderNode(NodeId id) {
         const std::uint64_t idx = ExtractIndex(id);
         const std::uint16_t gen = ExtractGeneration(id);
 
-        if (idx >= m_nodes.size() || m_generations[idx] != gen) {
+        if (idx >= m_nodes.size() || !m_occupied[idx] || m_generations[idx] != gen) {
             return nullptr;
         }
 
@@ -117,120 +205,671 @@ public:
     void ClearNode(std::uint64_t idx, std::uint16_t newGeneration) {
         if (idx < m_generations.size()) {
             m_generations[idx] = newGeneration;
+            m_occupied[idx] = 0;
         }
         if (idx < m_nodes.size()) {
             m_nodes[idx] = RenderNodeType{};
         }
     }
 
-    const std::vector<RenderNodeType>& GetNodes() const { return m_nodes; }
+    const TrackedVector<RenderNodeType, MemoryTag::RenderStorage>& GetNodes() const { return m_nodes; }
+
+    // f(id, node) for every node of this type, in index order
+    template <typename F>
+    void ForEachNode(F&& f) const {
+        for (std::size_t idx = 0; idx < m_nodes.size(); ++idx) {
+            if (m_occupied[idx]) {
+                f(MakeNodeId(idx, m_generations[idx]), m_nodes[idx]);
+            }
+        }
+    }
 
 private:
-    std::vector<RenderNodeType> m_nodes;
-    std::vector<std::uint16_t> m_generations;  // generation per slot
+    TrackedVector<RenderNodeType, MemoryTag::RenderStorage> m_nodes;
+    TrackedVector<std::uint16_t, MemoryTag::RenderStorage> m_generations;  // generation per slot
+    // 1 once a node of this type lives in the slot (bytes, not bits: written concurrently by Sync jobs)
+    TrackedVector<std::uint8_t, MemoryTag::RenderStorage> m_occupied;
+};
+
+// Limits for one Sync; zero fields are unlimited.
+// A budgeted Sync applies part of the pending changes and keeps the rest
+// queued for the next one. Records are applied leaves-first: a container's
+// children are linked only in the Sync that applies the last pending record
+// of the attached subtrees, so the render side never sees a partially built
+// subtree. Deletions are never deferred.
+struct SyncBudget {
+    // Converted to a change count from the measured apply cost per change;
+    // merging and planning the deferred records come on top
+    std::chrono::microseconds time{0};
+    std::size_t maxChanges = 0;
+
+    bool Unlimited() const { return time.count() <= 0 && maxChanges == 0; }
+};
+
+struct SyncResult {
+    std::size_t applied = 0;   // records written or deleted by this Sync
+    std::size_t deferred = 0;  // records left for later Syncs
 };
 
 // RenderContext: owns ChangeBuffer and render tree
-// Singleton pattern - single instance for the entire application
+// Each instance is an independent UI tree (own ids, buffers, storage and
+// handlers); Instance() is the default context used by the sandbox.
 
 class RenderContext {
 public:
-    // Get singleton instance
+    // Get default instance
     static RenderContext& Instance() {
         static RenderContext instance;
         return instance;
     }
 
+    RenderContext();
+    ~RenderContext();
+
     // Delete copy constructor and assignment operator
     RenderContext(const RenderContext&) = delete;
     RenderContext& operator=(const RenderContext&) = delete;
 
-    // Allocate new NodeId (delegates to allocator)
+    // Allocate new NodeId (delegates to allocator); any producer thread
     NodeId AllocateNodeId() {
         return m_nodeIdAllocator.Allocate();
     }
 
-    // Update thread API: access write-side data for any type
-    // Automatically registers ProcessChanges<T> handler on first access
+    // False once the node's deletion has been applied by Sync; any thread
+    bool IsAlive(NodeId id) const {
+        return m_nodeIdAllocator.GetGeneration(ExtractIndex(id)) == ExtractGeneration(id);
+    }
+
+    // Producer thread API: access write-side data for any type in this
+    // thread's change shard. Automatically registers ProcessChanges<T>
+    // handler on first access
     template <typename T>
     T& AccessData(NodeId id) {
-        RegisterTypeHandler<T>();
+        if (!m_types[ChangeTypeId<T>()].load(std::memory_order_acquire)) {
+            RegisterTypeHandler<T>();
+        }
         return m_changeBuffer.AccessData<T>(id);
     }
 
+    // Producer thread: hand this thread's writes to the next Sync.
+    // Sync publishes its own thread's writes itself; other producers call
+    // this at the end of each batch of mutations. Conflicting writes to a
+    // field are resolved in publish order (last published wins).
+    void PublishChanges() {
+        m_changeBuffer.Publish();
+    }
+
     // Template methods for accessing render nodes by NodeData type
+    // Sync only: the type is registered once it has changes
     template <typename T>
     auto EnsureRenderNode(NodeId id) -> typename RenderNodeTraits<T>::RenderNodeType* {
-        return Storage<T>().EnsureRenderNode(id);
+        return State<T>()->storage.EnsureRenderNode(id);
     }
 
+    // Null if the node does not exist or no node of type T was ever written
     template <typename T>
     auto TryGetRenderNode(NodeId id) -> typename RenderNodeTraits<T>::RenderNodeType* {
-        return Storage<T>().TryGetRenderNode(id);
+        TypeState<T>* state = State<T>();
+        return state ? state->storage.TryGetRenderNode(id) : nullptr;
+    }
+
+    // f(id, node) for every render node of type T, in index order. Render
+    // thread, under the render mutex (see SharedTreePublisher::Publish)
+    template <typename T, typename F>
+    void ForEachRenderNode(F&& f) {
+        if (TypeState<T>* state = State<T>()) {
+            state->storage.ForEachNode(f);
+        }
     }
 
     // Update thread: called at the end of update
-    // Under render mutex: applies changes to render tree.
-    void Sync();
+    // Under render mutex: applies published changes to render tree, all of
+    // them unless a budget is given (see SyncBudget).
+    SyncResult Sync(const SyncBudget& budget = {});
+
+    // Records deferred by the last budgeted Sync
+    std::size_t DeferredChanges() const { return m_deferredChanges.load(std::memory_order_relaxed); }
+
+    // Render thread (under render mutex): screen bounds of a node's subtree,
+    // its own drawn area for leaves and the union of its children for
+    // containers. False when they are not known (never cull such nodes).
+    // Maintained incrementally by Sync.
+    bool TryGetSubtreeBounds(NodeId id, Bounds& out) const {
+        const std::size_t index = static_cast<std::size_t>(ExtractIndex(id));
+        if (index >= m_bounds.size() || m_bounds[index].id != id || !m_bounds[index].known) {
+            return false;
+        }
+        out = m_bounds[index].bounds;
+        return true;
+    }
+
+    // Any thread, without the render mutex: leaves whose indexed bounds
+    // contain the point / intersect `area` as of the last Sync. That is the
+    // drawn area (see LeafBounds), except for leaves with running
+    // animations: those are indexed over their whole path (see
+    // AnimatedLeafBounds) and hit anywhere along it, wherever they are drawn
+    // now. Callers that need exact hits for them check LeafBounds of the
+    // render node under the render mutex.
+    // Appended in no particular order; ids may be deleted by the time they
+    // are used (check IsAlive). Returns the number of ids appended.
+    std::size_t QueryPoint(float x, float y, std::vector<NodeId>& out) const {
+        return m_spatialIndex.QueryPoint(x, y, out);
+    }
+    std::size_t QueryRect(const Bounds& area, std::vector<NodeId>& out) const {
+        return m_spatialIndex.QueryRect(area, out);
+    }
+
+    // Render thread, under the render mutex: move animated properties to
+    // their values at `now` (see AnimationSystem). Bounds of animated leaves
+    // cover their whole path, so culling stays conservative and QueryPoint /
+    // QueryRect may report them where they are not drawn at the moment.
+    void AdvanceAnimations(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+        m_animations.Advance(*this, now);
+    }
+
+    // Under the render mutex: (node, property) animations still running
+    std::size_t RunningAnimations() const { return m_animations.Size(); }
+
+    // Update thread, after Sync: write the render tree (every node, child
+    // lists, strings and the id allocator's state) and `root` to a scene
+    // snapshot file (see SceneSnapshot.h). Changes not applied by a Sync yet
+    // and running animations are not saved. False if the file cannot be written.
+    bool SaveSnapshot(const std::string& path, NodeId root);
+
+    // On a context no id was allocated from yet: recreate a saved render
+    // tree under the same ids, as if its nodes had been built and synced,
+    // and return its root. False (context unchanged) if the file is not a
+    // valid snapshot or the context is in use.
+    bool LoadSnapshot(const std::string& path, NodeId& root);
+
+    // Update thread: record what every following Sync applies to `path`
+    // (see ChangeCapture.h) until StopCapture(). `root` is stored for the
+    // replay to render from. A replay starts from this context's state
+    // now: capture from a context nothing was synced to yet, or
+    // SaveSnapshot right before. False if already capturing or the file
+    // cannot be created.
+    bool StartCapture(const std::string& path, NodeId root);
+    // False if no capture was running or writing it failed
+    bool StopCapture();
+
+    // Send every Sync's applied records to a viewer connecting to the Unix
+    // socket `path` (see DisplayStream.h) until StopDisplayStream(), with a
+    // keyframe every `keyframeInterval` Syncs (0 = only when needed).
+    // False if already streaming or the socket cannot be bound.
+    bool StartDisplayStream(const std::string& path, NodeId root, std::size_t keyframeInterval = 120);
+    // Totals of the stream; zero if none was running
+    DisplayStreamStats StopDisplayStream();
+
+    // Ids with an index below `limit` were allocated elsewhere (a replayed
+    // capture, see ChangeReplay::Prepare); their deletions are applied
+    void ReserveIds(std::uint64_t limit) { m_nodeIdAllocator.Reserve(limit); }
+
+    // Fresh context only: take over another allocator's generation of each
+    // index below generations.size() (a display stream keyframe, see
+    // DisplayViewer), all of them handed out. False if ids were used here.
+    bool RestoreIds(const std::vector<std::uint16_t>& generations) {
+        const std::vector<std::uint8_t> live(generations.size(), 1);
+        return m_nodeIdAllocator.Restore(generations.data(), live.data(), generations.size());
+    }
 
     // Render thread: read-only access to render tree under render mutex
     std::mutex& RenderMutex() { return m_renderMutex; }
 
+    // Render thread: lock the render mutex, recording the wait in RenderLockWaits()
+    std::unique_lock<std::mutex> LockForRender();
+
+    // Time spent blocked on the render mutex, per side
+    WaitHistogram& SyncLockWaits() { return m_syncLockWaits; }
+    WaitHistogram& RenderLockWaits() { return m_renderLockWaits; }
+
+    // Artificial cost added to every Sync (under the render mutex) to
+    // emulate heavy change application. Zero by default.
+    void SetSimulatedSyncCost(std::chrono::microseconds cost) { m_simulatedSyncCost = cost; }
+    std::chrono::microseconds SimulatedSyncCost() const { return m_simulatedSyncCost; }
+
+    // Upper bound on distinct NodeData types per process
+    static constexpr std::size_t kMaxNodeTypes = 32;
+
 private:
-    // Private constructor for singleton
-    RenderContext() = default;
-    // Static method to get TypeStorage for a specific type
+    // Changes of one type taken for the current Sync
+    template <typename T>
+    struct PendingChanges {
+        TrackedVector<T, MemoryTag::ChangeBuffer> changes;
+        TrackedVector<NodeId, MemoryTag::ChangeBuffer> deletions;
+    };
+
+    // Merged records a budgeted Sync has not applied yet; later writes to
+    // the same node are folded in, so every node has at most one record.
+    // Only records of alive ids are folded (see MergeChanges), so no two
+    // records share a handle index either.
+    template <typename T>
+    struct DeferredRecords {
+        TrackedVector<T, MemoryTag::ChangeBuffer> records;
+        std::vector<std::uint32_t> positions;  // by handle index: position + 1, 0 = none
+
+        void Fold(TrackedVector<T, MemoryTag::ChangeBuffer>&& changes) {
+            for (T& change : changes) {
+                const std::size_t index = static_cast<std::size_t>(ExtractIndex(change.id));
+                if (index >= positions.size()) {
+                    positions.resize(index + 1, 0);
+                }
+                const std::uint32_t position = positions[index];
+                assert((position == 0 || ExtractIndex(records[position - 1].id) == index) &&
+                       "deferred record position points at another index");
+                assert((position == 0 || records[position - 1].id == change.id) &&
+                       "two generations of one index deferred");
+                if (position != 0 && records[position - 1].id == change.id) {
+                    records[position - 1].MergeFrom(std::move(change));
+                } else {
+                    positions[index] = static_cast<std::uint32_t>(records.size() + 1);
+                    records.push_back(std::move(change));
+                }
+            }
+        }
+
+        // Move records[i] out, filling the hole with the last record
+        T Take(std::size_t i) {
+            T out = std::move(records[i]);
+            Forget(out.id, i);
+            if (i + 1 != records.size()) {
+                records[i] = std::move(records.back());
+                // Repoint only if the moved record was the one its index maps to
+                std::uint32_t& position = positions[static_cast<std::size_t>(ExtractIndex(records[i].id))];
+                if (position == records.size()) {
+                    position = static_cast<std::uint32_t>(i + 1);
+                }
+            }
+            records.pop_back();
+            return out;
+        }
+
+        TrackedVector<T, MemoryTag::ChangeBuffer> TakeAll() {
+            for (std::size_t i = 0; i < records.size(); ++i) {
+                Forget(records[i].id, i);
+            }
+            return std::move(records);
+        }
+
+    private:
+        void Forget(NodeId id, std::size_t i) {
+            std::uint32_t& position = positions[static_cast<std::size_t>(ExtractIndex(id))];
+            if (position == i + 1) {
+                position = 0;
+            }
+        }
+    };
+
+    struct TypeStateBase {
+        virtual ~TypeStateBase() = default;
+    };
+
+    // Per-instance render storage and Sync scratch for one NodeData type
+    template <typename T>
+    struct TypeState final : TypeStateBase {
+        TypeStorage<typename RenderNodeTraits<T>::RenderNodeType> storage;
+        PendingChanges<T> pending;
+        DeferredRecords<T> deferred;
+    };
+
+    // Null until the first AccessData<T> on this context
     template <typename T>
-    static TypeStorage<typename RenderNodeTraits<T>::RenderNodeType>& Storage() {
-        static TypeStorage<typename RenderNodeTraits<T>::RenderNodeType> storage;
-        return storage;
+    TypeState<T>* State() {
+        return static_cast<TypeState<T>*>(m_types[ChangeTypeId<T>()].load(std::memory_order_acquire));
     }
 
-    // Template method to process changes for any type
+    // Changes per job when a type's change list is split across workers
+    static constexpr std::size_t kSyncChunkSize = 4096;
+
+    // Budgeted Sync: lower priorities apply first
+    enum SyncPriority : std::uint8_t {
+        kSyncPriorityLive = 0,    // node already has a render node
+        kSyncPriorityNew = 1,
+        kSyncPriorityHidden = 2,  // new node written as invisible
+    };
+
+    // One merged record as seen by the budget planner
+    struct SyncPlanEntry {
+        NodeId id = 0;
+        std::uint8_t priority = kSyncPriorityNew;
+        bool deleted = false;
+        const TrackedVector<NodeId, MemoryTag::ChangeBuffer>* children = nullptr;  // appended ids
+    };
+
+    struct SyncPlan {
+        std::vector<SyncPlanEntry> entries;  // types in handler order
+        std::vector<std::uint8_t> selected;  // per entry: apply in this Sync
+    };
+
+    // Phase 0 (one task per type): merge this type's records across batches.
+    // A budgeted Sync folds them into the deferred records and plans over
+    // those; otherwise everything, deferred records included, is applied.
+    // Returns the number of records up for this Sync.
     template <typename T>
-    void ProcessChanges() {
-        auto changes = m_changeBuffer.Snapshot<T>();
+    std::size_t MergeChanges(ChangeBatchList& batches, bool budgeted) {
+        TRACE_SCOPE_DETAIL("RenderContext::MergeChanges");
+        TypeState<T>& state = *State<T>();
+        PendingChanges<T>& pending = state.pending;
+        pending.changes = ChangeBuffer::Merge<T>(batches);
+        // Writes to handles whose deletion was already applied are skipped by the flush
+        const auto stale = [this](const T& change) { return !IsAlive(change.id); };
+        if (!budgeted && state.deferred.records.empty()) {
+            return pending.changes.size() -
+                   static_cast<std::size_t>(std::count_if(pending.changes.begin(), pending.changes.end(), stale));
+        }
 
-        for (auto& change : changes) {
-            if (change.deleted) {
-                const std::uint64_t idx = ExtractIndex(change.id);
-                m_nodeIdAllocator.Free(change.id);
+        // Deferring them would only cost budget, and a stale id would share
+        // its index with the live node's record
+        std::erase_if(pending.changes, stale);
+        state.deferred.Fold(std::move(pending.changes));
+        pending.changes.clear();
+        if (!budgeted) {
+            pending.changes = state.deferred.TakeAll();
+            return pending.changes.size();
+        }
+        return state.deferred.records.size();
+    }
 
-                // Remove render node
-                Storage<T>().ClearNode(idx, m_nodeIdAllocator.GetGeneration(idx));
+    // Budgeted Sync: append this type's deferred records to the plan
+    template <typename T>
+    void DescribeChanges(SyncPlan& plan) {
+        TypeState<T>& state = *State<T>();
+        for (const auto& change : state.deferred.records) {
+            SyncPlanEntry entry;
+            entry.id = change.id;
+            entry.deleted = change.deleted;
+            entry.children = AppendedChildren(change);
+            if (state.storage.TryGetRenderNode(change.id)) {
+                entry.priority = kSyncPriorityLive;
+            } else if ((change.dirtyFields & kFieldVisible) && !change.visible) {
+                entry.priority = kSyncPriorityHidden;
+            }
+            plan.entries.push_back(entry);
+        }
+    }
+
+    // Budgeted Sync: move the records the plan selected into this Sync's
+    // changes (entries [first, first + deferred count) belong to this type).
+    // Returns the number of records still deferred.
+    template <typename T>
+    std::size_t TakeSelectedChanges(const SyncPlan& plan, std::size_t first) {
+        TypeState<T>& state = *State<T>();
+        DeferredRecords<T>& deferred = state.deferred;
+        // Back to front: Take() refills a slot from the back, which is already visited
+        for (std::size_t i = deferred.records.size(); i-- > 0;) {
+            if (plan.selected[first + i]) {
+                state.pending.changes.push_back(deferred.Take(i));
+            }
+        }
+        return deferred.records.size();
+    }
+
+    // Phase 1 (one task per type): apply writes, collect deletions.
+    // Only touches this type's buffer and storage; the allocator is read-only here.
+    template <typename T>
+    void ProcessChanges(TaskGroup& group) {
+        TRACE_SCOPE_DETAIL("RenderContext::ProcessChanges");
+        TypeState<T>& state = *State<T>();
+        PendingChanges<T>& pending = state.pending;
+        pending.deletions.clear();
+
+        // Size storage up front so chunks can flush without reallocating it
+        std::uint64_t maxIndex = 0;
+        for (const auto& change : pending.changes) {
+            maxIndex = std::max(maxIndex, ExtractIndex(change.id) + 1);
+            if (change.deleted && IsAlive(change.id)) {
+                pending.deletions.push_back(change.id);
+            }
+        }
+        state.storage.Reserve(maxIndex);
+
+        auto flushRange = [this, &pending](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                auto& change = pending.changes[i];
+                // Skip deletions and writes to handles whose deletion was already applied
+                if (change.deleted || !IsAlive(change.id)) {
+                    continue;
+                }
+                change.Flush(*this);
+            }
+        };
+
+        const std::size_t count = pending.changes.size();
+        for (std::size_t begin = kSyncChunkSize; begin < count; begin += kSyncChunkSize) {
+            const std::size_t end = std::min(count, begin + kSyncChunkSize);
+            group.Run("RenderContext::FlushChunk", [flushRange, begin, end]() { flushRange(begin, end); });
+        }
+        flushRange(0, std::min(count, kSyncChunkSize));
+    }
+
+    // Phase 2 (serial, before deletions): record what the applied changes do
+    // to bounds. Leaves get new own bounds, containers link appended children,
+    // and the containers affected are queued for UpdateBounds().
+    template <typename T>
+    void CollectBoundsChanges() {
+        PendingChanges<T>& pending = State<T>()->pending;
+        for (const auto& change : pending.changes) {
+            if (change.deleted || !change.render) {
                 continue;
             }
+            if constexpr (RenderNodeTraits<T>::kIsContainer) {
+                if (const auto* children = AppendedChildren(change)) {
+                    for (NodeId child : *children) {
+                        LinkChild(change.id, child);
+                    }
+                    MarkBoundsDirty(change.id);
+                }
+            } else {
+                StartAnimations(change);
+                SetLeafBounds(change.id, AnimatedLeafBounds(change.id, *change.render));
+            }
+        }
+        for (NodeId id : pending.deletions) {
+            UnlinkDeleted(id);
+        }
+    }
 
-            change.Flush(*this);
+    // Phase 3 (serial): release deleted ids and their render nodes
+    template <typename T>
+    void ApplyDeletions() {
+        TypeState<T>& state = *State<T>();
+        PendingChanges<T>& pending = state.pending;
+        for (NodeId id : pending.deletions) {
+            const std::uint64_t idx = ExtractIndex(id);
+            m_nodeIdAllocator.Free(id);
+            state.storage.ClearNode(idx, m_nodeIdAllocator.GetGeneration(idx));
         }
+        pending.deletions.clear();
+        pending.changes.clear();
     }
 
     // Register type handler for automatic processing in Sync()
-    // Uses static variable to ensure registration happens only once per type
+    // Creates the type's state on this instance; later calls are no-ops
     template <typename T>
     void RegisterTypeHandler() {
-        [[maybe_unused]] static bool registered = []() {
-            // Register handler - will be added to instance's handler list
-            // Note: Since this is called from instance method, Instance() is safe
-            RenderContext& instance = Instance();
-            instance.m_typeHandlers.push_back([](RenderContext* ctx) {
-                ctx->ProcessChanges<T>();
-            });
-            return true;
-        }();
+        const std::size_t typeId = ChangeTypeId<T>();
+        assert(typeId < kMaxNodeTypes && "raise RenderContext::kMaxNodeTypes");
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        if (m_types[typeId].load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_typeHandlers.push_back(TypeHandler{
+            [](RenderContext* ctx, ChangeBatchList& batches, bool budgeted) {
+                return ctx->MergeChanges<T>(batches, budgeted);
+            },
+            [](RenderContext* ctx, SyncPlan& plan) { ctx->DescribeChanges<T>(plan); },
+            [](RenderContext* ctx, const SyncPlan& plan, std::size_t first) {
+                return ctx->TakeSelectedChanges<T>(plan, first);
+            },
+            [](RenderContext* ctx, ChangeCapture& capture) { capture.Write(ctx->State<T>()->pending.changes); },
+            [](RenderContext* ctx, DisplayStreamServer& stream) { stream.Write(ctx->State<T>()->pending.changes); },
+            [](RenderContext* ctx, TaskGroup& group) { ctx->ProcessChanges<T>(group); },
+            [](RenderContext* ctx) { ctx->CollectBoundsChanges<T>(); },
+            [](RenderContext* ctx) { ctx->ApplyDeletions<T>(); }});
+        // Published last: readers that see the state also see its handler
+        m_types[typeId].store(new TypeState<T>(), std::memory_order_release);
     }
 
-    // Call all registered type handlers
-    void ProcessAllRegisteredTypes() {
-        for (auto& handler : m_typeHandlers) {
-            handler(this);
+    // Phase 2: direct writes stop the animations of what they wrote, then
+    // the record's new animations start (both already in the record's order).
+    // An interpolated node's new position is left to Flush's caller: where
+    // the node shows differs from the record, and it glides there over the
+    // last Sync interval, so it arrives about when the next snapshot does.
+    template <typename T>
+    void StartAnimations(const T& change) {
+        const auto* animations = SubmittedAnimations(change);
+        const bool moved = (change.dirtyFields & kFieldPosition) != 0;
+        const bool glideX = moved && change.render->x != change.x;
+        const bool glideY = moved && change.render->y != change.y;
+        if (!animations && !glideX && !glideY && m_animations.Empty()) {
+            return;
+        }
+        for (std::size_t property = 0; property < kAnimatedPropertyCount; ++property) {
+            const auto animated = static_cast<AnimatedProperty>(property);
+            if (change.dirtyFields & DirtyFieldOf(animated)) {
+                m_animations.Stop(change.id, animated);
+            }
+        }
+        if (glideX) {
+            m_animations.Start(*this, change.id, AnimationTargetOf<T>(),
+                               AnimationSpec::Tween(AnimatedProperty::X, kFromCurrent, change.x, m_syncInterval),
+                               m_syncTime);
+        }
+        if (glideY) {
+            m_animations.Start(*this, change.id, AnimationTargetOf<T>(),
+                               AnimationSpec::Tween(AnimatedProperty::Y, kFromCurrent, change.y, m_syncInterval),
+                               m_syncTime);
+        }
+        if (animations) {
+            for (const AnimationSpec& spec : *animations) {
+                m_animations.Start(*this, change.id, AnimationTargetOf<T>(), spec, m_syncTime);
+            }
         }
     }
 
+    // Own bounds of a leaf over every value its running animations reach
+    template <typename Node>
+    Bounds AnimatedLeafBounds(NodeId id, const Node& node) const {
+        std::array<float, kAnimatedPropertyCount> lowValues{};
+        std::array<float, kAnimatedPropertyCount> highValues{};
+        std::uint32_t animated = 0;  // bit per property
+        if (!m_animations.Empty()) {
+            for (std::size_t property = 0; property < kAnimatedPropertyCount; ++property) {
+                if (m_animations.Range(id, static_cast<AnimatedProperty>(property), lowValues[property],
+                                       highValues[property])) {
+                    animated |= 1u << property;
+                }
+            }
+        }
+        if (animated == 0) {
+            return LeafBounds(node);
+        }
+
+        // Positions at both ends of their range, sizes at their largest
+        Node low = node;
+        Node high = node;
+        for (std::size_t property = 0; property < kAnimatedPropertyCount; ++property) {
+            const auto animatedProperty = static_cast<AnimatedProperty>(property);
+            float* lowField = AnimatedField(low, animatedProperty);
+            float* highField = AnimatedField(high, animatedProperty);
+            if (!(animated & (1u << property)) || !lowField) {
+                continue;
+            }
+            *highField = std::max(highValues[property], *highField);
+            *lowField = IsExtent(animatedProperty) ? *highField : std::min(lowValues[property], *lowField);
+        }
+        Bounds bounds = LeafBounds(low);
+        bounds.Add(LeafBounds(high));
+        return bounds;
+    }
+
+    template <typename T>
+    static float* AnimatedFieldOf(RenderContext& ctx, NodeId id, AnimatedProperty property) {
+        auto* node = ctx.IsAlive(id) ? ctx.TryGetRenderNode<T>(id) : nullptr;
+        return node ? AnimatedField(*node, property) : nullptr;
+    }
+
+    template <typename T>
+    static void SettleAnimated(RenderContext& ctx, NodeId id) {
+        if (auto* node = ctx.IsAlive(id) ? ctx.TryGetRenderNode<T>(id) : nullptr) {
+            ctx.SetLeafBounds(id, ctx.AnimatedLeafBounds(id, *node));
+        }
+    }
+
+    template <typename T>
+    static const AnimationTarget& AnimationTargetOf() {
+        static constexpr AnimationTarget target{&AnimatedFieldOf<T>, &SettleAnimated<T>};
+        return target;
+    }
+
+    // Per node index: subtree bounds and the parent they feed into
+    struct NodeBounds {
+        NodeId id = 0;      // node the slot currently describes
+        NodeId parent = 0;  // container it was last appended to; 0 = none
+        Bounds bounds;
+        bool known = false;   // false until computed; unknown bounds are never culled
+        bool leaf = false;    // own bounds, listed in m_spatialIndex
+        bool queued = false;  // in m_boundsDirty
+    };
+
+    // Slot for `id`, reset if it still describes an older node at that index
+    NodeBounds& BoundsSlot(NodeId id);
+    void LinkChild(NodeId parent, NodeId child);
+    void SetLeafBounds(NodeId id, const Bounds& bounds);
+    void UnlinkDeleted(NodeId id);
+    void MarkBoundsDirty(NodeId container);
+
+    // Queue a leaf's move for the spatial index
+    void MoveLeaf(NodeId id, const Bounds& before, const Bounds& after);
+
+    // Phase 4 (serial): recompute queued containers from their children;
+    // containers whose bounds changed queue their parent for the next round.
+    // Then hands the leaf moves of this Sync to the spatial index.
+    void UpdateBounds();
+
+    // Call all registered type handlers: types in parallel, then deletions serially.
+    // With a budget, records that do not fit stay in each type's deferred records.
+    SyncResult ProcessAllRegisteredTypes(ChangeBatchList& batches, const SyncBudget& budget);
+
+    // Records a budgeted Sync may apply, from the measured cost per change
+    std::size_t ChangeLimit(const SyncBudget& budget) const;
+
+    // Mark plan entries to apply: deletions, then subtrees in priority order,
+    // each post-order so no record is selected before its pending children.
+    // Returns the number of selected entries.
+    static std::size_t SelectWithinBudget(SyncPlan& plan, std::size_t limit);
+
+    struct TypeHandler {
+        std::function<std::size_t(RenderContext*, ChangeBatchList&, bool)> merge;
+        std::function<void(RenderContext*, SyncPlan&)> describe;
+        std::function<std::size_t(RenderContext*, const SyncPlan&, std::size_t)> takeSelected;
+        std::function<void(RenderContext*, ChangeCapture&)> capture;
+        std::function<void(RenderContext*, DisplayStreamServer&)> stream;
+        std::function<void(RenderContext*, TaskGroup&)> process;
+        std::function<void(RenderContext*)> collectBounds;
+        std::function<void(RenderContext*)> applyDeletions;
+    };
+
     ChangeBuffer m_changeBuffer;
     NodeIdAllocator m_nodeIdAllocator;
     std::mutex m_renderMutex;
-    std::vector<std::function<void(RenderContext*)>> m_typeHandlers;
+    std::vector<TypeHandler> m_typeHandlers;
+    std::mutex m_handlersMutex;  // producers register types while Sync iterates
+    // Owned TypeStateBase per ChangeTypeId; set once, read lock-free
+    std::array<std::atomic<TypeStateBase*>, kMaxNodeTypes> m_types{};
+    std::chrono::microseconds m_simulatedSyncCost{0};
+    TrackedVector<NodeBounds, MemoryTag::RenderStorage> m_bounds;
+    std::vector<NodeId> m_boundsDirty;  // containers to recompute
+    std::vector<SpatialUpdate> m_leafMoves;  // this Sync's leaf bounds changes
+    SpatialIndex m_spatialIndex;
+    AnimationSystem m_animations;
+    std::chrono::steady_clock::time_point m_syncTime;  // animations started by this Sync start here
+    float m_syncInterval = 0.0f;  // seconds since the previous Sync, capped; interpolated nodes glide this long
+    std::atomic<std::size_t> m_deferredChanges{0};
+    double m_syncNsPerChange = 1000.0;  // apply cost, moving average; feeds ChangeLimit()
+    std::unique_ptr<ChangeCapture> m_capture;  // between StartCapture and StopCapture
+    std::unique_ptr<DisplayStreamServer> m_displayStream;  // between StartDisplayStream and StopDisplayStream
+    WaitHistogram m_syncLockWaits;
+    WaitHistogram m_renderLockWaits;
 };
 
 } // namespace ui
@@ -0,0 +1,125 @@
+#include "ReplayDriver.h"
+
+#include "MemoryStats.h"
+#include "RenderContext.h"
+#include "TraceProfiler.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace ui {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+
+void HashBytes(std::uint64_t& hash, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+}
+
+template <typename V>
+void HashValue(std::uint64_t& hash, const V& value) {
+    HashBytes(hash, &value, sizeof(value));
+}
+
+void HashCommands(std::uint64_t& hash, const RenderCommandList& commands) {
+    HashValue(hash, commands.size());
+    for (const RenderCommand& command : commands) {
+        HashValue(hash, command.type);
+        HashValue(hash, command.sortKey);
+        if (command.type == RenderCommand::Type::Text) {
+            HashValue(hash, command.textPayload.x);
+            HashValue(hash, command.textPayload.y);
+            HashBytes(hash, command.textPayload.text.data(), command.textPayload.text.size());
+        } else {
+            HashValue(hash, command.shapeRectPayload);
+        }
+    }
+}
+
+} // namespace
+
+std::string ReplayReport::Format() {
+    std::ostringstream out;
+    out << "replay: " << frames << " frames, " << records << " records in " << seconds << " s";
+    if (capturedSeconds > 0.0) {
+        out << " (captured over " << capturedSeconds << " s)";
+    }
+    out << "\n";
+    if (!complete) {
+        out << "  stopped at a malformed frame\n";
+    }
+    if (seconds > 0.0) {
+        out << "  throughput: " << static_cast<double>(frames) / seconds << " frames/s, "
+            << static_cast<double>(records) / seconds << " records/s\n";
+    }
+    out << "  last frame: " << lastCommandCount << " render commands, command hash " << std::hex << commandHash
+        << std::dec << "\n";
+    out << "  " << feed.Format("feed") << "\n";
+    out << "  " << sync.Format("sync") << "\n";
+    out << "  " << collect.Format("collect") << "\n";
+    return out.str();
+}
+
+ReplayDriver::ReplayDriver(const ChangeReplay& replay, RenderContext& ctx, const ReplayConfig& config)
+    : m_replay(replay)
+    , m_ctx(ctx)
+    , m_config(config) {}
+
+ReplayReport ReplayDriver::Run(const SubmitFn& submit) {
+    ReplayReport report;
+    report.capturedSeconds = std::chrono::duration<double>(m_replay.Duration()).count();
+    report.commandHash = kFnvOffset;
+    report.complete = true;
+
+    const Bounds viewport = m_config.viewportWidth > 0.0f && m_config.viewportHeight > 0.0f
+        ? Bounds::FromRect(0.0f, 0.0f, m_config.viewportWidth, m_config.viewportHeight)
+        : Bounds::Infinite();
+    const CollectMode mode = m_config.parallelCollect ? CollectMode::Parallel : CollectMode::Serial;
+
+    m_replay.Prepare(m_ctx);
+    RenderCommandList commands;
+    const auto runBegin = Clock::now();
+    for (std::size_t frame = 0; frame < m_replay.FrameCount(); ++frame) {
+        TRACE_SCOPE("Replay::Frame");
+        const auto feedBegin = Clock::now();
+        const bool fed = m_replay.Feed(m_ctx, frame);
+        const auto syncBegin = Clock::now();
+        // Whatever was fed is applied either way, so the context stays consistent
+        m_ctx.Sync();
+        const auto collectBegin = Clock::now();
+        report.feed.Add(syncBegin - feedBegin);
+        report.sync.Add(collectBegin - syncBegin);
+        if (!fed) {
+            report.complete = false;
+            break;
+        }
+
+        {
+            auto lock = m_ctx.LockForRender();
+            if (m_ctx.RunningAnimations() > 0) {
+                m_ctx.AdvanceAnimations(collectBegin);
+            }
+            CollectRenderCommands(m_ctx, m_replay.Root(), commands, mode, viewport);
+        }
+        report.collect.Add(Clock::now() - collectBegin);
+        HashCommands(report.commandHash, commands);
+        if (submit) {
+            submit(commands);
+        }
+        report.lastCommandCount = commands.size();
+        ++report.frames;
+        MemoryStats::Instance().EndFrame();
+    }
+    report.records = m_replay.RecordCount();
+    report.seconds = std::chrono::duration<double>(Clock::now() - runBegin).count();
+    return report;
+}
+
+} // namespace ui
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ChangeCapture.h"
+#include "FrameStats.h"
+#include "RenderCommands.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ui {
+
+struct ReplayConfig {
+    // Collect render commands with subtree jobs (CollectMode::Parallel)
+    bool parallelCollect = false;
+    // Cull against a viewport at the origin; 0 = no culling
+    float viewportWidth = 0.0f;
+    float viewportHeight = 0.0f;
+};
+
+struct ReplayReport {
+    std::size_t frames = 0;
+    std::uint64_t records = 0;
+    bool complete = false;        // false if a frame was malformed
+    double seconds = 0.0;
+    double capturedSeconds = 0.0; // span of the captured Syncs
+
+    FrameTimeStats feed;          // decode into the change buffer
+    FrameTimeStats sync;
+    FrameTimeStats collect;       // AdvanceAnimations + CollectRenderCommands
+    std::size_t lastCommandCount = 0;
+    // FNV-1a over every frame's render commands: equal across replays of
+    // one capture unless animations or interpolated nodes run (their
+    // values depend on the replay's own timing)
+    std::uint64_t commandHash = 0;
+
+    std::string Format();
+};
+
+// Replays a capture as fast as possible on the calling thread: per frame
+// Feed, Sync, then collect render commands from the captured root
+class ReplayDriver {
+public:
+    // Render thread: receives each collected command list
+    using SubmitFn = std::function<void(const RenderCommandList&)>;
+
+    // `ctx` as ChangeReplay::Prepare expects it
+    ReplayDriver(const ChangeReplay& replay, RenderContext& ctx, const ReplayConfig& config = {});
+
+    ReplayReport Run(const SubmitFn& submit = {});
+
+private:
+    const ChangeReplay& m_replay;
+    RenderContext& m_ctx;
+    ReplayConfig m_config;
+};
+
+} // namespace ui
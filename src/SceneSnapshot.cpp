@@ -0,0 +1,311 @@
+#include "SceneSnapshot.h"
+
+#include "MappedFile.h"
+#include "RenderContext.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace ui {
+
+namespace {
+
+std::uint64_t AlignUp(std::uint64_t offset) {
+    return (offset + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment;
+}
+
+template <typename Node>
+SnapshotNode CommonOf(NodeId id, const Node& node) {
+    SnapshotNode out{};
+    out.id = id;
+    out.x = node.x;
+    out.y = node.y;
+    out.layer = node.layer;
+    out.visible = node.visible ? 1 : 0;
+    return out;
+}
+
+template <typename Node>
+void ApplyCommon(Node& node, const SnapshotNode& in) {
+    node.x = in.x;
+    node.y = in.y;
+    node.layer = in.layer;
+    node.visible = in.visible != 0;
+}
+
+// Section contents, gathered under the render mutex and written after it
+struct SnapshotSections {
+    std::vector<std::uint16_t> generations;
+    std::vector<SnapshotContainer> containers;
+    std::vector<SnapshotText> texts;
+    std::vector<SnapshotNode> shapes;
+    std::vector<SnapshotRect> rects;
+    std::vector<NodeId> children;
+    std::vector<char> strings;
+
+    template <typename F>
+    void ForEach(F&& f) const {
+        f(kSnapshotGenerations, generations);
+        f(kSnapshotContainers, containers);
+        f(kSnapshotTexts, texts);
+        f(kSnapshotShapes, shapes);
+        f(kSnapshotRects, rects);
+        f(kSnapshotChildren, children);
+        f(kSnapshotStrings, strings);
+    }
+};
+
+// Records of one section inside a mapped file; null if out of bounds or misaligned
+template <typename Record>
+const Record* SectionOf(const MappedFile& file, const SnapshotSection& section) {
+    if (section.offset % kSnapshotAlignment != 0 || section.offset > file.Size() ||
+        section.count > (file.Size() - section.offset) / sizeof(Record)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const Record*>(file.Data() + section.offset);
+}
+
+// [first, first + count) lies within a section of `size` records
+bool RangeWithin(std::uint64_t first, std::uint64_t count, std::uint64_t size) {
+    return first <= size && count <= size - first;
+}
+
+} // namespace
+
+bool RenderContext::SaveSnapshot(const std::string& path, NodeId root) {
+    TRACE_SCOPE("RenderContext::SaveSnapshot");
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.root = root;
+
+    SnapshotSections sections;
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        header.indexLimit = m_nodeIdAllocator.IndexLimit();
+        sections.generations.resize(static_cast<std::size_t>(header.indexLimit));
+        for (std::uint64_t index = 0; index < header.indexLimit; ++index) {
+            sections.generations[static_cast<std::size_t>(index)] = m_nodeIdAllocator.GetGeneration(index);
+        }
+
+        if (auto* state = State<ContainerNodeData>()) {
+            state->storage.ForEachNode([&](NodeId id, const RenderContainerNode& node) {
+                SnapshotContainer record{};
+                record.node = CommonOf(id, node);
+                record.firstChild = sections.children.size();
+                for (NodeId child : node.children) {
+                    if (IsAlive(child)) {  // deleted children are pruned on the next children write
+                        sections.children.push_back(child);
+                    }
+                }
+                record.childCount = sections.children.size() - record.firstChild;
+                sections.containers.push_back(record);
+            });
+        }
+        if (auto* state = State<TextNodeData>()) {
+            state->storage.ForEachNode([&](NodeId id, const RenderTextNode& node) {
+                SnapshotText record{};
+                record.node = CommonOf(id, node);
+                record.node.interpolated = node.interpolated ? 1 : 0;
+                record.firstChar = sections.strings.size();
+                record.length = node.text.size();
+                sections.strings.insert(sections.strings.end(), node.text.begin(), node.text.end());
+                sections.texts.push_back(record);
+            });
+        }
+        if (auto* state = State<ShapeNodeData>()) {
+            state->storage.ForEachNode(
+                [&](NodeId id, const RenderShapeNode& node) { sections.shapes.push_back(CommonOf(id, node)); });
+        }
+        if (auto* state = State<ShapeRectNodeData>()) {
+            state->storage.ForEachNode([&](NodeId id, const RenderShapeRectNode& node) {
+                SnapshotRect record{};
+                record.node = CommonOf(id, node);
+                record.node.interpolated = node.interpolated ? 1 : 0;
+                record.width = node.width;
+                record.height = node.height;
+                sections.rects.push_back(record);
+            });
+        }
+    }
+
+    std::uint64_t offset = sizeof(SnapshotHeader);
+    sections.ForEach([&](SnapshotSectionId id, const auto& records) {
+        header.sections[id].offset = offset;
+        header.sections[id].count = records.size();
+        offset = AlignUp(offset + records.size() * sizeof(records[0]));
+    });
+    header.fileSize = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    sections.ForEach([&](SnapshotSectionId id, const auto& records) {
+        const std::uint64_t bytes = records.size() * sizeof(records[0]);
+        out.seekp(static_cast<std::streamoff>(header.sections[id].offset));
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(bytes));
+    });
+    // Pad the last section so the file is as long as the header says
+    const char padding[kSnapshotAlignment] = {};
+    out.write(padding, static_cast<std::streamsize>(header.fileSize - static_cast<std::uint64_t>(out.tellp())));
+    return static_cast<bool>(out);
+}
+
+bool RenderContext::LoadSnapshot(const std::string& path, NodeId& root) {
+    TRACE_SCOPE("RenderContext::LoadSnapshot");
+    MappedFile file;
+    if (!file.Open(path) || file.Size() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    SnapshotHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 || header.version != kSnapshotVersion ||
+        header.byteOrder != kSnapshotByteOrder || header.fileSize != file.Size() ||
+        header.indexLimit > NodeIdAllocator::kMaxIndex ||
+        header.sections[kSnapshotGenerations].count != header.indexLimit) {
+        return false;
+    }
+
+    const auto* generations = SectionOf<std::uint16_t>(file, header.sections[kSnapshotGenerations]);
+    const auto* containers = SectionOf<SnapshotContainer>(file, header.sections[kSnapshotContainers]);
+    const auto* texts = SectionOf<SnapshotText>(file, header.sections[kSnapshotTexts]);
+    const auto* shapes = SectionOf<SnapshotNode>(file, header.sections[kSnapshotShapes]);
+    const auto* rects = SectionOf<SnapshotRect>(file, header.sections[kSnapshotRects]);
+    const auto* children = SectionOf<NodeId>(file, header.sections[kSnapshotChildren]);
+    const auto* strings = SectionOf<char>(file, header.sections[kSnapshotStrings]);
+    if (!generations || !containers || !texts || !shapes || !rects || !children || !strings) {
+        return false;
+    }
+    const std::size_t containerCount = static_cast<std::size_t>(header.sections[kSnapshotContainers].count);
+    const std::size_t textCount = static_cast<std::size_t>(header.sections[kSnapshotTexts].count);
+    const std::size_t shapeCount = static_cast<std::size_t>(header.sections[kSnapshotShapes].count);
+    const std::size_t rectCount = static_cast<std::size_t>(header.sections[kSnapshotRects].count);
+    const std::uint64_t limit = header.indexLimit;
+
+    // Check every record before anything changes: each node a distinct,
+    // current handle, every range inside its section, every child id a
+    // current handle (the bounds table is sized by the ids it links)
+    std::vector<std::uint8_t> live(static_cast<std::size_t>(limit), 0);
+    auto current = [&](NodeId id) {
+        const std::uint64_t index = ExtractIndex(id);
+        return index != 0 && index < limit && generations[index] == ExtractGeneration(id);
+    };
+    auto claim = [&](const SnapshotNode& node) {
+        const std::uint64_t index = ExtractIndex(node.id);
+        if (!current(node.id) || live[index]) {
+            return false;
+        }
+        live[index] = 1;
+        return true;
+    };
+    for (std::size_t i = 0; i < containerCount; ++i) {
+        if (!claim(containers[i].node) || !RangeWithin(containers[i].firstChild, containers[i].childCount,
+                                                       header.sections[kSnapshotChildren].count)) {
+            return false;
+        }
+        const NodeId* first = children + containers[i].firstChild;
+        if (!std::all_of(first, first + containers[i].childCount, current)) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < textCount; ++i) {
+        if (!claim(texts[i].node) ||
+            !RangeWithin(texts[i].firstChar, texts[i].length, header.sections[kSnapshotStrings].count)) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < shapeCount; ++i) {
+        if (!claim(shapes[i])) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < rectCount; ++i) {
+        if (!claim(rects[i].node)) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    if (!m_nodeIdAllocator.Restore(generations, live.data(), limit)) {
+        return false;
+    }
+    RegisterTypeHandler<ContainerNodeData>();
+    RegisterTypeHandler<TextNodeData>();
+    RegisterTypeHandler<ShapeNodeData>();
+    RegisterTypeHandler<ShapeRectNodeData>();
+
+    // Render nodes: fixed-size fields copied, child lists and strings bulk-copied
+    {
+        TRACE_SCOPE_DETAIL("RenderContext::LoadSnapshotNodes");
+        auto& containerStorage = State<ContainerNodeData>()->storage;
+        auto& textStorage = State<TextNodeData>()->storage;
+        auto& shapeStorage = State<ShapeNodeData>()->storage;
+        auto& rectStorage = State<ShapeRectNodeData>()->storage;
+        containerStorage.Reserve(containerCount > 0 ? limit : 0);
+        textStorage.Reserve(textCount > 0 ? limit : 0);
+        shapeStorage.Reserve(shapeCount > 0 ? limit : 0);
+        rectStorage.Reserve(rectCount > 0 ? limit : 0);
+
+        for (std::size_t i = 0; i < containerCount; ++i) {
+            const SnapshotContainer& record = containers[i];
+            RenderContainerNode& node = *containerStorage.EnsureRenderNode(record.node.id);
+            ApplyCommon(node, record.node);
+            const NodeId* first = children + record.firstChild;
+            node.children.assign(first, first + record.childCount);
+        }
+        for (std::size_t i = 0; i < textCount; ++i) {
+            const SnapshotText& record = texts[i];
+            RenderTextNode& node = *textStorage.EnsureRenderNode(record.node.id);
+            ApplyCommon(node, record.node);
+            node.interpolated = record.node.interpolated != 0;
+            node.text.assign(strings + record.firstChar, static_cast<std::size_t>(record.length));
+        }
+        for (std::size_t i = 0; i < shapeCount; ++i) {
+            ApplyCommon(*shapeStorage.EnsureRenderNode(shapes[i].id), shapes[i]);
+        }
+        for (std::size_t i = 0; i < rectCount; ++i) {
+            const SnapshotRect& record = rects[i];
+            RenderShapeRectNode& node = *rectStorage.EnsureRenderNode(record.node.id);
+            ApplyCommon(node, record.node);
+            node.interpolated = record.node.interpolated != 0;
+            node.width = record.width;
+            node.height = record.height;
+        }
+    }
+
+    // Bounds and the spatial index, as the first Sync of this tree would
+    // compute them: leaves first, then containers bottom-up
+    {
+        TRACE_SCOPE_DETAIL("RenderContext::LoadSnapshotBounds");
+        m_bounds.resize(static_cast<std::size_t>(limit));
+        m_leafMoves.reserve(textCount + rectCount);
+        for (std::size_t i = 0; i < textCount; ++i) {
+            SetLeafBounds(texts[i].node.id, LeafBounds(*TryGetRenderNode<TextNodeData>(texts[i].node.id)));
+        }
+        for (std::size_t i = 0; i < rectCount; ++i) {
+            SetLeafBounds(rects[i].node.id, LeafBounds(*TryGetRenderNode<ShapeRectNodeData>(rects[i].node.id)));
+        }
+        for (std::size_t i = 0; i < containerCount; ++i) {
+            const SnapshotContainer& record = containers[i];
+            for (std::uint64_t child = 0; child < record.childCount; ++child) {
+                LinkChild(record.node.id, children[record.firstChild + child]);
+            }
+        }
+        // Trees are usually allocated top-down, so this mostly queues children first
+        for (std::size_t i = containerCount; i-- > 0;) {
+            if (containers[i].childCount > 0) {
+                MarkBoundsDirty(containers[i].node.id);
+            }
+        }
+        UpdateBounds();
+    }
+
+    root = header.root;
+    return true;
+}
+
+} // namespace ui
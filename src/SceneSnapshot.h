@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ui_ids.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ui {
+
+// ---------------------------------
+// Scene snapshot: binary image of one RenderContext's render tree
+// (RenderContext::SaveSnapshot / LoadSnapshot). The file is a header
+// followed by sections of fixed-size records, each 8-byte aligned and
+// addressed by its offset from the start of the file; nothing in it is a
+// pointer, so it is read straight from a read-only mapping. Child lists
+// and strings are ranges into shared Children / Strings sections.
+// Written and read in host byte order; version 1.
+// ---------------------------------
+
+enum SnapshotSectionId : std::uint32_t {
+    kSnapshotGenerations,  // std::uint16_t per allocator index
+    kSnapshotContainers,   // SnapshotContainer
+    kSnapshotTexts,        // SnapshotText
+    kSnapshotShapes,       // SnapshotNode
+    kSnapshotRects,        // SnapshotRect
+    kSnapshotChildren,     // NodeId
+    kSnapshotStrings,      // char
+    kSnapshotSectionCount
+};
+
+struct SnapshotSection {
+    std::uint64_t offset = 0;  // from the start of the file
+    std::uint64_t count = 0;   // records
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;    // kSnapshotByteOrder as the writer saw it
+    std::uint64_t fileSize;
+    std::uint64_t indexLimit;   // allocator indices [0, indexLimit) are in use or free
+    NodeId root;
+    SnapshotSection sections[kSnapshotSectionCount];
+};
+
+inline constexpr char kSnapshotMagic[8] = {'U', 'I', 'S', 'N', 'A', 'P', '\0', '\0'};
+inline constexpr std::uint32_t kSnapshotVersion = 1;
+inline constexpr std::uint32_t kSnapshotByteOrder = 0x01020304u;
+inline constexpr std::size_t kSnapshotAlignment = 8;
+
+// Fields every render node has
+struct SnapshotNode {
+    NodeId id;
+    float x;
+    float y;
+    std::int16_t layer;
+    std::uint8_t visible;
+    std::uint8_t interpolated;  // leaves only
+};
+
+struct SnapshotContainer {
+    SnapshotNode node;
+    std::uint64_t firstChild;  // into the Children section
+    std::uint64_t childCount;
+};
+
+struct SnapshotText {
+    SnapshotNode node;
+    std::uint64_t firstChar;  // into the Strings section
+    std::uint64_t length;
+};
+
+struct SnapshotRect {
+    SnapshotNode node;
+    float width;
+    float height;
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader> && sizeof(SnapshotHeader) % kSnapshotAlignment == 0);
+static_assert(std::is_trivially_copyable_v<SnapshotContainer> && sizeof(SnapshotContainer) % kSnapshotAlignment == 0);
+static_assert(std::is_trivially_copyable_v<SnapshotText> && sizeof(SnapshotText) % kSnapshotAlignment == 0);
+static_assert(std::is_trivially_copyable_v<SnapshotRect> && sizeof(SnapshotRect) % kSnapshotAlignment == 0);
+
+} // namespace ui
@@ -0,0 +1,101 @@
+#include "ScriptRuntime.h"
+
+#include "TraceProfiler.h"
+
+#include <utility>
+
+namespace ui {
+
+ScriptRuntime::~ScriptRuntime() {
+    // Every unfinished task is suspended in exactly one queue
+    for (auto handle : m_ready) {
+        handle.destroy();
+    }
+    for (auto handle : m_nextFrame) {
+        handle.destroy();
+    }
+    for (auto handle : m_afterSync) {
+        handle.destroy();
+    }
+    while (!m_timers.empty()) {
+        m_timers.top().handle.destroy();
+        m_timers.pop();
+    }
+}
+
+void ScriptRuntime::Spawn(ScriptTask task) {
+    if (ScriptTask::Handle handle = task.Release()) {
+        ++m_taskCount;
+        m_nextFrame.push_back(handle);
+    }
+}
+
+bool ScriptRuntime::BudgetExhausted() const {
+    // Outside RunFrame (e.g. in OnSync) there is no budget to spend
+    return !m_inFrame || Clock::now() >= m_frameDeadline;
+}
+
+void ScriptRuntime::AddTimer(Clock::time_point deadline, ScriptTask::Handle handle) {
+    m_timers.push(Timer{deadline, m_timerSequence++, handle});
+}
+
+void ScriptRuntime::Resume(ScriptTask::Handle handle) {
+    handle.resume();
+    if (!handle.done()) {
+        return;
+    }
+    if (handle.promise().exception && !m_exception) {
+        m_exception = handle.promise().exception;
+    }
+    handle.destroy();
+    --m_taskCount;
+}
+
+void ScriptRuntime::RunFrame(std::chrono::microseconds budget) {
+    TRACE_SCOPE_DETAIL("ScriptRuntime::RunFrame");
+    const Clock::time_point begin = Clock::now();
+    m_frameDeadline = budget.count() > 0 ? begin + budget : Clock::time_point::max();
+    m_inFrame = true;
+    ++m_frame;
+
+    // Leftovers of the previous frame run first, then tasks woken for this one
+    for (auto handle : m_nextFrame) {
+        m_ready.push_back(handle);
+    }
+    m_nextFrame.clear();
+    while (!m_timers.empty() && m_timers.top().deadline <= begin) {
+        m_ready.push_back(m_timers.top().handle);
+        m_timers.pop();
+    }
+
+    // At least one task runs per frame, so a tiny budget still makes progress
+    bool first = true;
+    while (!m_ready.empty() && (first || !BudgetExhausted())) {
+        first = false;
+        ScriptTask::Handle handle = m_ready.front();
+        m_ready.pop_front();
+        Resume(handle);
+    }
+    m_inFrame = false;
+    TRACE_COUNTER("scripts.carried_over", m_ready.size());
+
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void ScriptRuntime::OnSync() {
+    TRACE_SCOPE_DETAIL("ScriptRuntime::OnSync");
+    // Tasks that wait for the next Sync again go to the next one
+    std::vector<ScriptTask::Handle> waiting;
+    waiting.swap(m_afterSync);
+    for (auto handle : waiting) {
+        Resume(handle);
+    }
+
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+} // namespace ui
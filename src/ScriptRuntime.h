@@ -0,0 +1,194 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace ui {
+
+class ScriptRuntime;
+
+// ---------------------------------
+// ScriptTask: coroutine type for script work on the update thread
+// A task does nothing until it is handed to ScriptRuntime::Spawn(); from then
+// on the runtime owns it and destroys it when it finishes.
+//
+//     ScriptTask Blink(ScriptRuntime& scripts, FrontendNode& node) {
+//         for (;;) {
+//             node.SetVisible(false);
+//             co_await scripts.Delay(std::chrono::milliseconds(500));
+//             node.SetVisible(true);
+//             co_await scripts.Delay(std::chrono::milliseconds(500));
+//         }
+//     }
+// ---------------------------------
+
+class ScriptTask {
+public:
+    struct promise_type {
+        std::exception_ptr exception;
+
+        ScriptTask get_return_object() {
+            return ScriptTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    ScriptTask() = default;
+    ScriptTask(ScriptTask&& other) noexcept
+        : m_handle(other.m_handle) {
+        other.m_handle = nullptr;
+    }
+    ScriptTask& operator=(ScriptTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+    ~ScriptTask() { Reset(); }
+
+    ScriptTask(const ScriptTask&) = delete;
+    ScriptTask& operator=(const ScriptTask&) = delete;
+
+private:
+    friend class ScriptRuntime;
+
+    explicit ScriptTask(Handle handle)
+        : m_handle(handle) {}
+
+    Handle Release() {
+        Handle handle = m_handle;
+        m_handle = nullptr;
+        return handle;
+    }
+
+    void Reset() {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    Handle m_handle;
+};
+
+// ---------------------------------
+// ScriptRuntime: cooperative scheduler for ScriptTasks
+// Single-threaded: Spawn, RunFrame and OnSync are all called on the update
+// thread, and every task runs there. RunFrame resumes ready tasks until the
+// frame's budget is spent; whatever is still ready carries over to the next
+// frame ahead of newly woken tasks. Tasks give up the thread only at
+// co_await, so long work must co_await Yield() between slices.
+// ---------------------------------
+
+class ScriptRuntime {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ScriptRuntime() = default;
+    ~ScriptRuntime();
+
+    ScriptRuntime(const ScriptRuntime&) = delete;
+    ScriptRuntime& operator=(const ScriptRuntime&) = delete;
+
+    // Queue a task; it first runs in the next RunFrame
+    void Spawn(ScriptTask task);
+
+    // Update thread, before Sync: run ready tasks for at most `budget`
+    // (zero = until none is ready). Rethrows the first exception a task let
+    // escape; that task is destroyed, the others are kept.
+    void RunFrame(std::chrono::microseconds budget);
+
+    // Update thread, right after Sync: resume tasks waiting in AfterSync()
+    void OnSync();
+
+    // Tasks not finished yet
+    std::size_t TaskCount() const { return m_taskCount; }
+    std::uint64_t Frame() const { return m_frame; }
+
+    // --- awaitables (co_await from a task of this runtime) ---
+
+    // Continue in the next frame's RunFrame
+    struct NextFrameAwaiter {
+        ScriptRuntime& runtime;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(ScriptTask::Handle handle) { runtime.m_nextFrame.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    // Continue right after the next Sync, once this frame's writes are applied
+    struct AfterSyncAwaiter {
+        ScriptRuntime& runtime;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(ScriptTask::Handle handle) { runtime.m_afterSync.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    // Continue in the first RunFrame at or after `deadline`
+    struct DelayAwaiter {
+        ScriptRuntime& runtime;
+        Clock::time_point deadline;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(ScriptTask::Handle handle) { runtime.AddTimer(deadline, handle); }
+        void await_resume() const noexcept {}
+    };
+
+    // Budget check point: continues at once while the frame budget lasts,
+    // otherwise (or when not inside RunFrame) in the next frame
+    struct YieldAwaiter {
+        ScriptRuntime& runtime;
+        bool await_ready() const noexcept { return !runtime.BudgetExhausted(); }
+        void await_suspend(ScriptTask::Handle handle) { runtime.m_ready.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    NextFrameAwaiter NextFrame() { return NextFrameAwaiter{*this}; }
+    AfterSyncAwaiter AfterSync() { return AfterSyncAwaiter{*this}; }
+    DelayAwaiter Delay(std::chrono::microseconds delay) { return DelayAwaiter{*this, Clock::now() + delay}; }
+    YieldAwaiter Yield() { return YieldAwaiter{*this}; }
+
+    // True once the running frame has used its budget, and outside RunFrame
+    bool BudgetExhausted() const;
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        std::uint64_t sequence = 0;  // FIFO among equal deadlines
+        ScriptTask::Handle handle;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    void AddTimer(Clock::time_point deadline, ScriptTask::Handle handle);
+
+    // Resume one task; destroys it if it finished
+    void Resume(ScriptTask::Handle handle);
+
+    std::deque<ScriptTask::Handle> m_ready;
+    std::vector<ScriptTask::Handle> m_nextFrame;
+    std::vector<ScriptTask::Handle> m_afterSync;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    std::uint64_t m_timerSequence = 0;
+
+    std::size_t m_taskCount = 0;
+    std::uint64_t m_frame = 0;
+    bool m_inFrame = false;
+    Clock::time_point m_frameDeadline{};  // max() when the frame is unbudgeted
+    std::exception_ptr m_exception;  // first escaped exception of the running frame
+};
+
+} // namespace ui
@@ -0,0 +1,387 @@
+#include "SharedRenderTree.h"
+
+#include "RenderContext.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ui {
+
+namespace {
+
+constexpr std::size_t kNodesAlign = 64;
+constexpr int kAcquireAttempts = 16;
+
+std::size_t AlignUp(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Whether `count` items of `itemBytes` starting at `offset` fit a slot of `slotBytes`
+bool FitsSlot(std::uint64_t offset, std::uint64_t count, std::size_t itemBytes, std::size_t slotBytes) {
+    return offset <= slotBytes && count <= (slotBytes - offset) / itemBytes;
+}
+
+std::string RegionName(const std::string& name) {
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+// Totals of a render tree, to lay out a frame before writing it
+struct FrameExtent {
+    std::size_t nodeCount = 0;  // highest index + 1
+    std::size_t childCount = 0;
+    std::size_t charCount = 0;
+};
+
+void Extend(FrameExtent& extent, NodeId id) {
+    extent.nodeCount = std::max<std::size_t>(extent.nodeCount, ExtractIndex(id) + 1);
+}
+
+// Common fields of every render node type
+template <typename Node>
+SharedNode& Place(RenderContext& ctx, SharedNode* nodes, NodeId id, const Node& node, SharedNodeKind kind) {
+    SharedNode& out = nodes[ExtractIndex(id)];
+    out.id = id;
+    out.kind = kind;
+    out.x = node.x;
+    out.y = node.y;
+    out.visible = node.visible ? 1 : 0;
+    out.layer = node.layer;
+    out.boundsKnown = ctx.TryGetSubtreeBounds(id, out.bounds) ? 1 : 0;
+    return out;
+}
+
+} // namespace
+
+// ---------------------------------
+// SharedTreeView
+// ---------------------------------
+
+SharedTreeView::SharedTreeView(const unsigned char* slot, std::size_t slotBytes) {
+    if (!slot || slotBytes < sizeof(SharedFrame)) {
+        return;
+    }
+    const auto* frame = reinterpret_cast<const SharedFrame*>(slot);
+    if (frame->nodesOffset % alignof(SharedNode) != 0 || frame->childrenOffset % alignof(NodeId) != 0 ||
+        !FitsSlot(frame->nodesOffset, frame->nodeCount, sizeof(SharedNode), slotBytes) ||
+        !FitsSlot(frame->childrenOffset, frame->childCount, sizeof(NodeId), slotBytes) ||
+        !FitsSlot(frame->charsOffset, frame->charCount, 1, slotBytes)) {
+        return;
+    }
+    m_frame = frame;
+    m_nodes = reinterpret_cast<const SharedNode*>(slot + frame->nodesOffset);
+    m_children = reinterpret_cast<const NodeId*>(slot + frame->childrenOffset);
+    m_chars = reinterpret_cast<const char*>(slot + frame->charsOffset);
+}
+
+const SharedNode* SharedTreeView::Find(NodeId id, SharedNodeKind kind) const {
+    const std::size_t index = ExtractIndex(id);
+    if (id == 0 || index >= m_frame->nodeCount) {
+        return nullptr;
+    }
+    const SharedNode& node = m_nodes[index];
+    return node.id == id && node.kind == kind ? &node : nullptr;
+}
+
+bool SharedTreeView::TryGetSubtreeBounds(NodeId id, Bounds& out) const {
+    const std::size_t index = ExtractIndex(id);
+    if (id == 0 || index >= m_frame->nodeCount || m_nodes[index].id != id || !m_nodes[index].boundsKnown) {
+        return false;
+    }
+    out = m_nodes[index].bounds;
+    return true;
+}
+
+std::span<const NodeId> SharedTreeView::Children(const SharedNode& container) const {
+    if (container.first > m_frame->childCount || container.count > m_frame->childCount - container.first) {
+        return {};
+    }
+    return {m_children + container.first, container.count};
+}
+
+std::string_view SharedTreeView::TextOf(const SharedNode& text) const {
+    if (text.first > m_frame->charCount || text.count > m_frame->charCount - text.first) {
+        return {};
+    }
+    return {m_chars + text.first, text.count};
+}
+
+// ---------------------------------
+// SharedTreePublisher
+// ---------------------------------
+
+SharedTreePublisher::~SharedTreePublisher() {
+    Destroy();
+}
+
+bool SharedTreePublisher::Publish(RenderContext& ctx, NodeId root) {
+    TRACE_SCOPE_DETAIL("SharedTree::Publish");
+    if (!m_region) {
+        return false;
+    }
+    auto* header = reinterpret_cast<SharedTreeHeader*>(m_region);
+
+    // A slot that is neither the latest frame nor held by a reader. A reader
+    // counts itself before re-checking `latest`, so once this sees zero no
+    // reader can claim the slot: they find `latest` moved on and retry.
+    const std::uint64_t latest = header->latest.load();
+    const std::size_t latestSlot = latest != 0 ? static_cast<std::size_t>(latest & 0xFF) : kSharedSlotCount;
+    std::size_t slot = kSharedSlotCount;
+    for (std::size_t i = 0; i < kSharedSlotCount; ++i) {
+        if (i != latestSlot && header->readers[i].load() == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == kSharedSlotCount) {
+        return false;
+    }
+
+    FrameExtent extent;
+    ctx.ForEachRenderNode<ContainerNodeData>([&](NodeId id, const RenderContainerNode& node) {
+        Extend(extent, id);
+        extent.childCount += node.children.size();
+    });
+    ctx.ForEachRenderNode<TextNodeData>([&](NodeId id, const RenderTextNode& node) {
+        Extend(extent, id);
+        extent.charCount += node.text.size();
+    });
+    ctx.ForEachRenderNode<ShapeNodeData>([&](NodeId id, const RenderShapeNode&) { Extend(extent, id); });
+    ctx.ForEachRenderNode<ShapeRectNodeData>([&](NodeId id, const RenderShapeRectNode&) { Extend(extent, id); });
+
+    const std::size_t slotBytes = header->slotBytes;
+    const std::size_t nodesOffset = AlignUp(sizeof(SharedFrame), kNodesAlign);
+    if (!FitsSlot(nodesOffset, extent.nodeCount, sizeof(SharedNode), slotBytes)) {
+        return false;
+    }
+    const std::size_t childrenOffset = AlignUp(nodesOffset + extent.nodeCount * sizeof(SharedNode), alignof(NodeId));
+    if (!FitsSlot(childrenOffset, extent.childCount, sizeof(NodeId), slotBytes)) {
+        return false;
+    }
+    const std::size_t charsOffset = childrenOffset + extent.childCount * sizeof(NodeId);
+    if (!FitsSlot(charsOffset, extent.charCount, 1, slotBytes) ||
+        extent.childCount > std::numeric_limits<std::uint32_t>::max() ||
+        extent.charCount > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+
+    unsigned char* base = m_region + header->slotsOffset + slot * slotBytes;
+    auto* nodes = reinterpret_cast<SharedNode*>(base + nodesOffset);
+    auto* children = reinterpret_cast<NodeId*>(base + childrenOffset);
+    auto* chars = reinterpret_cast<char*>(base + charsOffset);
+    std::memset(static_cast<void*>(nodes), 0, extent.nodeCount * sizeof(SharedNode));
+
+    std::uint32_t childCount = 0;
+    ctx.ForEachRenderNode<ContainerNodeData>([&](NodeId id, const RenderContainerNode& node) {
+        SharedNode& out = Place(ctx, nodes, id, node, SharedNodeKind::Container);
+        out.first = childCount;
+        out.count = static_cast<std::uint32_t>(node.children.size());
+        std::copy(node.children.begin(), node.children.end(), children + childCount);
+        childCount += out.count;
+    });
+    std::uint32_t charCount = 0;
+    ctx.ForEachRenderNode<TextNodeData>([&](NodeId id, const RenderTextNode& node) {
+        SharedNode& out = Place(ctx, nodes, id, node, SharedNodeKind::Text);
+        out.first = charCount;
+        out.count = static_cast<std::uint32_t>(node.text.size());
+        std::memcpy(chars + charCount, node.text.data(), node.text.size());
+        charCount += out.count;
+    });
+    ctx.ForEachRenderNode<ShapeNodeData>([&](NodeId id, const RenderShapeNode& node) {
+        Place(ctx, nodes, id, node, SharedNodeKind::Shape);
+    });
+    ctx.ForEachRenderNode<ShapeRectNodeData>([&](NodeId id, const RenderShapeRectNode& node) {
+        SharedNode& out = Place(ctx, nodes, id, node, SharedNodeKind::Rect);
+        out.width = node.width;
+        out.height = node.height;
+    });
+
+    auto* frame = reinterpret_cast<SharedFrame*>(base);
+    frame->sequence = ++m_sequence;
+    frame->publishNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    frame->root = root;
+    frame->nodeCount = extent.nodeCount;
+    frame->childCount = extent.childCount;
+    frame->charCount = extent.charCount;
+    frame->nodesOffset = nodesOffset;
+    frame->childrenOffset = childrenOffset;
+    frame->charsOffset = charsOffset;
+
+    header->latest.store(m_sequence << 8 | slot);
+    return true;
+}
+
+// ---------------------------------
+// SharedTreeReader
+// ---------------------------------
+
+SharedTreeReader::~SharedTreeReader() {
+    Close();
+}
+
+bool SharedTreeReader::Closed() const {
+    return m_header && m_header->closed.load() != 0;
+}
+
+bool SharedTreeReader::Acquire(std::uint64_t after, SharedTreeView& view) {
+    Release();
+    if (!m_header) {
+        return false;
+    }
+    for (int attempt = 0; attempt < kAcquireAttempts; ++attempt) {
+        const std::uint64_t latest = m_header->latest.load();
+        const std::size_t slot = static_cast<std::size_t>(latest & 0xFF);
+        if (latest == 0 || (latest >> 8) <= after || slot >= kSharedSlotCount) {
+            return false;
+        }
+        // Count ourselves in, then make sure the writer did not move on
+        // (and possibly start reusing the slot) before it could see us
+        m_header->readers[slot].fetch_add(1);
+        if (m_header->latest.load() != latest) {
+            m_header->readers[slot].fetch_sub(1);
+            continue;
+        }
+        m_claimed = static_cast<int>(slot);
+        view = SharedTreeView(m_slots + slot * m_slotBytes, m_slotBytes);
+        if (!view.Valid() || view.Sequence() != (latest >> 8)) {
+            Release();
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+void SharedTreeReader::Release() {
+    if (m_claimed >= 0) {
+        m_header->readers[m_claimed].fetch_sub(1);
+        m_claimed = -1;
+    }
+}
+
+#ifdef _WIN32
+
+// POSIX shared memory only; a Win32 file mapping would slot in here
+bool SharedTreePublisher::Create(const std::string&, std::size_t) {
+    return false;
+}
+
+void SharedTreePublisher::Destroy() {}
+
+bool SharedTreeReader::Open(const std::string&) {
+    return false;
+}
+
+void SharedTreeReader::Close() {}
+
+#else
+
+bool SharedTreePublisher::Create(const std::string& name, std::size_t slotBytes) {
+    Destroy();
+    m_name = RegionName(name);
+    slotBytes = AlignUp(std::max(slotBytes, AlignUp(sizeof(SharedFrame), kNodesAlign)), kSharedHeaderBytes);
+    const std::size_t regionBytes = kSharedHeaderBytes + kSharedSlotCount * slotBytes;
+
+    // A region left behind by a publisher that crashed
+    ::shm_unlink(m_name.c_str());
+    const int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    void* region = ::ftruncate(fd, static_cast<off_t>(regionBytes)) == 0
+        ? ::mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    ::close(fd);
+    if (region == MAP_FAILED) {
+        ::shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    m_region = static_cast<unsigned char*>(region);
+    m_regionBytes = regionBytes;
+    m_sequence = 0;
+    auto* header = new (m_region) SharedTreeHeader{};
+    header->version = kSharedTreeVersion;
+    header->slotCount = static_cast<std::uint32_t>(kSharedSlotCount);
+    header->slotBytes = slotBytes;
+    header->slotsOffset = kSharedHeaderBytes;
+    // Readers check the magic last, so they never see a half-written header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, kSharedTreeMagic, sizeof(header->magic));
+    return true;
+}
+
+void SharedTreePublisher::Destroy() {
+    if (m_region) {
+        reinterpret_cast<SharedTreeHeader*>(m_region)->closed.store(1);
+        ::munmap(m_region, m_regionBytes);
+        ::shm_unlink(m_name.c_str());
+    }
+    m_region = nullptr;
+    m_regionBytes = 0;
+}
+
+bool SharedTreeReader::Open(const std::string& name) {
+    Close();
+    const int fd = ::shm_open(RegionName(name).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* header = ::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= kSharedHeaderBytes
+        ? ::mmap(nullptr, kSharedHeaderBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    if (header == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    auto* shared = static_cast<SharedTreeHeader*>(header);
+    const auto regionBytes = static_cast<std::size_t>(info.st_size);
+    const bool magic = std::memcmp(shared->magic, kSharedTreeMagic, sizeof(shared->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!magic || shared->version != kSharedTreeVersion || shared->slotCount != kSharedSlotCount || shared->slotsOffset != kSharedHeaderBytes ||
+        shared->slotBytes == 0 || shared->slotBytes > (regionBytes - kSharedHeaderBytes) / kSharedSlotCount) {
+        ::munmap(header, kSharedHeaderBytes);
+        ::close(fd);
+        return false;
+    }
+
+    const std::size_t slotsBytes = kSharedSlotCount * shared->slotBytes;
+    void* slots = ::mmap(nullptr, slotsBytes, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(kSharedHeaderBytes));
+    ::close(fd);  // the mappings keep the region open
+    if (slots == MAP_FAILED) {
+        ::munmap(header, kSharedHeaderBytes);
+        return false;
+    }
+    m_header = shared;
+    m_slots = static_cast<const unsigned char*>(slots);
+    m_slotBytes = shared->slotBytes;
+    return true;
+}
+
+void SharedTreeReader::Close() {
+    if (m_header) {
+        Release();
+        ::munmap(const_cast<unsigned char*>(m_slots), kSharedSlotCount * m_slotBytes);
+        ::munmap(m_header, kSharedHeaderBytes);
+    }
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_slotBytes = 0;
+}
+
+#endif
+
+} // namespace ui
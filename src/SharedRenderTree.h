@@ -0,0 +1,184 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "Bounds.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ui {
+
+class RenderContext;
+
+// ---------------------------------
+// Shared render tree: the render tree of one process, published frame by
+// frame into a POSIX shared-memory region that a compositor process
+// (ui_compositor) maps read-only and collects render commands from in
+// place (see CollectRenderCommands(const SharedTreeView&, ...)).
+//
+// The region is a SharedTreeHeader and kSharedSlotCount frame slots. A
+// slot holds one SharedFrame: a node table indexed by handle index, then
+// the child ids and characters the nodes refer to by offset range, so a
+// frame reads the same at any mapping address. The writer fills a slot no
+// reader holds and publishes it by storing its sequence and slot in
+// `latest`; readers claim the newest slot by counting themselves in
+// `readers` first. With three slots the writer always finds a free one,
+// even if a compositor dies holding a frame.
+// ---------------------------------
+
+inline constexpr std::size_t kSharedSlotCount = 3;
+// The header has a page of its own, so readers can map the slots read-only
+inline constexpr std::size_t kSharedHeaderBytes = 4096;
+
+enum class SharedNodeKind : std::uint8_t {
+    None,  // no node at this index
+    Container,
+    Text,
+    Shape,
+    Rect,
+};
+
+struct SharedNode {
+    NodeId id;  // 0 = none
+    float x;
+    float y;
+    float width;   // rects
+    float height;  // rects
+    Bounds bounds;         // subtree bounds, valid if boundsKnown
+    std::uint32_t first;   // containers: into the child ids; texts: into the characters
+    std::uint32_t count;
+    std::int16_t layer;
+    SharedNodeKind kind;
+    std::uint8_t visible;
+    std::uint8_t boundsKnown;
+};
+
+struct SharedFrame {
+    std::uint64_t sequence;   // publish order, from 1
+    std::int64_t publishNs;   // steady_clock at publish (CLOCK_MONOTONIC, comparable across processes)
+    NodeId root;
+    std::uint64_t nodeCount;  // node table entries (handle indices)
+    std::uint64_t childCount;
+    std::uint64_t charCount;
+    // From the start of the slot
+    std::uint64_t nodesOffset;
+    std::uint64_t childrenOffset;
+    std::uint64_t charsOffset;
+};
+
+struct SharedTreeHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slotCount;
+    std::uint64_t slotBytes;
+    std::uint64_t slotsOffset;               // kSharedHeaderBytes; slot i starts at slotsOffset + i * slotBytes
+    std::atomic<std::uint64_t> latest;       // sequence << 8 | slot; 0 = nothing published yet
+    std::atomic<std::uint32_t> closed;       // 1 once the writer is gone
+    std::atomic<std::uint32_t> readers[kSharedSlotCount];
+};
+
+inline constexpr char kSharedTreeMagic[8] = {'U', 'I', 'S', 'H', 'T', 'R', 'E', 'E'};
+inline constexpr std::uint32_t kSharedTreeVersion = 1;
+
+static_assert(std::is_trivially_copyable_v<SharedNode> && std::is_trivially_copyable_v<SharedFrame>);
+static_assert(sizeof(SharedTreeHeader) <= kSharedHeaderBytes);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free to work across processes");
+
+// One frame of a shared tree, as the compositor reads it. Lookups check
+// the id (generation included) and kind like RenderContext::TryGetRenderNode,
+// and ranges are clamped to the frame, so a bad frame cannot make the
+// reader fault.
+class SharedTreeView {
+public:
+    SharedTreeView() = default;
+    SharedTreeView(const unsigned char* slot, std::size_t slotBytes);
+
+    // False if the frame's offsets and counts do not fit its slot
+    bool Valid() const { return m_frame != nullptr; }
+    std::uint64_t Sequence() const { return m_frame->sequence; }
+    std::int64_t PublishNs() const { return m_frame->publishNs; }
+    NodeId Root() const { return m_frame->root; }
+
+    const SharedNode* Container(NodeId id) const { return Find(id, SharedNodeKind::Container); }
+    const SharedNode* Text(NodeId id) const { return Find(id, SharedNodeKind::Text); }
+    const SharedNode* Rect(NodeId id) const { return Find(id, SharedNodeKind::Rect); }
+    bool TryGetSubtreeBounds(NodeId id, Bounds& out) const;
+
+    std::span<const NodeId> Children(const SharedNode& container) const;
+    std::string_view TextOf(const SharedNode& text) const;
+
+private:
+    const SharedNode* Find(NodeId id, SharedNodeKind kind) const;
+
+    const SharedFrame* m_frame = nullptr;
+    const SharedNode* m_nodes = nullptr;
+    const NodeId* m_children = nullptr;
+    const char* m_chars = nullptr;
+};
+
+// Update process: owns the region (created on Create, unlinked on destruction)
+class SharedTreePublisher {
+public:
+    SharedTreePublisher() = default;
+    ~SharedTreePublisher();
+
+    SharedTreePublisher(const SharedTreePublisher&) = delete;
+    SharedTreePublisher& operator=(const SharedTreePublisher&) = delete;
+
+    // Create region `name` (a shm_open name; '/' is prepended if missing)
+    // with frame slots of `slotBytes`, replacing a stale one of that name.
+    // False where POSIX shared memory is unavailable.
+    bool Create(const std::string& name, std::size_t slotBytes);
+
+    // Render thread, under the render mutex: copy ctx's render tree and
+    // `root` into a free slot and publish it. False (frame dropped) if the
+    // tree does not fit a slot.
+    bool Publish(RenderContext& ctx, NodeId root);
+
+    std::uint64_t PublishedFrames() const { return m_sequence; }
+
+private:
+    void Destroy();
+
+    std::string m_name;
+    unsigned char* m_region = nullptr;
+    std::size_t m_regionBytes = 0;
+    std::uint64_t m_sequence = 0;
+};
+
+// Compositor process: read-only mapping of a publisher's region
+class SharedTreeReader {
+public:
+    SharedTreeReader() = default;
+    ~SharedTreeReader();
+
+    SharedTreeReader(const SharedTreeReader&) = delete;
+    SharedTreeReader& operator=(const SharedTreeReader&) = delete;
+
+    // False if no valid region of that name exists (yet)
+    bool Open(const std::string& name);
+
+    // The writer has shut down; frames published before stay readable
+    bool Closed() const;
+
+    // Claim the newest frame if its sequence is above `after`; the view
+    // stays valid until Release(). False if there is none (or it is invalid).
+    bool Acquire(std::uint64_t after, SharedTreeView& view);
+    void Release();
+
+private:
+    void Close();
+
+    SharedTreeHeader* m_header = nullptr;  // read-write: reader counts
+    const unsigned char* m_slots = nullptr;  // read-only
+    std::size_t m_slotBytes = 0;
+    int m_claimed = -1;  // slot held between Acquire and Release
+};
+
+} // namespace ui
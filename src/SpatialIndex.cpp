@@ -0,0 +1,310 @@
+#include "SpatialIndex.h"
+
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+namespace ui {
+
+namespace {
+
+// Cell coordinates are clamped so unbounded areas stay countable
+constexpr std::int32_t kMaxCellCoord = 1 << 20;
+
+bool Contains(const Bounds& bounds, float x, float y) {
+    return bounds.minX <= x && x <= bounds.maxX && bounds.minY <= y && y <= bounds.maxY;
+}
+
+} // namespace
+
+SpatialIndex::SpatialIndex(float cellSize) {
+    for (std::size_t level = 0; level < kLevelCount; ++level) {
+        m_cellSizes[level] = std::ldexp(cellSize, static_cast<int>(level));
+        m_inverseCellSizes[level] = 1.0f / m_cellSizes[level];
+    }
+    for (Grid& grid : m_grids) {
+        Rehash(grid, static_cast<std::uint32_t>(std::countr_zero(kInitialBuckets)));
+    }
+}
+
+std::int32_t SpatialIndex::CellCoord(float value, std::size_t level) const {
+    const float cell = std::floor(value * m_inverseCellSizes[level]);
+    if (!(cell > -kMaxCellCoord)) {  // also NaN
+        return -kMaxCellCoord;
+    }
+    if (cell > kMaxCellCoord) {
+        return kMaxCellCoord;
+    }
+    return static_cast<std::int32_t>(cell);
+}
+
+std::size_t SpatialIndex::LevelOf(const Bounds& bounds) const {
+    const float extent = std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY);
+    std::size_t level = 0;
+    while (level < kLevelCount && !(extent <= m_cellSizes[level])) {
+        ++level;
+    }
+    return level;
+}
+
+std::size_t SpatialIndex::BucketOf(const Grid& grid, std::size_t level, std::int32_t cellX, std::int32_t cellY) {
+    std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32) | static_cast<std::uint32_t>(cellY);
+    key ^= static_cast<std::uint64_t>(level) * 0xD6E8FEB86659FD93ull;
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - grid.bucketBits));
+}
+
+void SpatialIndex::WaitForReaders() {
+    // Flip the version so new queries register on the other count, then
+    // drain the old one; the other count is drained first in case queries
+    // from before the previous flip are still on it
+    const std::uint32_t version = m_version.load();
+    while (m_readers[1 - version].count.load() != 0) {
+        std::this_thread::yield();
+    }
+    m_version.store(1 - version);
+    while (m_readers[version].count.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void SpatialIndex::Apply(const std::vector<SpatialUpdate>& updates) {
+    if (updates.empty()) {
+        return;
+    }
+    TRACE_SCOPE_DETAIL("SpatialIndex::Apply");
+    const std::uint32_t published = m_published.load();
+    Grid& updated = m_grids[1 - published];
+    ApplyTo(updated, updates);
+    m_published.store(1 - published);
+    WaitForReaders();
+    // Bulk changes (a scene being built or loaded): copying the arrays is
+    // cheaper than repeating scattered inserts
+    if (updates.size() * kCopyRatio >= updated.size) {
+        m_grids[published] = updated;
+    } else {
+        ApplyTo(m_grids[published], updates);
+    }
+}
+
+void SpatialIndex::ApplyTo(Grid& grid, const std::vector<SpatialUpdate>& updates) {
+    // Size the arrays and the table for the whole batch up front
+    std::size_t indexEnd = 0;
+    std::size_t inserts = 0;
+    for (const SpatialUpdate& update : updates) {
+        indexEnd = std::max(indexEnd, static_cast<std::size_t>(ExtractIndex(update.id)) + 1);
+        inserts += update.before.IsEmpty() && !update.after.IsEmpty() ? 1 : 0;
+    }
+    if (indexEnd > grid.entries.size()) {
+        grid.entries.resize(indexEnd);
+        grid.ids.resize(indexEnd, 0);
+        grid.prev.resize(indexEnd, kNone);
+    }
+    std::uint32_t bucketBits = grid.bucketBits;
+    while ((grid.size + inserts) * kBucketsPerNode > (std::size_t{1} << bucketBits)) {
+        ++bucketBits;
+    }
+    if (bucketBits != grid.bucketBits) {
+        Rehash(grid, bucketBits);
+    }
+
+    for (const SpatialUpdate& update : updates) {
+        if (!update.before.IsEmpty() && !update.after.IsEmpty() && MoveInPlace(grid, update.id, update.after)) {
+            continue;
+        }
+        if (!update.before.IsEmpty()) {
+            Remove(grid, update.id);
+        }
+        if (!update.after.IsEmpty()) {
+            Insert(grid, update.id, update.after);
+        }
+    }
+}
+
+std::uint32_t& SpatialIndex::HeadOf(Grid& grid, const Entry& entry) {
+    if (entry.level == kLevelCount) {
+        return grid.oversized;
+    }
+    return grid.heads[BucketOf(grid, entry.level, entry.cellX, entry.cellY)];
+}
+
+void SpatialIndex::Link(Grid& grid, std::uint32_t index) {
+    Entry& entry = grid.entries[index];
+    std::uint32_t& head = HeadOf(grid, entry);
+    grid.prev[index] = kNone;
+    entry.next = head;
+    if (head != kNone) {
+        grid.prev[head] = index;
+    }
+    head = index;
+}
+
+void SpatialIndex::Unlink(Grid& grid, std::uint32_t index) {
+    const Entry& entry = grid.entries[index];
+    const std::uint32_t prev = grid.prev[index];
+    if (prev != kNone) {
+        grid.entries[prev].next = entry.next;
+    } else {
+        HeadOf(grid, entry) = entry.next;
+    }
+    if (entry.next != kNone) {
+        grid.prev[entry.next] = prev;
+    }
+}
+
+void SpatialIndex::Insert(Grid& grid, NodeId id, const Bounds& bounds) {
+    const std::uint32_t index = static_cast<std::uint32_t>(ExtractIndex(id));
+    if (index >= grid.entries.size()) {
+        grid.entries.resize(static_cast<std::size_t>(index) + 1);
+        grid.ids.resize(static_cast<std::size_t>(index) + 1, 0);
+        grid.prev.resize(static_cast<std::size_t>(index) + 1, kNone);
+    }
+    assert(grid.ids[index] == 0 && "node is already in the spatial index");
+    grid.ids[index] = id;
+    Entry& entry = grid.entries[index];
+    entry.bounds = bounds;
+    entry.level = static_cast<std::uint32_t>(LevelOf(bounds));
+    if (entry.level < kLevelCount) {
+        entry.cellX = CellCoord(bounds.minX, entry.level);
+        entry.cellY = CellCoord(bounds.minY, entry.level);
+        ++grid.levelSizes[entry.level];
+    }
+    Link(grid, index);
+
+    if (++grid.size * kBucketsPerNode > grid.heads.size()) {
+        Rehash(grid, grid.bucketBits + 1);
+    }
+}
+
+bool SpatialIndex::MoveInPlace(Grid& grid, NodeId id, const Bounds& bounds) {
+    Entry& entry = grid.entries[static_cast<std::size_t>(ExtractIndex(id))];
+    const std::size_t level = LevelOf(bounds);
+    if (level != entry.level) {
+        return false;
+    }
+    if (level < kLevelCount &&
+        (CellCoord(bounds.minX, level) != entry.cellX || CellCoord(bounds.minY, level) != entry.cellY)) {
+        return false;
+    }
+    entry.bounds = bounds;
+    return true;
+}
+
+void SpatialIndex::Remove(Grid& grid, NodeId id) {
+    const std::uint32_t index = static_cast<std::uint32_t>(ExtractIndex(id));
+    assert(index < grid.ids.size() && grid.ids[index] == id && "node is not in the spatial index");
+    Unlink(grid, index);
+    const Entry& entry = grid.entries[index];
+    if (entry.level < kLevelCount) {
+        --grid.levelSizes[entry.level];
+    }
+    grid.ids[index] = 0;
+    --grid.size;
+}
+
+void SpatialIndex::Rehash(Grid& grid, std::uint32_t bucketBits) {
+    grid.bucketBits = bucketBits;
+    grid.heads.assign(std::size_t{1} << bucketBits, kNone);
+    grid.oversized = kNone;
+    for (std::size_t index = 0; index < grid.ids.size(); ++index) {
+        if (grid.ids[index] != 0) {
+            Link(grid, static_cast<std::uint32_t>(index));
+        }
+    }
+}
+
+std::size_t SpatialIndex::QueryPoint(float x, float y, std::vector<NodeId>& out) const {
+    return Read([&](const Grid& grid) { return QueryPoint(grid, x, y, out); });
+}
+
+std::size_t SpatialIndex::QueryRect(const Bounds& area, std::vector<NodeId>& out) const {
+    return Read([&](const Grid& grid) { return QueryRect(grid, area, out); });
+}
+
+std::size_t SpatialIndex::Size() const {
+    return Read([](const Grid& grid) { return grid.size; });
+}
+
+std::size_t SpatialIndex::QueryPoint(const Grid& grid, float x, float y, std::vector<NodeId>& out) const {
+    const std::size_t before = out.size();
+    for (std::size_t level = 0; level < kLevelCount; ++level) {
+        if (grid.levelSizes[level] == 0) {
+            continue;
+        }
+        const std::int32_t pointX = CellCoord(x, level);
+        const std::int32_t pointY = CellCoord(y, level);
+        for (std::int32_t cellY = pointY - 1; cellY <= pointY; ++cellY) {
+            for (std::int32_t cellX = pointX - 1; cellX <= pointX; ++cellX) {
+                // Other cells hashing to the same bucket are skipped by the cell check
+                std::uint32_t index = grid.heads[BucketOf(grid, level, cellX, cellY)];
+                while (index != kNone) {
+                    const Entry& entry = grid.entries[index];
+                    if (entry.cellX == cellX && entry.cellY == cellY && entry.level == level &&
+                        Contains(entry.bounds, x, y)) {
+                        out.push_back(grid.ids[index]);
+                    }
+                    index = entry.next;
+                }
+            }
+        }
+    }
+    for (std::uint32_t index = grid.oversized; index != kNone; index = grid.entries[index].next) {
+        if (Contains(grid.entries[index].bounds, x, y)) {
+            out.push_back(grid.ids[index]);
+        }
+    }
+    return out.size() - before;
+}
+
+std::size_t SpatialIndex::QueryRect(const Grid& grid, const Bounds& area, std::vector<NodeId>& out) const {
+    const std::size_t before = out.size();
+    if (area.IsEmpty()) {
+        return 0;
+    }
+
+    for (std::size_t level = 0; level < kLevelCount; ++level) {
+        if (grid.levelSizes[level] == 0) {
+            continue;
+        }
+        const std::int32_t minX = CellCoord(area.minX, level) - 1;
+        const std::int32_t minY = CellCoord(area.minY, level) - 1;
+        const std::int32_t maxX = CellCoord(area.maxX, level);
+        const std::int32_t maxY = CellCoord(area.maxY, level);
+        const std::size_t cells = static_cast<std::size_t>(maxX - minX + 1) * static_cast<std::size_t>(maxY - minY + 1);
+
+        if (cells > grid.heads.size()) {
+            // More cells than buckets: scan all entries once instead
+            for (std::size_t index = 0; index < grid.entries.size(); ++index) {
+                const Entry& entry = grid.entries[index];
+                if (grid.ids[index] != 0 && entry.level == level && entry.bounds.Intersects(area)) {
+                    out.push_back(grid.ids[index]);
+                }
+            }
+            continue;
+        }
+        for (std::int32_t cellY = minY; cellY <= maxY; ++cellY) {
+            for (std::int32_t cellX = minX; cellX <= maxX; ++cellX) {
+                std::uint32_t index = grid.heads[BucketOf(grid, level, cellX, cellY)];
+                while (index != kNone) {
+                    const Entry& entry = grid.entries[index];
+                    if (entry.cellX == cellX && entry.cellY == cellY && entry.level == level &&
+                        entry.bounds.Intersects(area)) {
+                        out.push_back(grid.ids[index]);
+                    }
+                    index = entry.next;
+                }
+            }
+        }
+    }
+    for (std::uint32_t index = grid.oversized; index != kNone; index = grid.entries[index].next) {
+        if (grid.entries[index].bounds.Intersects(area)) {
+            out.push_back(grid.ids[index]);
+        }
+    }
+    return out.size() - before;
+}
+
+} // namespace ui
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ui_ids.h"
+#include "Bounds.h"
+#include "MemoryStats.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ui {
+
+// One leaf's move in the index: drop `before`, add `after` (either may be empty)
+struct SpatialUpdate {
+    NodeId id = 0;
+    Bounds before;
+    Bounds after;
+};
+
+// ---------------------------------
+// SpatialIndex: hierarchical uniform grid over leaf bounds for hit-testing
+// Level L cuts the plane into square cells of cellSize * 2^L. A node is
+// listed once, at the smallest level whose cell is at least as large as
+// the node, in the cell holding its top-left corner; it can then only
+// reach into the next cell right and down, so a query looks one cell
+// further up and left on each level. Cells of all levels hash into one
+// table that grows with the node count.
+//
+// Two copies of the index (left-right): queries read the published copy
+// while Apply() updates the other one, flips them, waits for queries still
+// on the old copy and then brings that one up to date too. Queries never
+// wait; Apply() waits only for queries that started before the flip.
+// ---------------------------------
+
+class SpatialIndex {
+public:
+    static constexpr float kDefaultCellSize = 16.0f;
+
+    explicit SpatialIndex(float cellSize = kDefaultCellSize);
+
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+    // Writer (one thread at a time): apply moves and publish the result.
+    // `before` must be non-empty exactly when the node is in the index;
+    // a node appears at most once per call.
+    void Apply(const std::vector<SpatialUpdate>& updates);
+
+    // Any thread: append nodes whose bounds, as last given to Apply(),
+    // contain the point / intersect `area` (each node once, in no particular
+    // order); returns the count added. The index is as exact as those bounds.
+    std::size_t QueryPoint(float x, float y, std::vector<NodeId>& out) const;
+    std::size_t QueryRect(const Bounds& area, std::vector<NodeId>& out) const;
+
+    // Any thread: nodes in the published copy
+    std::size_t Size() const;
+
+private:
+    static constexpr std::size_t kLevelCount = 16;  // larger nodes go to the oversized list
+    static constexpr std::size_t kInitialBuckets = 1024;  // power of two
+    static constexpr std::size_t kBucketsPerNode = 2;  // the table doubles below this
+    static constexpr std::uint32_t kNone = ~0u;
+    // Apply() copies the updated grid instead of updating the other one
+    // when updates reach 1 / kCopyRatio of the nodes
+    static constexpr std::size_t kCopyRatio = 4;
+
+    // By handle index: what queries read of a node listed in cell
+    // (cellX, cellY) of `level`. Nodes of one bucket form a doubly linked
+    // list through their entries (back links kept apart in Grid::prev).
+    struct Entry {
+        Bounds bounds;
+        std::int32_t cellX = 0;
+        std::int32_t cellY = 0;
+        std::uint32_t level = 0;  // kLevelCount = oversized list
+        std::uint32_t next = kNone;
+    };
+
+    struct Grid {
+        TrackedVector<std::uint32_t, MemoryTag::RenderStorage> heads;  // first entry per bucket
+        TrackedVector<Entry, MemoryTag::RenderStorage> entries;
+        TrackedVector<NodeId, MemoryTag::RenderStorage> ids;  // by handle index; 0 = not listed
+        TrackedVector<std::uint32_t, MemoryTag::RenderStorage> prev;
+        std::uint32_t oversized = kNone;  // nodes too large for the top level; every query scans them
+        std::array<std::size_t, kLevelCount> levelSizes{};
+        std::uint32_t bucketBits = 0;
+        std::size_t size = 0;
+    };
+
+    // Queries in flight that entered while the version was this side
+    struct alignas(64) ReaderCount {
+        std::atomic<std::uint32_t> count{0};
+    };
+
+    std::int32_t CellCoord(float value, std::size_t level) const;
+    // Level a node of these bounds is listed at; kLevelCount = oversized
+    std::size_t LevelOf(const Bounds& bounds) const;
+    static std::size_t BucketOf(const Grid& grid, std::size_t level, std::int32_t cellX, std::int32_t cellY);
+
+    // Run `read` on the published grid; the grid stays unchanged until it returns
+    template <class F>
+    std::size_t Read(F&& read) const {
+        const std::uint32_t version = m_version.load();
+        m_readers[version].count.fetch_add(1);
+        const std::size_t result = read(m_grids[m_published.load()]);
+        m_readers[version].count.fetch_sub(1);
+        return result;
+    }
+
+    // Writer: wait until no query can still read the unpublished grid
+    void WaitForReaders();
+
+    void ApplyTo(Grid& grid, const std::vector<SpatialUpdate>& updates);
+    void Insert(Grid& grid, NodeId id, const Bounds& bounds);
+    // Small moves within a node's cell just update its bounds; false if the cell changes
+    bool MoveInPlace(Grid& grid, NodeId id, const Bounds& bounds);
+    void Remove(Grid& grid, NodeId id);
+    void Rehash(Grid& grid, std::uint32_t bucketBits);
+
+    // List head of the bucket an entry belongs in
+    static std::uint32_t& HeadOf(Grid& grid, const Entry& entry);
+    static void Link(Grid& grid, std::uint32_t index);
+    static void Unlink(Grid& grid, std::uint32_t index);
+
+    std::size_t QueryPoint(const Grid& grid, float x, float y, std::vector<NodeId>& out) const;
+    std::size_t QueryRect(const Grid& grid, const Bounds& area, std::vector<NodeId>& out) const;
+
+    std::array<float, kLevelCount> m_cellSizes{};
+    std::array<float, kLevelCount> m_inverseCellSizes{};
+    Grid m_grids[2];
+    std::atomic<std::uint32_t> m_published{0};  // grid queries read
+    std::atomic<std::uint32_t> m_version{0};    // reader count new queries register in
+    mutable ReaderCount m_readers[2];
+};
+
+} // namespace ui
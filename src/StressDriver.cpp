@@ -0,0 +1,276 @@
+#include "StressDriver.h"
+
+#include "FrameScheduler.h"
+#include "MemoryStats.h"
+#include "RenderContext.h"
+#include "SharedRenderTree.h"
+#include "TraceProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace ui {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+FrameScheduler MakeScheduler(double hz, MissPolicy policy, const char* missedCounterName) {
+    FrameSchedulerConfig config;
+    config.hz = hz;
+    config.policy = policy;
+    config.missedCounterName = missedCounterName;
+    return FrameScheduler(config);
+}
+
+} // namespace
+
+std::string StressReport::Format() {
+    std::ostringstream out;
+    out << "stress: " << nodeCount << " nodes";
+    if (nodeCount < requestedNodeCount) {
+        out << " (requested " << requestedNodeCount << ", capped by depth/fanout/mix)";
+    }
+    out << ", built in " << buildSeconds * 1000.0 << " ms\n";
+    out << "  " << updateFrames << " update frames, " << renderFrames << " render frames in "
+        << seconds << " s\n";
+    if (seconds > 0.0) {
+        out << "  throughput: " << static_cast<double>(updateFrames) / seconds << " updates/s, "
+            << static_cast<double>(renderFrames) / seconds << " renders/s, "
+            << static_cast<double>(changes) / seconds << " changes/s\n";
+    }
+    if (!publishing) {
+        out << "  last frame: " << lastCommandCount << " render commands in " << lastDrawBatchCount
+            << " draw batches\n";
+    }
+    out << "  " << updateFrame.Format("update") << "\n";
+    out << "  " << sync.Format("sync") << "\n";
+    if (budgetedFrames > 0) {
+        out << "  sync budget: " << budgetedFrames << " frames deferred changes, max backlog " << maxDeferred << "\n";
+    }
+    out << "  " << renderFrame.Format("render") << "\n";
+    out << "  " << collect.Format("collect") << "\n";
+    if (animate.Count() > 0) {
+        out << "  " << animate.Format("animate") << "  " << lastAnimationCount << " animations\n";
+    }
+    if (updateInterval.Count() > 0) {
+        out << "  " << updateInterval.Format("update dt") << "  missed " << updateMissed << "\n";
+    }
+    if (renderInterval.Count() > 0) {
+        out << "  " << renderInterval.Format("render dt") << "  missed " << renderMissed << "\n";
+    }
+    if (pick.Count() > 0) {
+        // Sub-microsecond: reported in ns rather than the usual ms columns
+        out << "  pick: " << pick.Count() << " point queries, mean " << pick.Mean().count() << " ns, p99 "
+            << pick.Percentile(99.0).count() << " ns, max " << pick.Percentile(100.0).count() << " ns, "
+            << static_cast<double>(pickHits) / static_cast<double>(pick.Count()) << " hits/query\n";
+    }
+    if (pipelineDepth > 0) {
+        out << "  pipeline depth " << pipelineDepth << ": " << pipeline.coalescedFrames << " coalesced frames, "
+            << pipeline.backpressureWaits << " backpressure waits ("
+            << std::chrono::duration<double, std::milli>(pipeline.backpressureTime).count() << " ms), render idle "
+            << std::chrono::duration<double, std::milli>(pipeline.renderIdleTime).count() << " ms\n";
+    }
+    if (captured) {
+        out << "  captured " << updateFrames + 1 << " Syncs\n";
+    }
+    if (streaming) {
+        const std::uint64_t deltas = stream.messages - stream.keyframes;
+        out << "  stream: " << stream.viewers << " viewers, " << deltas << " deltas (" << stream.records
+            << " records, " << stream.deltaBytes << " B";
+        if (stream.records > 0) {
+            out << ", " << static_cast<double>(stream.deltaBytes) / static_cast<double>(stream.records) << " B/record";
+        }
+        out << "), " << stream.keyframes << " keyframes (" << stream.keyframeBytes << " B), "
+            << stream.droppedFrames << " frames dropped\n";
+    }
+    if (publishing) {
+        out << "  " << publish.Format("publish") << "  " << publishedFrames << " frames published, "
+            << droppedFrames << " dropped\n";
+    }
+    return out.str();
+}
+
+StressDriver::StressDriver(const StressConfig& config)
+    : StressDriver(config, RenderContext::Instance()) {}
+
+StressDriver::StressDriver(const StressConfig& config, RenderContext& ctx)
+    : m_config(config)
+    , m_ctx(ctx) {}
+
+StressReport StressDriver::Run(const SubmitFn& submit) {
+    auto& ctx = m_ctx;
+    StressReport report;
+
+    const auto buildBegin = Clock::now();
+    StressScene scene(m_config, ctx);
+    const bool capturing = !m_config.capturePath.empty() && ctx.StartCapture(m_config.capturePath, scene.RootId());
+    report.streaming = !m_config.streamPath.empty() &&
+        ctx.StartDisplayStream(m_config.streamPath, scene.RootId(), m_config.keyframeInterval);
+    ctx.Sync();
+    report.buildSeconds = std::chrono::duration<double>(Clock::now() - buildBegin).count();
+    report.nodeCount = scene.NodeCount();
+    report.requestedNodeCount = m_config.nodeCount;
+
+    const Bounds viewport = m_config.viewportWidth > 0.0f && m_config.viewportHeight > 0.0f
+        ? Bounds::FromRect(0.0f, 0.0f, m_config.viewportWidth, m_config.viewportHeight)
+        : Bounds::Infinite();
+
+    SyncBudget budget;
+    budget.time = m_config.syncBudget;
+    budget.maxChanges = m_config.syncBudgetChanges;
+
+    SharedTreePublisher publisher;
+    report.publishing = !m_config.publishName.empty() &&
+        publisher.Create(m_config.publishName, m_config.publishSlotBytes);
+
+    std::atomic<bool> updateDone{false};
+    const bool pipelined = m_config.pipelineDepth > 0;
+    FramePipeline pipeline(m_config.pipelineDepth);
+    report.pipelineDepth = m_config.pipelineDepth;
+    const auto runBegin = Clock::now();
+
+    std::thread updateThread([&]() {
+        TraceProfiler::Instance().RegisterThread("stress_update");
+        FrameScheduler scheduler = MakeScheduler(m_config.updateHz, m_config.missPolicy, "stress.update.missed");
+        Clock::time_point lastBegin{};
+        for (std::size_t frame = 0; frame < m_config.frames; ++frame) {
+            const FrameId frameId = pipelined ? pipeline.BeginUpdate() : 0;
+            if (pipelined && frameId == 0) {
+                break;
+            }
+
+            TRACE_SCOPE("Stress::Update");
+            const auto begin = Clock::now();
+            if (frame > 0 && m_config.updateHz > 0.0) {
+                report.updateInterval.Add(begin - lastBegin);
+            }
+            lastBegin = begin;
+            report.changes += scene.Mutate();
+
+            const auto syncBegin = Clock::now();
+            const SyncResult synced = ctx.Sync(budget);
+            const auto end = Clock::now();
+            if (synced.deferred > 0) {
+                ++report.budgetedFrames;
+                report.maxDeferred = std::max(report.maxDeferred, synced.deferred);
+            }
+            if (pipelined) {
+                pipeline.PublishFrame(frameId);
+            }
+
+            report.sync.Add(end - syncBegin);
+            report.updateFrame.Add(end - begin);
+            ++report.updateFrames;
+            MemoryStats::Instance().EndFrame();
+            scheduler.WaitForNextFrame();
+        }
+        report.updateMissed = scheduler.MissedDeadlines();
+        updateDone = true;
+        pipeline.Stop();
+    });
+
+    std::thread renderThread([&]() {
+        TraceProfiler::Instance().RegisterThread("stress_render");
+        FrameScheduler scheduler = MakeScheduler(m_config.renderHz, m_config.missPolicy, "stress.render.missed");
+        Clock::time_point lastBegin{};
+        RenderCommandList commands;
+        std::vector<DrawBatch> batches;
+        while (!updateDone) {
+            const FrameId frameId = pipelined ? pipeline.AcquireRenderFrame() : 0;
+            if (pipelined && frameId == 0) {
+                break;
+            }
+
+            TRACE_SCOPE("Stress::Render");
+            const auto begin = Clock::now();
+            if (report.renderFrames > 0 && m_config.renderHz > 0.0) {
+                report.renderInterval.Add(begin - lastBegin);
+            }
+            lastBegin = begin;
+            {
+                auto lock = ctx.LockForRender();
+                if (ctx.RunningAnimations() > 0) {
+                    const auto animateBegin = Clock::now();
+                    report.lastAnimationCount = ctx.RunningAnimations();
+                    ctx.AdvanceAnimations(animateBegin);
+                    report.animate.Add(Clock::now() - animateBegin);
+                }
+                const auto collectBegin = Clock::now();
+                if (report.publishing) {
+                    // The compositor collects; this only hands the tree over
+                    if (publisher.Publish(ctx, scene.RootId())) {
+                        ++report.publishedFrames;
+                    } else {
+                        ++report.droppedFrames;
+                    }
+                    report.publish.Add(Clock::now() - collectBegin);
+                } else {
+                    CollectRenderCommands(ctx, scene.RootId(), commands,
+                                          m_config.parallelCollect ? CollectMode::Parallel : CollectMode::Serial,
+                                          viewport);
+                }
+                report.collect.Add(Clock::now() - collectBegin);
+            }
+            if (submit && !report.publishing) {
+                submit(commands);
+            }
+            if (pipelined) {
+                pipeline.ReleaseRenderFrame(frameId);
+            }
+            report.renderFrame.Add(Clock::now() - begin);
+            report.lastCommandCount = commands.size();
+            BuildDrawBatches(commands, batches);
+            report.lastDrawBatchCount = batches.size();
+            ++report.renderFrames;
+            scheduler.WaitForNextFrame();
+        }
+        report.renderMissed = scheduler.MissedDeadlines();
+    });
+
+    // Stands in for input handling: hit-tests race Sync, never taking the render mutex
+    std::thread pickThread;
+    if (m_config.pickHz > 0.0) {
+        pickThread = std::thread([&]() {
+            TraceProfiler::Instance().RegisterThread("stress_pick");
+            FrameScheduler scheduler = MakeScheduler(m_config.pickHz, MissPolicy::Skip, nullptr);
+            const Bounds area = StressScene::Area();
+            std::mt19937 rng(m_config.seed);
+            std::uniform_real_distribution<float> px(area.minX, area.maxX);
+            std::uniform_real_distribution<float> py(area.minY, area.maxY);
+            std::vector<NodeId> hits;
+            while (!updateDone) {
+                const float x = px(rng);
+                const float y = py(rng);
+                hits.clear();
+                const auto begin = Clock::now();
+                report.pickHits += ctx.QueryPoint(x, y, hits);
+                report.pick.Add(Clock::now() - begin);
+                scheduler.WaitForNextFrame();
+            }
+        });
+    }
+
+    updateThread.join();
+    renderThread.join();
+    if (pickThread.joinable()) {
+        pickThread.join();
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - runBegin).count();
+    report.pipeline = pipeline.GetStats();
+    if (capturing) {
+        report.captured = ctx.StopCapture();
+    }
+    if (report.streaming) {
+        report.stream = ctx.StopDisplayStream();
+    }
+    return report;
+}
+
+} // namespace ui
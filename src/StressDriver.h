@@ -0,0 +1,74 @@
+#pragma once
+
+#include "DisplayStream.h"
+#include "FramePipeline.h"
+#include "FrameStats.h"
+#include "RenderCommands.h"
+#include "StressScene.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ui {
+
+struct StressReport {
+    std::size_t nodeCount = 0;
+    std::size_t requestedNodeCount = 0;
+    std::size_t updateFrames = 0;
+    std::size_t renderFrames = 0;
+    std::size_t changes = 0;        // node writes issued by the update side
+    std::size_t lastCommandCount = 0;
+    std::size_t lastDrawBatchCount = 0;  // draw calls the commands batch into
+    double seconds = 0.0;
+    double buildSeconds = 0.0;
+
+    FrameTimeStats updateFrame;     // mutate + Sync
+    FrameTimeStats sync;
+    FrameTimeStats renderFrame;     // collect + submit (or publish)
+    FrameTimeStats collect;         // time inside the render mutex
+    FrameTimeStats animate;         // render thread: AdvanceAnimations, when any run
+    std::size_t lastAnimationCount = 0;
+    FrameTimeStats updateInterval;  // start-to-start, paced runs only
+    FrameTimeStats renderInterval;
+    std::uint64_t updateMissed = 0; // FrameScheduler missed deadlines
+    std::uint64_t renderMissed = 0;
+    std::size_t maxDeferred = 0;    // budgeted Sync: largest backlog left by a frame
+    std::size_t budgetedFrames = 0; // frames that left changes queued
+
+    FrameTimeStats pick;            // event thread: one point query
+    std::size_t pickHits = 0;
+
+    std::size_t pipelineDepth = 0;  // 0 = free-running loops
+    bool captured = false;          // StressConfig::capturePath was written
+    bool publishing = false;        // StressConfig::publishName was created
+    FrameTimeStats publish;         // render thread: SharedTreePublisher::Publish
+    std::size_t publishedFrames = 0;
+    std::size_t droppedFrames = 0;  // no free slot, or the tree did not fit one
+    bool streaming = false;         // StressConfig::streamPath was bound
+    DisplayStreamStats stream;
+    FramePipeline::Stats pipeline;
+
+    std::string Format();
+};
+
+// Runs a StressScene with one update thread and one render thread,
+// unthrottled or at the configured rates, for a fixed number of frames
+class StressDriver {
+public:
+    // Render thread: receives each collected command list (e.g. OpenGL submission)
+    using SubmitFn = std::function<void(const RenderCommandList&)>;
+
+    // Drives a scene in `ctx`, or in the default RenderContext
+    StressDriver(const StressConfig& config, RenderContext& ctx);
+    explicit StressDriver(const StressConfig& config);
+
+    StressReport Run(const SubmitFn& submit = {});
+
+private:
+    StressConfig m_config;
+    RenderContext& m_ctx;
+};
+
+} // namespace ui
@@ -0,0 +1,188 @@
+#include "StressScene.h"
+
+#include "RenderContext.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <utility>
+
+namespace ui {
+
+namespace {
+
+constexpr float kSceneWidth = 800.0f;
+constexpr float kSceneHeight = 600.0f;
+
+// Animated leaves sway up to this far around their position, once per period
+constexpr float kSwayDistance = 40.0f;
+constexpr float kMinSwayPeriod = 1.0f;
+constexpr float kMaxSwayPeriod = 4.0f;
+
+// There and back, so every run starts where the last one ended
+AnimationSpec Sway(AnimatedProperty property, float origin, float distance, float period) {
+    AnimationSpec spec;
+    spec.property = property;
+    spec.keys.push_back(Keyframe{0.0f, origin, Easing::Linear});
+    spec.keys.push_back(Keyframe{period * 0.5f, origin + distance, Easing::EaseInOut});
+    spec.keys.push_back(Keyframe{period, origin, Easing::EaseInOut});
+    spec.repeat = kRepeatForever;
+    return spec;
+}
+
+} // namespace
+
+StressScene::StressScene(const StressConfig& config)
+    : StressScene(config, RenderContext::Instance()) {}
+
+Bounds StressScene::Area() {
+    return Bounds::FromRect(0.0f, 0.0f, kSceneWidth, kSceneHeight);
+}
+
+StressScene::StressScene(const StressConfig& config, RenderContext& ctx)
+    : m_config(config)
+    , m_ctx(ctx)
+    , m_rng(config.seed) {
+
+    m_rootId = ctx.AllocateNodeId();
+    m_containers.push_back(FrontendContainer::Create(m_ctx, m_rootId));
+    m_containers.back()->SetPosition(0.0f, 0.0f);
+
+    const float leafWeight = m_config.textWeight + m_config.rectWeight;
+    const float totalWeight = m_config.containerWeight + leafWeight;
+    std::uniform_real_distribution<float> pick(0.0f, totalWeight > 0.0f ? totalWeight : 1.0f);
+
+    // Breadth-first fill: every container gets up to `fanout` children
+    std::deque<std::pair<FrontendContainer*, std::size_t>> open;
+    open.emplace_back(m_containers.back().get(), 0);
+
+    while (!open.empty() && NodeCount() < m_config.nodeCount) {
+        auto [parent, depth] = open.front();
+        open.pop_front();
+
+        const bool canNest = depth + 1 < m_config.maxDepth;
+        for (std::size_t i = 0; i < m_config.fanout && NodeCount() < m_config.nodeCount; ++i) {
+            // Keep at least one open container while nodes are still missing
+            const bool lastChance = open.empty() && i + 1 == m_config.fanout;
+            const float roll = pick(m_rng);
+
+            if (canNest && (roll < m_config.containerWeight || lastChance)) {
+                const NodeId id = ctx.AllocateNodeId();
+                m_containers.push_back(FrontendContainer::Create(m_ctx, id));
+                FrontendContainer* container = m_containers.back().get();
+                parent->AddChild(container);
+                open.emplace_back(container, depth + 1);
+                continue;
+            }
+
+            const bool isText = (roll - m_config.containerWeight) < m_config.textWeight;
+            m_leaves.push_back(CreateLeaf(isText ? LeafKind::Text : LeafKind::Rect, parent));
+        }
+    }
+
+    if (m_config.animatedRate > 0.0) {
+        std::bernoulli_distribution animate(std::min(m_config.animatedRate, 1.0));
+        for (Leaf& leaf : m_leaves) {
+            if (animate(m_rng)) {
+                Animate(leaf);
+            }
+        }
+    }
+}
+
+void StressScene::Animate(Leaf& leaf) {
+    std::uniform_real_distribution<float> distance(-kSwayDistance, kSwayDistance);
+    std::uniform_real_distribution<float> period(kMinSwayPeriod, kMaxSwayPeriod);
+    AnimationSpec x = Sway(AnimatedProperty::X, leaf.x, distance(m_rng), period(m_rng));
+    AnimationSpec y = Sway(AnimatedProperty::Y, leaf.y, distance(m_rng), period(m_rng));
+    if (leaf.kind == LeafKind::Text) {
+        auto* text = static_cast<FrontendText*>(leaf.node.get());
+        text->Animate(std::move(x));
+        text->Animate(std::move(y));
+    } else {
+        auto* rect = static_cast<FrontendShapeRect*>(leaf.node.get());
+        rect->Animate(std::move(x));
+        rect->Animate(std::move(y));
+    }
+    leaf.animated = true;
+}
+
+StressScene::~StressScene() {
+    // FrontendNode destructors call Term(); apply the deletions
+    m_leaves.clear();
+    m_containers.clear();
+    m_ctx.Sync();
+}
+
+StressScene::Leaf StressScene::CreateLeaf(LeafKind kind, FrontendContainer* parent) {
+    std::uniform_real_distribution<float> px(0.0f, kSceneWidth);
+    std::uniform_real_distribution<float> py(0.0f, kSceneHeight);
+
+    Leaf leaf;
+    leaf.kind = kind;
+    leaf.parent = parent;
+    leaf.x = px(m_rng);
+    leaf.y = py(m_rng);
+
+    const bool interpolated =
+        m_config.interpolatedRate > 0.0 && std::bernoulli_distribution(std::min(m_config.interpolatedRate, 1.0))(m_rng);
+
+    const NodeId id = m_ctx.AllocateNodeId();
+    if (kind == LeafKind::Text) {
+        auto text = FrontendText::Create(m_ctx, id);
+        text->SetText("item " + std::to_string(m_textCounter++));
+        if (interpolated) {
+            text->SetInterpolated(true);
+        }
+        leaf.node = std::move(text);
+    } else {
+        std::uniform_real_distribution<float> size(4.0f, 32.0f);
+        auto rect = FrontendShapeRect::Create(m_ctx, id);
+        rect->SetWidth(size(m_rng));
+        rect->SetHeight(size(m_rng));
+        if (interpolated) {
+            rect->SetInterpolated(true);
+        }
+        leaf.node = std::move(rect);
+    }
+    leaf.node->SetPosition(leaf.x, leaf.y);
+    parent->AddChild(leaf.node.get());
+    return leaf;
+}
+
+std::size_t StressScene::Mutate() {
+    if (m_leaves.empty()) {
+        return 0;
+    }
+
+    std::uniform_int_distribution<std::size_t> pickLeaf(0, m_leaves.size() - 1);
+    std::uniform_real_distribution<float> step(-4.0f, 4.0f);
+
+    std::size_t touched = 0;
+    const auto mutations = static_cast<std::size_t>(m_config.mutationRate * static_cast<double>(m_leaves.size()));
+    for (std::size_t i = 0; i < mutations; ++i) {
+        Leaf& leaf = m_leaves[pickLeaf(m_rng)];
+        if (leaf.animated) {
+            continue;
+        }
+        ++touched;
+        leaf.x += step(m_rng);
+        leaf.y += step(m_rng);
+        leaf.node->SetPosition(leaf.x, leaf.y);
+    }
+
+    const auto churn = static_cast<std::size_t>(m_config.churnRate * static_cast<double>(m_leaves.size()));
+    for (std::size_t i = 0; i < churn; ++i) {
+        Leaf& leaf = m_leaves[pickLeaf(m_rng)];
+        if (leaf.animated) {
+            continue;
+        }
+        touched += 2;
+        leaf.node->Term();
+        leaf = CreateLeaf(leaf.kind, leaf.parent);
+    }
+
+    return touched;
+}
+
+} // namespace ui
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Bounds.h"
+#include "FrameScheduler.h"
+#include "FrontendNodes.h"
+#include "ui_ids.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ui {
+
+// Stress workload description (scene shape, mutation load, pacing)
+struct StressConfig {
+    std::size_t nodeCount = 10000;  // total nodes including containers
+    std::size_t maxDepth = 4;       // root is depth 0
+    std::size_t fanout = 16;
+
+    // Relative weights of node kinds
+    float containerWeight = 1.0f;
+    float textWeight = 1.0f;
+    float rectWeight = 2.0f;
+
+    double mutationRate = 0.05;  // fraction of leaves moved per frame
+    double churnRate = 0.0;      // fraction of leaves deleted and recreated per frame
+    // Fraction of leaves that sway on looping render-side animations
+    // (AnimationSpec) instead of being moved; mutations and churn skip them
+    double animatedRate = 0.0;
+    // Fraction of leaves whose moves glide on the render side (SetInterpolated)
+    double interpolatedRate = 0.0;
+
+    double updateHz = 0.0;  // 0 = unthrottled
+    double renderHz = 0.0;  // 0 = unthrottled
+    MissPolicy missPolicy = MissPolicy::Skip;  // paced loops that overrun a frame
+    std::size_t frames = 600;  // update frames to run
+
+    // Frames the update side may run ahead of render (FramePipeline);
+    // 0 = update and render loops run independently
+    std::size_t pipelineDepth = 1;
+
+    // Collect render commands with subtree jobs (CollectMode::Parallel)
+    bool parallelCollect = false;
+
+    // Cull against a viewport at the origin; 0 = no culling
+    float viewportWidth = 0.0f;
+    float viewportHeight = 0.0f;
+
+    // Per-frame Sync budget (SyncBudget); zero = apply everything each frame
+    std::chrono::microseconds syncBudget{0};
+    std::size_t syncBudgetChanges = 0;
+
+    // Event thread: hit-tests per second at random points of the scene area,
+    // without the render mutex; 0 = no event thread
+    double pickHz = 0.0;
+
+    // Record every Sync of the run, the build included, to this file
+    // (RenderContext::StartCapture); empty = off
+    std::string capturePath;
+
+    // Publish the render tree to this shared-memory region (SharedTreePublisher)
+    // every render frame instead of collecting commands, for a ui_compositor
+    // process to draw; empty = off
+    std::string publishName;
+    std::size_t publishSlotBytes = std::size_t{64} << 20;
+
+    // Stream every Sync to a viewer on this Unix socket (RenderContext::StartDisplayStream); empty = off
+    std::string streamPath;
+    std::size_t keyframeInterval = 120;
+
+    std::uint32_t seed = 1;
+};
+
+// Synthetic scene built through the Frontend API from a StressConfig
+class StressScene {
+public:
+    // Builds in `ctx`, or in the default RenderContext
+    StressScene(const StressConfig& config, RenderContext& ctx);
+    explicit StressScene(const StressConfig& config);
+    ~StressScene();
+
+    StressScene(const StressScene&) = delete;
+    StressScene& operator=(const StressScene&) = delete;
+
+    NodeId RootId() const { return m_rootId; }
+    // Area leaf positions are drawn from
+    static Bounds Area();
+    std::size_t NodeCount() const { return m_containers.size() + m_leaves.size(); }
+    std::size_t LeafCount() const { return m_leaves.size(); }
+
+    // Update thread: one frame of mutations and churn (caller syncs)
+    // Returns the number of nodes touched
+    std::size_t Mutate();
+
+private:
+    enum class LeafKind {
+        Text,
+        Rect
+    };
+
+    struct Leaf {
+        std::unique_ptr<FrontendNode> node;
+        FrontendContainer* parent = nullptr;
+        LeafKind kind = LeafKind::Rect;
+        float x = 0.0f;
+        float y = 0.0f;
+        bool animated = false;
+    };
+
+    Leaf CreateLeaf(LeafKind kind, FrontendContainer* parent);
+    // Start the looping sway of an animated leaf
+    void Animate(Leaf& leaf);
+
+    StressConfig m_config;
+    RenderContext& m_ctx;
+    std::mt19937 m_rng;
+
+    NodeId m_rootId = 0;
+    std::vector<std::unique_ptr<FrontendContainer>> m_containers;  // [0] is root
+    std::vector<Leaf> m_leaves;
+    std::size_t m_textCounter = 0;
+};
+
+} // namespace ui
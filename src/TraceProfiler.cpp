@@ -5,6 +5,25 @@
 
 namespace ui {
 
+namespace {
+
+// Cached internal tid of the calling thread; avoids the map lookup per scope
+thread_local bool t_hasTid = false;
+thread_local std::uint64_t t_tid = 0;
+
+void WriteJsonString(std::ofstream& out, const char* str) {
+    out << '"';
+    for (const char* c = str; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
 TraceProfiler& TraceProfiler::Instance() {
     static TraceProfiler instance;
     return instance;
@@ -15,27 +34,59 @@ void TraceProfiler::BeginSession(const std::string& path) {
     m_events.clear();
     m_filePath = path;
     m_sessionStart = std::chrono::steady_clock::now();
-    m_sessionOpen = true;
+    m_sessionOpen.store(true, std::memory_order_relaxed);
 }
 
 void TraceProfiler::EndSession() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_sessionOpen) {
+    if (!IsSessionOpen()) {
         return;
     }
     DumpToFile();
-    m_sessionOpen = false;
+    m_sessionOpen.store(false, std::memory_order_relaxed);
+}
+
+std::uint16_t TraceProfiler::RegisterScope(const char* name, const char* file, int line, const char* category) {
+    std::lock_guard<std::mutex> lock(m_scopesMutex);
+    if (m_scopes.size() > 0xFFFF) {
+        // Out of ids: fold further call sites into the last descriptor
+        return 0xFFFF;
+    }
+    m_scopes.push_back(TraceScopeDescriptor{name, file, line, category});
+    return static_cast<std::uint16_t>(m_scopes.size() - 1);
 }
 
-void TraceProfiler::RecordEvent(const char* name,
+void TraceProfiler::RecordEvent(std::uint16_t scopeId,
                                 std::uint64_t startUs,
                                 std::uint64_t durUs,
                                 std::uint64_t tid) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_sessionOpen) {
+    if (!IsSessionOpen()) {
         return;
     }
-    m_events.push_back(TraceEvent{std::string(name), startUs, durUs, tid});
+    TraceEvent e;
+    e.scopeId = scopeId;
+    e.tsMicro = startUs;
+    e.durMicro = durUs;
+    e.tid = tid;
+    m_events.push_back(std::move(e));
+}
+
+void TraceProfiler::RecordCounter(std::uint16_t scopeId, std::int64_t value) {
+    if (!IsSessionOpen()) {
+        return;
+    }
+    TraceEvent e;
+    e.scopeId = scopeId;
+    e.tsMicro = NowSinceStartUs();
+    e.tid = CurrentThreadId();
+    e.isCounter = true;
+    e.counterValue = value;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!IsSessionOpen()) {
+        return;
+    }
+    m_events.push_back(std::move(e));
 }
 
 std::uint64_t TraceProfiler::NowSinceStartUs() const {
@@ -53,27 +104,32 @@ std::uint64_t TraceProfiler::RegisterThread(const char* name) {
     }
     const std::uint64_t tid = m_nextTid++;
     m_threadMap[id] = tid;
-    if (m_sessionOpen && name) {
+    t_tid = tid;
+    t_hasTid = true;
+    if (IsSessionOpen() && name) {
         EmitThreadNameMetadata(tid, name);
     }
     return tid;
 }
 
 std::uint64_t TraceProfiler::CurrentThreadId() {
+    if (t_hasTid) {
+        return t_tid;
+    }
     std::lock_guard<std::mutex> lock(m_mutex);
     const auto id = std::this_thread::get_id();
     auto it = m_threadMap.find(id);
-    if (it != m_threadMap.end()) {
-        return it->second;
+    if (it == m_threadMap.end()) {
+        it = m_threadMap.emplace(id, m_nextTid++).first;
     }
-    const std::uint64_t tid = m_nextTid++;
-    m_threadMap[id] = tid;
-    return tid;
+    t_tid = it->second;
+    t_hasTid = true;
+    return t_tid;
 }
 
 void TraceProfiler::EmitThreadNameMetadata(std::uint64_t tid, const std::string& name) {
     m_events.push_back(TraceEvent{
-        "thread_name",
+        0,
         0,
         0,
         tid,
@@ -88,6 +144,13 @@ void TraceProfiler::DumpToFile() {
         return;
     }
 
+    // Descriptors are append-only; copy the table once for the dump
+    std::vector<TraceScopeDescriptor> scopes;
+    {
+        std::lock_guard<std::mutex> lock(m_scopesMutex);
+        scopes = m_scopes;
+    }
+
     out << "{ \"traceEvents\": [";
     bool first = true;
     for (const auto& e : m_events) {
@@ -96,43 +159,65 @@ void TraceProfiler::DumpToFile() {
         }
         first = false;
         out << "{";
-        out << "\"name\":\"" << e.name << "\",";
-        out << "\"cat\":\"trace\",";
         if (e.isMetadata) {
+            out << "\"name\":\"thread_name\",";
+            out << "\"cat\":\"trace\",";
             out << "\"ph\":\"M\",";
             out << "\"ts\":0,";
             out << "\"pid\":0,";
             out << "\"tid\":" << e.tid << ",";
             out << "\"args\":{\"name\":\"" << e.threadName << "\"}";
+        } else if (e.isCounter) {
+            const TraceScopeDescriptor desc =
+                e.scopeId < scopes.size() ? scopes[e.scopeId] : TraceScopeDescriptor{};
+            out << "\"name\":";
+            WriteJsonString(out, desc.name);
+            out << ",\"cat\":";
+            WriteJsonString(out, desc.category);
+            out << ",";
+            out << "\"ph\":\"C\",";
+            out << "\"ts\":" << e.tsMicro << ",";
+            out << "\"pid\":0,";
+            out << "\"tid\":" << e.tid << ",";
+            out << "\"args\":{\"value\":" << e.counterValue << "}";
         } else {
+            const TraceScopeDescriptor desc =
+                e.scopeId < scopes.size() ? scopes[e.scopeId] : TraceScopeDescriptor{};
+            out << "\"name\":";
+            WriteJsonString(out, desc.name);
+            out << ",\"cat\":";
+            WriteJsonString(out, desc.category);
+            out << ",";
             out << "\"ph\":\"X\",";
             out << "\"ts\":" << e.tsMicro << ",";
             out << "\"dur\":" << e.durMicro << ",";
             out << "\"pid\":0,";
-            out << "\"tid\":" << e.tid;
+            out << "\"tid\":" << e.tid << ",";
+            out << "\"args\":{\"file\":";
+            WriteJsonString(out, desc.file);
+            out << ",\"line\":" << desc.line << "}";
         }
         out << "}";
     }
     out << "] }";
 }
 
-TraceScope::TraceScope(const char* name)
-    : m_name(name)
-    , m_begin(std::chrono::steady_clock::now()) {
+TraceScope::TraceScope(std::uint16_t scopeId)
+    : m_scopeId(scopeId)
+    , m_active(TraceProfiler::Instance().IsSessionOpen()) {
+    if (m_active) {
+        m_beginUs = TraceProfiler::Instance().NowSinceStartUs();
+    }
 }
 
 TraceScope::~TraceScope() {
-    const auto end = std::chrono::steady_clock::now();
-    const auto endUs = TraceProfiler::Instance().NowSinceStartUs();
-    const auto durUs =
-        std::chrono::duration_cast<std::chrono::microseconds>(end - m_begin).count();
-    const auto startUs = (endUs > static_cast<std::uint64_t>(durUs))
-                             ? endUs - static_cast<std::uint64_t>(durUs)
-                             : 0;
-    const auto tid = TraceProfiler::Instance().CurrentThreadId();
-    TraceProfiler::Instance().RecordEvent(
-        m_name, startUs, static_cast<std::uint64_t>(durUs), tid);
+    if (!m_active) {
+        return;
+    }
+    auto& profiler = TraceProfiler::Instance();
+    const auto endUs = profiler.NowSinceStartUs();
+    const auto durUs = endUs > m_beginUs ? endUs - m_beginUs : 0;
+    profiler.RecordEvent(m_scopeId, m_beginUs, durUs, profiler.CurrentThreadId());
 }
 
 } // namespace ui
-
@@ -2,6 +2,7 @@
 
 #include "ui_ids.h"
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <mutex>
@@ -10,15 +11,39 @@
 #include <unordered_map>
 #include <vector>
 
+// ---------------------------------
+// Compile-time trace levels
+// Scopes above UI_TRACE_LEVEL expand to nothing (no clock reads, no registration)
+// ---------------------------------
+
+#define UI_TRACE_LEVEL_OFF 0
+#define UI_TRACE_LEVEL_FRAME 1    // per-frame phases: Update, Sync, Render
+#define UI_TRACE_LEVEL_DETAIL 2   // sub-phases inside a frame
+#define UI_TRACE_LEVEL_VERBOSE 3  // per-item / per-task scopes in hot loops
+
+#ifndef UI_TRACE_LEVEL
+#define UI_TRACE_LEVEL UI_TRACE_LEVEL_DETAIL
+#endif
+
 namespace ui {
 
+// Static description of a trace scope, registered once per call site
+struct TraceScopeDescriptor {
+    const char* name = "";
+    const char* file = "";
+    int line = 0;
+    const char* category = "";
+};
+
 struct TraceEvent {
-    std::string name;
+    std::uint16_t scopeId = 0;   // index into the scope descriptor table
     std::uint64_t tsMicro = 0;   // begin timestamp (us, relative to session start)
     std::uint64_t durMicro = 0;  // duration in microseconds
     std::uint64_t tid = 0;
     bool isMetadata = false;
     std::string threadName; // only for metadata thread_name
+    bool isCounter = false;
+    std::int64_t counterValue = 0;  // only for counter events
 };
 
 class TraceProfiler {
@@ -28,11 +53,20 @@ public:
     void BeginSession(const std::string& path = "trace.json");
     void EndSession();
 
-    void RecordEvent(const char* name,
+    // Cheap check used by scopes to skip all work when nothing is recorded
+    bool IsSessionOpen() const { return m_sessionOpen.load(std::memory_order_relaxed); }
+
+    // Register a static scope descriptor; called once per call site
+    std::uint16_t RegisterScope(const char* name, const char* file, int line, const char* category);
+
+    void RecordEvent(std::uint16_t scopeId,
                      std::uint64_t startUs,
                      std::uint64_t durUs,
                      std::uint64_t tid);
 
+    // Counter sample ("ph":"C"); scopeId names the counter series
+    void RecordCounter(std::uint16_t scopeId, std::int64_t value);
+
     std::uint64_t NowSinceStartUs() const;
 
     // Register thread and emit thread_name metadata; returns internal tid
@@ -48,26 +82,73 @@ private:
 
     std::chrono::steady_clock::time_point m_sessionStart{};
     std::string m_filePath;
-    bool m_sessionOpen = false;
+    std::atomic<bool> m_sessionOpen{false};
 
     std::vector<TraceEvent> m_events;
     mutable std::mutex m_mutex;
 
+    std::vector<TraceScopeDescriptor> m_scopes;
+    std::mutex m_scopesMutex;
+
     std::unordered_map<std::thread::id, std::uint64_t> m_threadMap;
     std::uint64_t m_nextTid = 0;
 };
 
 class TraceScope {
 public:
-    explicit TraceScope(const char* name);
+    explicit TraceScope(std::uint16_t scopeId);
     ~TraceScope();
 
 private:
-    const char* m_name;
-    std::chrono::steady_clock::time_point m_begin;
+    std::uint16_t m_scopeId;
+    bool m_active;
+    std::uint64_t m_beginUs = 0;
 };
 
-#define TRACE_SCOPE(name_literal) ::ui::TraceScope trace_scope_guard_##__LINE__{name_literal}
-
 } // namespace ui
 
+#define UI_TRACE_CONCAT_IMPL(a, b) a##b
+#define UI_TRACE_CONCAT(a, b) UI_TRACE_CONCAT_IMPL(a, b)
+
+// Registers the descriptor on first execution (function-local static), then
+// records one event per scope instance while a session is open.
+#define UI_TRACE_SCOPE_IMPL(category, name_literal)                                        \
+    static const std::uint16_t UI_TRACE_CONCAT(trace_scope_id_, __LINE__) =                \
+        ::ui::TraceProfiler::Instance().RegisterScope(name_literal, __FILE__, __LINE__, category); \
+    ::ui::TraceScope UI_TRACE_CONCAT(trace_scope_guard_, __LINE__){UI_TRACE_CONCAT(trace_scope_id_, __LINE__)}
+
+#define UI_TRACE_NOOP() static_cast<void>(0)
+
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_FRAME
+#define TRACE_SCOPE_CAT(category, name_literal) UI_TRACE_SCOPE_IMPL(category, name_literal)
+#else
+#define TRACE_SCOPE_CAT(category, name_literal) UI_TRACE_NOOP()
+#endif
+
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_DETAIL
+#define TRACE_SCOPE_DETAIL_CAT(category, name_literal) UI_TRACE_SCOPE_IMPL(category, name_literal)
+#else
+#define TRACE_SCOPE_DETAIL_CAT(category, name_literal) UI_TRACE_NOOP()
+#endif
+
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_VERBOSE
+#define TRACE_SCOPE_VERBOSE_CAT(category, name_literal) UI_TRACE_SCOPE_IMPL(category, name_literal)
+#else
+#define TRACE_SCOPE_VERBOSE_CAT(category, name_literal) UI_TRACE_NOOP()
+#endif
+
+// Counter sample with a static series descriptor (frame level)
+#if UI_TRACE_LEVEL >= UI_TRACE_LEVEL_FRAME
+#define TRACE_COUNTER(name_literal, value)                                                      \
+    do {                                                                                        \
+        static const std::uint16_t trace_counter_id_ =                                          \
+            ::ui::TraceProfiler::Instance().RegisterScope(name_literal, __FILE__, __LINE__, "counter"); \
+        ::ui::TraceProfiler::Instance().RecordCounter(trace_counter_id_, static_cast<std::int64_t>(value)); \
+    } while (0)
+#else
+#define TRACE_COUNTER(name_literal, value) static_cast<void>(value)
+#endif
+
+#define TRACE_SCOPE(name_literal) TRACE_SCOPE_CAT("ui", name_literal)
+#define TRACE_SCOPE_DETAIL(name_literal) TRACE_SCOPE_DETAIL_CAT("ui", name_literal)
+#define TRACE_SCOPE_VERBOSE(name_literal) TRACE_SCOPE_VERBOSE_CAT("ui", name_literal)
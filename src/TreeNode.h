@@ -2,23 +2,32 @@
 
 #include "ui_ids.h"
 
+#include <cstdint>
+
 namespace ui {
 
-// Backend node (base)
+class RenderContext;
+
+// Backend node (base); writes go to the RenderContext that owns the node
 class TreeNode {
 public:
-    explicit TreeNode(NodeId id)
-        : m_id(id) {}
+    TreeNode(RenderContext& ctx, NodeId id)
+        : m_ctx(ctx)
+        , m_id(id) {}
 
     virtual ~TreeNode() = default;
 
     NodeId Id() const { return m_id; }
+    RenderContext& Context() const { return m_ctx; }
 
     virtual void SetPosition(float x, float y) = 0;
     virtual void SetVisible(bool v) = 0;
+    // Draw above (higher) or below siblings; applies to the whole subtree
+    virtual void SetLayer(std::int16_t layer) = 0;
     virtual void Term() = 0;
 
 protected:
+    RenderContext& m_ctx;
     NodeId m_id;
 };
 
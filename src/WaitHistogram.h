@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace ui {
+
+// Lock-free log2 histogram of wait times in microseconds.
+// Bucket 0 holds [0, 1) us, bucket i holds [2^(i-1), 2^i) us, the last
+// bucket collects everything above.
+class WaitHistogram {
+public:
+    static constexpr std::size_t kBucketCount = 24;
+
+    void Add(std::chrono::nanoseconds wait) {
+        const auto us = static_cast<std::uint64_t>(wait.count() / 1000);
+        std::size_t bucket = 0;
+        while (bucket + 1 < kBucketCount && (std::uint64_t{1} << bucket) <= us) {
+            ++bucket;
+        }
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_totalNs.fetch_add(static_cast<std::uint64_t>(wait.count()), std::memory_order_relaxed);
+
+        std::uint64_t max = m_maxNs.load(std::memory_order_relaxed);
+        const auto ns = static_cast<std::uint64_t>(wait.count());
+        while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Reset() {
+        for (auto& b : m_buckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_totalNs.store(0, std::memory_order_relaxed);
+        m_maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    std::uint64_t BucketCount(std::size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+    std::chrono::nanoseconds Total() const {
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(m_totalNs.load(std::memory_order_relaxed)));
+    }
+    std::chrono::nanoseconds Max() const {
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(m_maxNs.load(std::memory_order_relaxed)));
+    }
+
+    // Upper bound (us) of the bucket containing the p-th percentile
+    std::uint64_t PercentileUpperBoundUs(double p) const {
+        const std::uint64_t count = Count();
+        if (count == 0) {
+            return 0;
+        }
+        const auto target = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += BucketCount(i);
+            if (seen >= target) {
+                return std::uint64_t{1} << i;
+            }
+        }
+        return std::uint64_t{1} << (kBucketCount - 1);
+    }
+
+    // Multi-line text histogram, skipping empty leading/trailing buckets
+    std::string Format(const std::string& name) const {
+        std::ostringstream out;
+        const std::uint64_t count = Count();
+        out << name << ": n=" << count;
+        if (count == 0) {
+            out << "\n";
+            return out.str();
+        }
+        out << std::fixed << std::setprecision(1)
+            << " mean=" << static_cast<double>(Total().count()) / static_cast<double>(count) / 1000.0 << "us"
+            << " p50<=" << PercentileUpperBoundUs(50.0) << "us"
+            << " p99<=" << PercentileUpperBoundUs(99.0) << "us"
+            << " max=" << static_cast<double>(Max().count()) / 1000.0 << "us\n";
+
+        std::size_t first = kBucketCount;
+        std::size_t last = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            if (BucketCount(i) > 0) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        for (std::size_t i = first; i <= last; ++i) {
+            const std::uint64_t lo = i == 0 ? 0 : (std::uint64_t{1} << (i - 1));
+            const std::uint64_t n = BucketCount(i);
+            const auto bar = static_cast<std::size_t>(40.0 * static_cast<double>(n) / static_cast<double>(count) + 0.5);
+            out << "    [" << std::setw(8) << lo << ", " << std::setw(8) << (std::uint64_t{1} << i) << ") us "
+                << std::setw(8) << n << " " << std::string(bar, '#') << "\n";
+        }
+        return out.str();
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<std::uint64_t> m_count{0};
+    std::atomic<std::uint64_t> m_totalNs{0};
+    std::atomic<std::uint64_t> m_maxNs{0};
+};
+
+} // namespace ui
@@ -0,0 +1,177 @@
+// ui_compositor: draws the render tree another process publishes with
+// `ui_sandbox --stress --publish NAME` (see SharedRenderTree.h). It only
+// reads the shared frames, so the update process keeps running if this
+// one dies, and the other way round.
+
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "OpenGLRenderer.h"
+#include "RenderCommands.h"
+#include "SharedRenderTree.h"
+#include "TraceProfiler.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct CompositorConfig {
+    std::string name;
+    std::size_t frames = 0;        // 0 = until the publisher closes
+    double waitSeconds = 10.0;     // for the region to appear
+    bool render = false;
+    bool parallelCollect = false;
+    float viewportWidth = 0.0f;
+    float viewportHeight = 0.0f;
+};
+
+void PrintUsage() {
+    std::cout
+        << "Usage:\n"
+        << "  ui_compositor --name NAME [options]  draw the render tree published to NAME\n"
+        << "    --frames N         frames to draw, 0 = until the publisher exits (default 0)\n"
+        << "    --wait S           seconds to wait for the publisher (default 10)\n"
+        << "    --workers N        job system worker threads (default: cores - 1)\n"
+        << "    --parallel-collect collect render commands with subtree jobs\n"
+        << "    --viewport WxH     cull subtrees outside this area at the origin (default: none)\n"
+        << "    --render           submit to the OpenGL renderer (default headless)\n";
+}
+
+bool ParseArgs(int argc, char** argv, CompositorConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--name" && hasValue) {
+            config.name = argv[++i];
+        } else if (arg == "--frames" && hasValue) {
+            config.frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--wait" && hasValue) {
+            config.waitSeconds = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--workers" && hasValue) {
+            ui::JobSystem::SetDefaultWorkerCount(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--parallel-collect") {
+            config.parallelCollect = true;
+        } else if (arg == "--viewport" && hasValue) {
+            char* next = argv[++i];
+            config.viewportWidth = std::strtof(next, &next);
+            config.viewportHeight = (*next == 'x') ? std::strtof(next + 1, &next) : 0.0f;
+        } else if (arg == "--render") {
+            config.render = true;
+        } else {
+            return false;
+        }
+    }
+    return !config.name.empty();
+}
+
+int Run(const CompositorConfig& config) {
+    ui::SharedTreeReader reader;
+    const auto waitEnd = Clock::now() + std::chrono::duration<double>(config.waitSeconds);
+    while (!reader.Open(config.name)) {
+        if (Clock::now() >= waitEnd) {
+            std::cerr << "No published render tree: " << config.name << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ui::OpenGLRenderer renderer;
+    bool render = false;
+    if (config.render) {
+        render = renderer.Initialize(800, 600, "UI Sandbox - compositor");
+        if (!render) {
+            std::cerr << "Failed to initialize OpenGL renderer, running headless" << std::endl;
+        }
+    }
+
+    const ui::Bounds viewport = config.viewportWidth > 0.0f && config.viewportHeight > 0.0f
+        ? ui::Bounds::FromRect(0.0f, 0.0f, config.viewportWidth, config.viewportHeight)
+        : ui::Bounds::Infinite();
+    const ui::CollectMode mode = config.parallelCollect ? ui::CollectMode::Parallel : ui::CollectMode::Serial;
+
+    ui::FrameTimeStats collect;
+    ui::FrameTimeStats handoff;  // publish to collect start, across the processes
+    std::size_t frames = 0;
+    std::uint64_t skipped = 0;   // published frames never drawn
+    std::uint64_t sequence = 0;
+    std::size_t lastCommandCount = 0;
+    ui::RenderCommandList commands;
+    ui::SharedTreeView view;
+    const auto runBegin = Clock::now();
+    while (config.frames == 0 || frames < config.frames) {
+        if (render && renderer.ShouldClose()) {
+            break;
+        }
+        // Check before acquiring: a frame published before the close is still drawn
+        const bool closed = reader.Closed();
+        if (!reader.Acquire(sequence, view)) {
+            if (closed) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        TRACE_SCOPE("Compositor::Frame");
+        const auto begin = Clock::now();
+        handoff.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()) -
+                    std::chrono::nanoseconds(view.PublishNs()));
+        if (sequence != 0) {
+            skipped += view.Sequence() - sequence - 1;
+        }
+        sequence = view.Sequence();
+        ui::CollectRenderCommands(view, view.Root(), commands, mode, viewport);
+        reader.Release();
+        collect.Add(Clock::now() - begin);
+
+        if (render) {
+            renderer.ExecuteCommands(commands);
+            renderer.PollEvents();
+        }
+        lastCommandCount = commands.size();
+        ++frames;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - runBegin).count();
+    renderer.Shutdown();
+
+    std::cout << "compositor: " << frames << " frames in " << seconds << " s";
+    if (seconds > 0.0) {
+        std::cout << " (" << static_cast<double>(frames) / seconds << " frames/s)";
+    }
+    std::cout << ", " << skipped << " published frames skipped\n";
+    std::cout << "  last frame: " << lastCommandCount << " render commands (sequence " << sequence << ")\n";
+    std::cout << "  " << collect.Format("collect") << "\n";
+    std::cout << "  " << handoff.Format("handoff") << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    CompositorConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--help") == 0) {
+            PrintUsage();
+            return 0;
+        }
+    }
+    if (!ParseArgs(argc, argv, config)) {
+        PrintUsage();
+        return 2;
+    }
+
+    ui::TraceProfiler::Instance().BeginSession("compositor_trace.json");
+    ui::TraceProfiler::Instance().RegisterThread("compositor");
+    ui::JobSystem::Instance();
+
+    const int result = Run(config);
+
+    ui::TraceProfiler::Instance().EndSession();
+    return result;
+}
@@ -1,55 +1,486 @@
+#include "DisplayStream.h"
+#include "FramePipeline.h"
+#include "FrameScheduler.h"
+#include "JobSystem.h"
 #include "Movie.h"
+#include "MemoryStats.h"
+#include "OpenGLRenderer.h"
+#include "RenderContext.h"
+#include "ReplayDriver.h"
+#include "StressDriver.h"
 #include "TraceProfiler.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
-int main() {
-    ui::TraceProfiler::Instance().BeginSession("trace.json");
-    ui::TraceProfiler::Instance().RegisterThread("main");
+namespace {
+
+void PrintUsage() {
+    std::cout
+        << "Usage:\n"
+        << "  ui_sandbox                      interactive movie\n"
+        << "  ui_sandbox --stress [options]   synthetic load test\n"
+        << "  ui_sandbox --replay FILE [options] replay a capture as fast as possible\n"
+        << "  ui_sandbox --view SOCKET [options]  show a scene streamed with --stream\n"
+        << "  --workers N                     job system worker threads (default: cores - 1)\n"
+        << "    --nodes N          total nodes (default 10000)\n"
+        << "    --depth N          max tree depth (default 4)\n"
+        << "    --fanout N         children per container (default 16)\n"
+        << "    --mix C:T:R        container:text:rect weights (default 1:1:2)\n"
+        << "    --mutation-rate F  fraction of leaves moved per frame (default 0.05)\n"
+        << "    --churn-rate F     fraction of leaves recreated per frame (default 0)\n"
+        << "    --animated-rate F  fraction of leaves on looping render-side animations (default 0)\n"
+        << "    --interpolated-rate F fraction of leaves whose moves glide between Syncs (default 0)\n"
+        << "    --update-hz F      update rate, 0 = unthrottled (default 0)\n"
+        << "    --render-hz F      render rate, 0 = unthrottled (default 0)\n"
+        << "    --miss-policy P    skip | catchup when a paced frame overruns (default skip)\n"
+        << "    --frames N         update frames to run (default 600)\n"
+        << "    --seed N           scene / mutation seed (default 1)\n"
+        << "    --pipeline-depth N frames update may run ahead of render, 0 = free-running (default 1)\n"
+        << "    --parallel-collect collect render commands with subtree jobs\n"
+        << "    --sync-budget-us N      per-frame Sync time budget, rest deferred (default 0 = unlimited)\n"
+        << "    --sync-budget-changes N per-frame Sync change budget (default 0 = unlimited)\n"
+        << "    --scenes N         independent scenes, each in its own RenderContext (default 1)\n"
+        << "    --viewport WxH     cull subtrees outside this area at the origin (default: none)\n"
+        << "    --pick-hz F        hit-tests per second from an event thread, 0 = off (default 0)\n"
+        << "    --capture FILE     record every Sync of the run for --replay\n"
+        << "    --publish NAME     publish the render tree to shared memory for ui_compositor\n"
+        << "    --publish-mb N     size of one published frame slot (default 64)\n"
+        << "    --stream SOCKET    stream every Sync to a --view viewer on this Unix socket\n"
+        << "    --keyframe-interval N Syncs between stream keyframes, 0 = only when needed (default 120)\n"
+        << "    --render           submit to the OpenGL renderer (default headless)\n"
+        << "  replay options: --snapshot FILE (state the capture started from), --parallel-collect,\n"
+        << "    --viewport WxH, --render\n"
+        << "  view options: --frames N (0 = until the stream ends), --parallel-collect, --viewport WxH, --render\n";
+}
+
+bool ParseStressArgs(int argc, char** argv, ui::StressConfig& config, std::size_t& scenes, bool& render) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--stress") {
+            continue;
+        } else if (arg == "--workers" && hasValue) {
+            ++i; // handled in main()
+        } else if (arg == "--render") {
+            render = true;
+        } else if (arg == "--miss-policy" && hasValue) {
+            const std::string policy = argv[++i];
+            if (policy != "skip" && policy != "catchup") {
+                return false;
+            }
+            config.missPolicy = policy == "skip" ? ui::MissPolicy::Skip : ui::MissPolicy::CatchUp;
+        } else if (arg == "--scenes" && hasValue) {
+            scenes = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--parallel-collect") {
+            config.parallelCollect = true;
+        } else if (arg == "--viewport" && hasValue) {
+            char* next = argv[++i];
+            config.viewportWidth = std::strtof(next, &next);
+            config.viewportHeight = (*next == 'x') ? std::strtof(next + 1, &next) : 0.0f;
+        } else if (arg == "--pick-hz" && hasValue) {
+            config.pickHz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--sync-budget-us" && hasValue) {
+            config.syncBudget = std::chrono::microseconds(std::strtoll(argv[++i], nullptr, 10));
+        } else if (arg == "--sync-budget-changes" && hasValue) {
+            config.syncBudgetChanges = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--nodes" && hasValue) {
+            config.nodeCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--depth" && hasValue) {
+            config.maxDepth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--fanout" && hasValue) {
+            config.fanout = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--mix" && hasValue) {
+            char* next = argv[++i];
+            config.containerWeight = std::strtof(next, &next);
+            config.textWeight = (*next == ':') ? std::strtof(next + 1, &next) : 0.0f;
+            config.rectWeight = (*next == ':') ? std::strtof(next + 1, &next) : 0.0f;
+        } else if (arg == "--mutation-rate" && hasValue) {
+            config.mutationRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--churn-rate" && hasValue) {
+            config.churnRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--animated-rate" && hasValue) {
+            config.animatedRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--interpolated-rate" && hasValue) {
+            config.interpolatedRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--update-hz" && hasValue) {
+            config.updateHz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--render-hz" && hasValue) {
+            config.renderHz = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--frames" && hasValue) {
+            config.frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--pipeline-depth" && hasValue) {
+            config.pipelineDepth = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--capture" && hasValue) {
+            config.capturePath = argv[++i];
+        } else if (arg == "--publish" && hasValue) {
+            config.publishName = argv[++i];
+        } else if (arg == "--publish-mb" && hasValue) {
+            config.publishSlotBytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--stream" && hasValue) {
+            config.streamPath = argv[++i];
+        } else if (arg == "--keyframe-interval" && hasValue) {
+            config.keyframeInterval = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && hasValue) {
+            config.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int RunStress(int argc, char** argv) {
+    ui::StressConfig config;
+    std::size_t scenes = 1;
+    bool render = false;
+    if (!ParseStressArgs(argc, argv, config, scenes, render)) {
+        PrintUsage();
+        return 2;
+    }
+
+    ui::OpenGLRenderer renderer;
+    ui::StressDriver::SubmitFn submit;
+    if (render) {
+        if (renderer.Initialize(800, 600, "UI Sandbox - stress")) {
+            submit = [&renderer](const ui::RenderCommandList& commands) { renderer.ExecuteCommands(commands); };
+        } else {
+            std::cerr << "Failed to initialize OpenGL renderer, running headless" << std::endl;
+        }
+    }
+
+    if (scenes == 1) {
+        ui::StressDriver driver(config);
+        ui::StressReport report = driver.Run(submit);
+        renderer.Shutdown();
+
+        std::cout << report.Format();
+        return 0;
+    }
+
+    // Isolated UIs: each scene syncs and renders on its own threads and
+    // context; only the first one is presented
+    std::vector<std::unique_ptr<ui::RenderContext>> contexts;
+    std::vector<ui::StressReport> reports(scenes);
+    std::vector<std::thread> drivers;
+    for (std::size_t i = 0; i < scenes; ++i) {
+        contexts.push_back(std::make_unique<ui::RenderContext>());
+    }
+    for (std::size_t i = 0; i < scenes; ++i) {
+        drivers.emplace_back([&, i]() {
+            ui::StressConfig sceneConfig = config;
+            sceneConfig.seed = config.seed + static_cast<std::uint32_t>(i);
+            if (i > 0) {
+                sceneConfig.capturePath.clear();  // the first scene's only
+                sceneConfig.publishName.clear();
+                sceneConfig.streamPath.clear();
+            }
+            ui::StressDriver driver(sceneConfig, *contexts[i]);
+            reports[i] = driver.Run(i == 0 ? submit : ui::StressDriver::SubmitFn{});
+        });
+    }
+    for (auto& driver : drivers) {
+        driver.join();
+    }
+    renderer.Shutdown();
+
+    for (std::size_t i = 0; i < scenes; ++i) {
+        std::cout << "scene " << i << ":\n" << reports[i].Format();
+    }
+    return 0;
+}
+
+bool ParseReplayArgs(int argc, char** argv, std::string& path, std::string& snapshotPath, ui::ReplayConfig& config,
+                     bool& render) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--replay" && hasValue) {
+            path = argv[++i];
+        } else if (arg == "--workers" && hasValue) {
+            ++i; // handled in main()
+        } else if (arg == "--snapshot" && hasValue) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--parallel-collect") {
+            config.parallelCollect = true;
+        } else if (arg == "--viewport" && hasValue) {
+            char* next = argv[++i];
+            config.viewportWidth = std::strtof(next, &next);
+            config.viewportHeight = (*next == 'x') ? std::strtof(next + 1, &next) : 0.0f;
+        } else if (arg == "--render") {
+            render = true;
+        } else {
+            return false;
+        }
+    }
+    return !path.empty();
+}
+
+int RunReplay(int argc, char** argv) {
+    std::string path;
+    std::string snapshotPath;
+    ui::ReplayConfig config;
+    bool render = false;
+    if (!ParseReplayArgs(argc, argv, path, snapshotPath, config, render)) {
+        PrintUsage();
+        return 2;
+    }
+
+    ui::ChangeReplay replay;
+    if (!replay.Open(path)) {
+        std::cerr << "Not a complete capture: " << path << std::endl;
+        return 1;
+    }
+    auto& ctx = ui::RenderContext::Instance();
+    ui::NodeId snapshotRoot = 0;
+    if (!snapshotPath.empty() && !ctx.LoadSnapshot(snapshotPath, snapshotRoot)) {
+        std::cerr << "Cannot load snapshot: " << snapshotPath << std::endl;
+        return 1;
+    }
+
+    ui::OpenGLRenderer renderer;
+    ui::ReplayDriver::SubmitFn submit;
+    if (render) {
+        if (renderer.Initialize(800, 600, "UI Sandbox - replay")) {
+            submit = [&renderer](const ui::RenderCommandList& commands) { renderer.ExecuteCommands(commands); };
+        } else {
+            std::cerr << "Failed to initialize OpenGL renderer, running headless" << std::endl;
+        }
+    }
+
+    ui::ReplayReport report = ui::ReplayDriver(replay, ctx, config).Run(submit);
+    renderer.Shutdown();
+    std::cout << report.Format();
+    return report.complete ? 0 : 1;
+}
+
+struct ViewConfig {
+    std::string path;
+    std::size_t frames = 0;  // 0 = until the stream ends
+    bool parallelCollect = false;
+    float viewportWidth = 0.0f;
+    float viewportHeight = 0.0f;
+    bool render = false;
+};
+
+bool ParseViewArgs(int argc, char** argv, ViewConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--view" && hasValue) {
+            config.path = argv[++i];
+        } else if (arg == "--workers" && hasValue) {
+            ++i; // handled in main()
+        } else if (arg == "--frames" && hasValue) {
+            config.frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--parallel-collect") {
+            config.parallelCollect = true;
+        } else if (arg == "--viewport" && hasValue) {
+            char* next = argv[++i];
+            config.viewportWidth = std::strtof(next, &next);
+            config.viewportHeight = (*next == 'x') ? std::strtof(next + 1, &next) : 0.0f;
+        } else if (arg == "--render") {
+            config.render = true;
+        } else {
+            return false;
+        }
+    }
+    return !config.path.empty();
+}
+
+// Mirrors a --stream scene: applies each message as it arrives, then
+// collects and draws the viewer's copy of the tree
+int RunView(int argc, char** argv) {
+    ViewConfig config;
+    if (!ParseViewArgs(argc, argv, config)) {
+        PrintUsage();
+        return 2;
+    }
+
+    ui::DisplayViewer viewer;
+    const auto waitEnd = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!viewer.Connect(config.path)) {
+        if (std::chrono::steady_clock::now() >= waitEnd) {
+            std::cerr << "Nothing streams on " << config.path << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ui::OpenGLRenderer renderer;
+    bool render = false;
+    if (config.render) {
+        render = renderer.Initialize(800, 600, "UI Sandbox - view");
+        if (!render) {
+            std::cerr << "Failed to initialize OpenGL renderer, running headless" << std::endl;
+        }
+    }
+
+    const ui::Bounds viewport = config.viewportWidth > 0.0f && config.viewportHeight > 0.0f
+        ? ui::Bounds::FromRect(0.0f, 0.0f, config.viewportWidth, config.viewportHeight)
+        : ui::Bounds::Infinite();
+    const ui::CollectMode mode = config.parallelCollect ? ui::CollectMode::Parallel : ui::CollectMode::Serial;
+
+    ui::FrameTimeStats collect;
+    std::size_t frames = 0;
+    ui::RenderCommandList commands;
+    const auto runBegin = std::chrono::steady_clock::now();
+    bool connected = true;
+    while (connected && (config.frames == 0 || frames < config.frames)) {
+        if (render && renderer.ShouldClose()) {
+            break;
+        }
+        const std::uint64_t before = viewer.Messages();
+        connected = viewer.Poll(std::chrono::milliseconds(16));
+        ui::RenderContext* ctx = viewer.Context();
+        if (!ctx || (viewer.Messages() == before && ctx->RunningAnimations() == 0)) {
+            continue;
+        }
+
+        const auto collectBegin = std::chrono::steady_clock::now();
+        {
+            auto lock = ctx->LockForRender();
+            if (ctx->RunningAnimations() > 0) {
+                ctx->AdvanceAnimations(collectBegin);
+            }
+            ui::CollectRenderCommands(*ctx, viewer.Root(), commands, mode, viewport);
+        }
+        collect.Add(std::chrono::steady_clock::now() - collectBegin);
+        if (render) {
+            renderer.ExecuteCommands(commands);
+            renderer.PollEvents();
+        }
+        ui::MemoryStats::Instance().EndFrame();
+        ++frames;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runBegin).count();
+    renderer.Shutdown();
 
+    std::cout << "view: " << frames << " frames in " << seconds << " s, " << viewer.Messages() << " messages ("
+              << viewer.Keyframes() << " keyframes), " << viewer.BytesReceived() << " B received\n";
+    std::cout << "  last frame: " << commands.size() << " render commands (sequence " << viewer.Sequence() << ")\n";
+    std::cout << "  " << collect.Format("collect") << "\n";
+    return 0;
+}
+
+int RunMovie() {
     ui::Movie movie;
     std::atomic<bool> running{true};
 
+    // Update builds frame N+1 while render presents frame N
+    ui::FramePipeline pipeline(1);
+
     // Update thread
     std::thread updateThread([&]() {
         ui::TraceProfiler::Instance().RegisterThread("update");
+        ui::FrameSchedulerConfig schedule;
+        schedule.hz = 1.0;  // update: 1 Hz
+        schedule.missedCounterName = "movie.update.missed";
+        ui::FrameScheduler scheduler(schedule);
         while (running && movie.IsRunning()) {
+            const ui::FrameId frame = pipeline.BeginUpdate();
+            if (frame == 0) {
+                break;
+            }
             movie.Update();
-            std::this_thread::sleep_for(std::chrono::seconds(1)); // update: 1 Hz
+            pipeline.PublishFrame(frame);
+            scheduler.WaitForNextFrame();
         }
     });
 
-    // Render thread
+    // Render thread: paced at its own rate, so animations and the label's
+    // glide advance between updates; presents the newest frame, or the last
+    // one again when nothing new was published
     std::thread renderThread([&]() {
         ui::TraceProfiler::Instance().RegisterThread("render");
-        while (running && movie.IsRunning()) {
-            movie.Render();
-            std::this_thread::sleep_for(std::chrono::milliseconds(500)); // render: 2 Hz
+        ui::FrameSchedulerConfig schedule;
+        schedule.hz = 60.0;  // render: 60 Hz (the simulated collect cost caps it lower)
+        schedule.missedCounterName = "movie.render.missed";
+        ui::FrameScheduler scheduler(schedule);
+        ui::FrameId presented = 0;
+        while (running && movie.IsRunning() && !pipeline.IsStopped()) {
+            const ui::FrameId frame = pipeline.TryAcquireRenderFrame();
+            if (frame != 0) {
+                movie.Render(frame);
+                pipeline.ReleaseRenderFrame(frame);
+                presented = frame;
+            } else if (presented != 0) {
+                movie.Render(presented);
+            }
+            scheduler.WaitForNextFrame();
         }
     });
 
     // Main thread: process window events (required on macOS)
+    ui::FrameSchedulerConfig eventSchedule;
+    eventSchedule.hz = 60.0;
+    ui::FrameScheduler eventScheduler(eventSchedule);
     auto startTime = std::chrono::steady_clock::now();
     while (running && movie.IsRunning()) {
         movie.ProcessEvents();
-        
+
         // Check if 5 seconds have passed
         auto elapsed = std::chrono::steady_clock::now() - startTime;
         if (std::chrono::duration_cast<std::chrono::seconds>(elapsed).count() >= 15) {
             running = false;
             break;
         }
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 Hz for event processing
+
+        eventScheduler.WaitForNextFrame();
     }
 
     movie.Stop();
+    pipeline.Stop();
 
     updateThread.join();
     renderThread.join();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool stress = false;
+    bool replay = false;
+    bool view = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stress") == 0) {
+            stress = true;
+        } else if (std::strcmp(argv[i], "--replay") == 0) {
+            replay = true;
+        } else if (std::strcmp(argv[i], "--view") == 0) {
+            view = true;
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            ui::JobSystem::SetDefaultWorkerCount(std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            PrintUsage();
+            return 0;
+        }
+    }
+
+    ui::TraceProfiler::Instance().BeginSession("trace.json");
+    ui::TraceProfiler::Instance().RegisterThread("main");
+
+    // Start workers inside the session so their thread names are recorded
+    ui::JobSystem::Instance();
+
+    const int result = view ? RunView(argc, argv)
+        : replay ? RunReplay(argc, argv)
+        : stress ? RunStress(argc, argv)
+        : RunMovie();
 
     ui::TraceProfiler::Instance().EndSession();
-    return 0;
+
+    std::cout << ui::MemoryStats::Instance().Report();
+    std::cout << ui::RenderContext::Instance().SyncLockWaits().Format("render mutex wait (Sync)");
+    std::cout << ui::RenderContext::Instance().RenderLockWaits().Format("render mutex wait (Render)");
+    return result;
 }